@@ -27,6 +27,7 @@
 #include <osinfo/osinfo_enum_types.h>
 #include <osinfo/osinfo_entity.h>
 #include <osinfo/osinfo_filter.h>
+#include <osinfo/osinfo_expressionfilter.h>
 #include <osinfo/osinfo_list.h>
 #include <osinfo/osinfo_device.h>
 #include <osinfo/osinfo_device_driver.h>
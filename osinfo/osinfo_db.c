@@ -20,6 +20,12 @@
 
 #include <osinfo/osinfo.h>
 #include "osinfo_media_private.h"
+#include "osinfo_os_private.h"
+#include "osinfo_entity_private.h"
+#include "osinfo_expressionfilter_private.h"
+#include "osinfo_filter_private.h"
+#include "osinfo_list_private.h"
+#include "osinfo_product_private.h"
 #include <gio/gio.h>
 #include <string.h>
 #include <glib/gi18n-lib.h>
@@ -119,6 +125,40 @@ static void set_languages_for_media(OsinfoDb *db, OsinfoMedia *media,
  * metadata is recorded.
  */
 
+/*
+ * Lookup indexes are built lazily, since the loader adds an entity to the
+ * database before parsing any of its properties. The serial of every
+ * indexed entity is recorded, so a later change to an entity is noticed
+ * before the index is trusted to answer. The database generation avoids
+ * checking every serial when no entity at all was modified.
+ */
+typedef struct _OsinfoDbIndex OsinfoDbIndex;
+
+typedef void (*OsinfoDbIndexKeysFunc)(OsinfoDbIndex *index,
+                                      OsinfoEntity *entity,
+                                      GPtrArray *keys);
+
+struct _OsinfoDbIndex
+{
+    OsinfoDbIndexKeysFunc keys_func;
+    /* The property whose values are the keys, if any */
+    gchar *property;
+    /* key -> GPtrArray of OsinfoEntity, in list order */
+    GHashTable *entities;
+    /* OsinfoEntity -> entity serial when the index was built */
+    GHashTable *serials;
+    /* Tracks the changes of the indexed entities */
+    OsinfoEntityDomain *domain;
+    /* Generation of domain the serials were last checked against */
+    guint generation;
+    /* Sorted interned keys, computed on demand */
+    GList *values;
+    /* key -> GObject the key refers to, if recorded by keys_func */
+    GHashTable *objects;
+    /* The keys of objects, in the order they were first recorded */
+    GPtrArray *object_keys;
+};
+
 struct _OsinfoDbPrivate
 {
     OsinfoDeviceList *devices;
@@ -127,10 +167,863 @@ struct _OsinfoDbPrivate
     OsinfoDeploymentList *deployments;
     OsinfoDatamapList *datamaps;
     OsinfoInstallScriptList *scripts;
+
+    /* Tracks the changes of the entities of the database */
+    OsinfoEntityDomain *domain;
+
+    /* Protects the indexes below */
+    GMutex index_lock;
+    /* Bumped whenever entities are added to one of the lists above */
+    guint version;
+    /* property name -> OsinfoDbIndex of its values, for each list */
+    GHashTable *os_properties;
+    GHashTable *platform_properties;
+    GHashTable *device_properties;
+    GHashTable *deployment_properties;
+    OsinfoDbIndex device_ids;
+    /* "relationship\ntarget-id" -> products with that relationship */
+    OsinfoDbIndex os_relationships;
+    OsinfoDbIndex platform_relationships;
+    /* "os-id\nplatform-id" -> OsinfoDeployment, first deployment wins */
+    GHashTable *deployment_ids;
+    /* device-id -> GPtrArray of OsinfoOs/OsinfoPlatform supporting it */
+    GHashTable *device_oses;
+    GHashTable *device_platforms;
+    /* device-id -> GPtrArray of OsinfoOs explicitly not supporting it */
+    GHashTable *device_unsupported_oses;
+    /* Database generation the device support tables were built at */
+    guint device_support_generation;
+    /* OsinfoDbSupportPeriod of every OS, sorted by release and by EOL */
+    GArray *os_by_release;
+    GArray *os_by_eol;
+    /* Database generation the support periods were built at */
+    guint os_periods_generation;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE(OsinfoDb, osinfo_db, G_TYPE_OBJECT);
 
+static void osinfo_db_index_clear(OsinfoDbIndex *index)
+{
+    g_clear_pointer(&index->entities, g_hash_table_unref);
+    g_clear_pointer(&index->serials, g_hash_table_unref);
+    g_clear_pointer(&index->values, g_list_free);
+    g_clear_pointer(&index->object_keys, g_ptr_array_unref);
+    g_clear_pointer(&index->objects, g_hash_table_unref);
+}
+
+static void osinfo_db_index_build(OsinfoDbIndex *index, OsinfoList *list)
+{
+    GPtrArray *keys = g_ptr_array_new_with_free_func(g_free);
+    gint i;
+
+    osinfo_db_index_clear(index);
+
+    index->generation = osinfo_entity_domain_get_generation(index->domain);
+    index->entities = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                            g_free,
+                                            (GDestroyNotify)g_ptr_array_unref);
+    index->serials = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                           g_object_unref, NULL);
+
+    for (i = 0; i < osinfo_list_get_length(list); i++) {
+        OsinfoEntity *entity = osinfo_list_get_nth(list, i);
+        guint j;
+
+        /* Read the serial first: a concurrent change then marks it stale */
+        g_hash_table_insert(index->serials, g_object_ref(entity),
+                            GUINT_TO_POINTER(osinfo_entity_get_serial(entity)));
+
+        index->keys_func(index, entity, keys);
+        for (j = 0; j < keys->len; j++) {
+            GPtrArray *entities = g_hash_table_lookup(index->entities,
+                                                      keys->pdata[j]);
+
+            if (entities == NULL) {
+                entities = g_ptr_array_new();
+                g_hash_table_insert(index->entities,
+                                    g_strdup(keys->pdata[j]), entities);
+            } else if (entities->pdata[entities->len - 1] == entity) {
+                /* The same value set twice on the entity */
+                continue;
+            }
+            g_ptr_array_add(entities, entity);
+        }
+        g_ptr_array_set_size(keys, 0);
+    }
+
+    g_ptr_array_unref(keys);
+}
+
+static gboolean osinfo_db_index_is_current(OsinfoDbIndex *index,
+                                           OsinfoEntity *entity)
+{
+    gpointer serial;
+
+    if (!g_hash_table_lookup_extended(index->serials, entity, NULL, &serial))
+        return FALSE;
+
+    return GPOINTER_TO_UINT(serial) == osinfo_entity_get_serial(entity);
+}
+
+static gboolean osinfo_db_index_is_stale(OsinfoDbIndex *index,
+                                         OsinfoList *list)
+{
+    guint generation = osinfo_entity_domain_get_generation(index->domain);
+    gint i;
+
+    if (osinfo_list_get_length(list) != g_hash_table_size(index->serials))
+        return TRUE;
+
+    if (index->generation == generation)
+        return FALSE;
+
+    for (i = 0; i < osinfo_list_get_length(list); i++) {
+        if (!osinfo_db_index_is_current(index, osinfo_list_get_nth(list, i)))
+            return TRUE;
+    }
+
+    /* Entities outside of the index changed, skip the check next time */
+    index->generation = generation;
+    return FALSE;
+}
+
+/* Must be called with index_lock held */
+static void osinfo_db_index_refresh(OsinfoDbIndex *index, OsinfoList *list)
+{
+    if (index->entities == NULL || osinfo_db_index_is_stale(index, list))
+        osinfo_db_index_build(index, list);
+}
+
+/*
+ * Returns the first entity of @list with @key. Must be called with
+ * index_lock held.
+ */
+static OsinfoEntity *osinfo_db_index_lookup(OsinfoDbIndex *index,
+                                            OsinfoList *list,
+                                            const gchar *key)
+{
+    GPtrArray *entities;
+
+    /*
+     * Even a hit on an unchanged entity needs the index to be current,
+     * as an entity earlier in the list may have gained the key since.
+     */
+    osinfo_db_index_refresh(index, list);
+
+    entities = g_hash_table_lookup(index->entities, key);
+    return entities ? entities->pdata[0] : NULL;
+}
+
+/*
+ * Returns all the entities of @list with @key, or NULL if there are none.
+ * Must be called with index_lock held.
+ */
+static GPtrArray *osinfo_db_index_lookup_all(OsinfoDbIndex *index,
+                                             OsinfoList *list,
+                                             const gchar *key)
+{
+    osinfo_db_index_refresh(index, list);
+
+    return g_hash_table_lookup(index->entities, key);
+}
+
+static void osinfo_db_index_free(gpointer opaque)
+{
+    OsinfoDbIndex *index = opaque;
+
+    osinfo_db_index_clear(index);
+    g_free(index->property);
+    g_free(index);
+}
+
+static void osinfo_db_property_keys(OsinfoDbIndex *index,
+                                    OsinfoEntity *entity,
+                                    GPtrArray *keys)
+{
+    GList *values;
+    GList *tmp;
+
+    values = osinfo_entity_get_param_value_list(entity, index->property);
+    for (tmp = values; tmp; tmp = tmp->next)
+        g_ptr_array_add(keys, g_strdup(tmp->data));
+    g_list_free(values);
+}
+
+/* Must be called with index_lock held */
+static OsinfoDbIndex *osinfo_db_get_property_index(GHashTable *properties,
+                                                   OsinfoEntityDomain *domain,
+                                                   const gchar *property)
+{
+    OsinfoDbIndex *index = g_hash_table_lookup(properties, property);
+
+    if (index == NULL) {
+        index = g_new0(OsinfoDbIndex, 1);
+        index->keys_func = osinfo_db_property_keys;
+        index->domain = domain;
+        index->property = g_strdup(property);
+        g_hash_table_insert(properties, index->property, index);
+    }
+
+    return index;
+}
+
+static GHashTable *osinfo_db_property_indexes_new(void)
+{
+    return g_hash_table_new_full(g_str_hash, g_str_equal,
+                                 NULL, osinfo_db_index_free);
+}
+
+/*
+ * Lists handed out by the database answer osinfo_list_add_filtered()
+ * from the property indexes, as long as neither the list nor the
+ * database gained entities since.
+ */
+typedef struct _OsinfoDbListFilterData OsinfoDbListFilterData;
+struct _OsinfoDbListFilterData
+{
+    GWeakRef db;
+    OsinfoList *entities;
+    GHashTable *properties;
+    OsinfoEntityDomain *domain;
+    guint version;
+    /* OsinfoEntity -> its position in entities, computed on demand */
+    GHashTable *positions;
+};
+
+static void osinfo_db_list_filter_data_free(gpointer opaque)
+{
+    OsinfoDbListFilterData *data = opaque;
+
+    g_weak_ref_clear(&data->db);
+    g_clear_pointer(&data->positions, g_hash_table_unref);
+    g_free(data);
+}
+
+static gint osinfo_db_plan_position_cmp(gconstpointer a,
+                                        gconstpointer b,
+                                        gpointer opaque)
+{
+    GHashTable *positions = opaque;
+    gint apos = GPOINTER_TO_INT(g_hash_table_lookup(positions, *(gpointer *)a));
+    gint bpos = GPOINTER_TO_INT(g_hash_table_lookup(positions, *(gpointer *)b));
+
+    return apos < bpos ? -1 : apos > bpos;
+}
+
+/*
+ * Turns a set of entities into an array in list order. Must be called
+ * with index_lock held.
+ */
+static GPtrArray *osinfo_db_plan_collect(OsinfoDbListFilterData *data,
+                                         GHashTable *set)
+{
+    GPtrArray *entities = g_ptr_array_sized_new(g_hash_table_size(set));
+    GHashTableIter iter;
+    gpointer entity;
+
+    if (data->positions == NULL) {
+        gint i;
+
+        data->positions = g_hash_table_new(g_direct_hash, g_direct_equal);
+        for (i = 0; i < osinfo_list_get_length(data->entities); i++)
+            g_hash_table_insert(data->positions,
+                                osinfo_list_get_nth(data->entities, i),
+                                GINT_TO_POINTER(i));
+    }
+
+    g_hash_table_iter_init(&iter, set);
+    while (g_hash_table_iter_next(&iter, &entity, NULL))
+        g_ptr_array_add(entities, entity);
+    g_ptr_array_sort_with_data(entities, osinfo_db_plan_position_cmp,
+                               data->positions);
+
+    return entities;
+}
+
+/* Keeps the smaller of two candidate arrays, NULL standing for all */
+static GPtrArray *osinfo_db_plan_smallest(GPtrArray *a, GPtrArray *b)
+{
+    if (a == NULL)
+        return b;
+    if (b == NULL)
+        return a;
+
+    if (b->len < a->len) {
+        g_ptr_array_unref(a);
+        return b;
+    }
+    g_ptr_array_unref(b);
+    return a;
+}
+
+/*
+ * Returns the entities having the least common value required by the
+ * property constraints of @filter, or NULL if it has none. Must be
+ * called with index_lock held.
+ */
+static GPtrArray *osinfo_db_plan_constraints(OsinfoDbListFilterData *data,
+                                             OsinfoFilter *filter)
+{
+    GPtrArray *candidates = NULL;
+    const OsinfoFilterConstraint *constraints;
+    gsize nconstraints;
+    gsize i, j;
+
+    constraints = osinfo_filter_get_compiled_constraints(filter, &nconstraints);
+
+    for (i = 0; i < nconstraints; i++) {
+        OsinfoDbIndex *index =
+            osinfo_db_get_property_index(data->properties, data->domain,
+                                         constraints[i].key);
+
+        for (j = 0; j < constraints[i].nvalues; j++) {
+            GPtrArray *entities = osinfo_db_index_lookup_all(index,
+                                                             data->entities,
+                                                             constraints[i].values[j]);
+
+            candidates = osinfo_db_plan_smallest(candidates,
+                                                 entities ? g_ptr_array_ref(entities) :
+                                                 g_ptr_array_new());
+        }
+    }
+
+    return candidates;
+}
+
+/*
+ * Returns the entities with a value satisfying the COMPARE node @filter.
+ * Other operators than equality are checked against each distinct value
+ * of the property rather than against each entity. Must be called with
+ * index_lock held.
+ */
+static GPtrArray *osinfo_db_plan_compare(OsinfoDbListFilterData *data,
+                                         OsinfoExpressionFilter *filter)
+{
+    OsinfoDbIndex *index =
+        osinfo_db_get_property_index(data->properties, data->domain,
+                                     osinfo_expressionfilter_get_property(filter));
+    GPtrArray *candidates;
+    GHashTable *set;
+    GHashTableIter iter;
+    gpointer key, value;
+
+    if (osinfo_expressionfilter_get_operator(filter) ==
+        OSINFO_EXPRESSION_FILTER_OPERATOR_EQUAL) {
+        GPtrArray *entities =
+            osinfo_db_index_lookup_all(index, data->entities,
+                                       osinfo_expressionfilter_get_value(filter));
+
+        return entities ? g_ptr_array_ref(entities) : g_ptr_array_new();
+    }
+
+    osinfo_db_index_refresh(index, data->entities);
+
+    set = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_hash_table_iter_init(&iter, index->entities);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        GPtrArray *entities = value;
+        guint i;
+
+        if (!osinfo_expressionfilter_compare_value(filter, key))
+            continue;
+
+        for (i = 0; i < entities->len; i++)
+            g_hash_table_add(set, entities->pdata[i]);
+    }
+
+    candidates = osinfo_db_plan_collect(data, set);
+    g_hash_table_unref(set);
+    return candidates;
+}
+
+static GPtrArray *osinfo_db_plan_filter(OsinfoDbListFilterData *data,
+                                        OsinfoFilter *filter);
+
+/* Must be called with index_lock held */
+static GPtrArray *osinfo_db_plan_expression(OsinfoDbListFilterData *data,
+                                            OsinfoExpressionFilter *filter)
+{
+    OsinfoFilter *left, *right;
+    GPtrArray *lcandidates, *rcandidates;
+    GHashTable *set;
+    guint i;
+
+    switch (osinfo_expressionfilter_get_kind(filter)) {
+    case OSINFO_EXPRESSION_FILTER_KIND_COMPARE:
+        return osinfo_db_plan_compare(data, filter);
+
+    case OSINFO_EXPRESSION_FILTER_KIND_AND:
+        osinfo_expressionfilter_get_operands(filter, &left, &right);
+        return osinfo_db_plan_smallest(osinfo_db_plan_filter(data, left),
+                                       osinfo_db_plan_filter(data, right));
+
+    case OSINFO_EXPRESSION_FILTER_KIND_OR:
+        /* Either branch may match any entity unless both are narrowed */
+        osinfo_expressionfilter_get_operands(filter, &left, &right);
+        if (!(lcandidates = osinfo_db_plan_filter(data, left)))
+            return NULL;
+        if (!(rcandidates = osinfo_db_plan_filter(data, right))) {
+            g_ptr_array_unref(lcandidates);
+            return NULL;
+        }
+
+        set = g_hash_table_new(g_direct_hash, g_direct_equal);
+        for (i = 0; i < lcandidates->len; i++)
+            g_hash_table_add(set, lcandidates->pdata[i]);
+        for (i = 0; i < rcandidates->len; i++)
+            g_hash_table_add(set, rcandidates->pdata[i]);
+        g_ptr_array_unref(lcandidates);
+        g_ptr_array_unref(rcandidates);
+
+        lcandidates = osinfo_db_plan_collect(data, set);
+        g_hash_table_unref(set);
+        return lcandidates;
+
+    case OSINFO_EXPRESSION_FILTER_KIND_NOT:
+        return NULL;
+
+    default:
+        break;
+    }
+
+    g_return_val_if_reached(NULL);
+}
+
+/*
+ * Returns the entities of the list which may match @filter, in list
+ * order, or NULL if the indexes cannot tell. Only the filter types whose
+ * matching is known are planned. Must be called with index_lock held.
+ */
+static GPtrArray *osinfo_db_plan_filter(OsinfoDbListFilterData *data,
+                                        OsinfoFilter *filter)
+{
+    GType type = G_OBJECT_TYPE(filter);
+
+    if (type == OSINFO_TYPE_FILTER || type == OSINFO_TYPE_PRODUCTFILTER)
+        return osinfo_db_plan_constraints(data, filter);
+
+    if (type == OSINFO_TYPE_EXPRESSIONFILTER)
+        return osinfo_db_plan_smallest(osinfo_db_plan_constraints(data, filter),
+                                       osinfo_db_plan_expression(data,
+                                                                 OSINFO_EXPRESSIONFILTER(filter)));
+
+    return NULL;
+}
+
+static gboolean osinfo_db_list_filter(OsinfoList *list,
+                                      OsinfoList *source,
+                                      OsinfoFilter *filter,
+                                      gpointer opaque)
+{
+    OsinfoDbListFilterData *data = opaque;
+    OsinfoDb *db;
+    GPtrArray *plan = NULL;
+    GPtrArray *candidates = NULL;
+    guint i;
+
+    if (!OSINFO_IS_FILTER(filter))
+        return FALSE;
+
+    if (!(db = g_weak_ref_get(&data->db)))
+        return FALSE;
+
+    g_mutex_lock(&db->priv->index_lock);
+
+    if (db->priv->version == data->version &&
+        (plan = osinfo_db_plan_filter(data, filter))) {
+        candidates = g_ptr_array_new_full(plan->len, g_object_unref);
+        for (i = 0; i < plan->len; i++)
+            g_ptr_array_add(candidates, g_object_ref(plan->pdata[i]));
+        g_ptr_array_unref(plan);
+    }
+
+    g_mutex_unlock(&db->priv->index_lock);
+    g_object_unref(db);
+
+    if (candidates == NULL)
+        return FALSE;
+
+    /*
+     * The filter may call back into the database, and adding to the
+     * source list drops its filter data, so neither the lock nor @data
+     * are used while matching.
+     */
+    for (i = 0; i < candidates->len; i++) {
+        OsinfoEntity *entity = candidates->pdata[i];
+
+        if (osinfo_filter_matches(filter, entity))
+            osinfo_list_add(list, entity);
+    }
+
+    g_ptr_array_unref(candidates);
+    return TRUE;
+}
+
+static void osinfo_db_set_list_filter(OsinfoDb *db,
+                                      OsinfoList *list,
+                                      OsinfoList *entities,
+                                      GHashTable *properties)
+{
+    OsinfoDbListFilterData *data = g_new0(OsinfoDbListFilterData, 1);
+
+    g_weak_ref_init(&data->db, db);
+    data->entities = entities;
+    data->properties = properties;
+    data->domain = db->priv->domain;
+
+    g_mutex_lock(&db->priv->index_lock);
+    data->version = db->priv->version;
+    g_mutex_unlock(&db->priv->index_lock);
+
+    osinfo_list_set_filter_func(list, osinfo_db_list_filter,
+                                data, osinfo_db_list_filter_data_free);
+}
+
+static void osinfo_db_device_id_keys(OsinfoDbIndex *index,
+                                     OsinfoEntity *entity,
+                                     GPtrArray *keys)
+{
+    OsinfoDevice *device = OSINFO_DEVICE(entity);
+    const gchar *bus_type = osinfo_device_get_bus_type(device);
+    const gchar *vendor_id = osinfo_device_get_vendor_id(device);
+    const gchar *product_id = osinfo_device_get_product_id(device);
+    const gchar *subsystem = osinfo_device_get_subsystem(device);
+
+    if (bus_type == NULL || vendor_id == NULL || product_id == NULL)
+        return;
+
+    g_ptr_array_add(keys, g_strjoin("\n", bus_type, vendor_id, product_id, NULL));
+    if (subsystem != NULL)
+        g_ptr_array_add(keys, g_strjoin("\n", bus_type, vendor_id,
+                                        product_id, subsystem, NULL));
+}
+
+static const OsinfoProductRelationship osinfo_db_relationships[] = {
+    OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM,
+    OSINFO_PRODUCT_RELATIONSHIP_UPGRADES,
+    OSINFO_PRODUCT_RELATIONSHIP_CLONES,
+};
+
+static gchar *osinfo_db_relationship_key(OsinfoProductRelationship relshp,
+                                         OsinfoProduct *target)
+{
+    return g_strdup_printf("%d\n%s", relshp,
+                           osinfo_entity_get_id(OSINFO_ENTITY(target)));
+}
+
+static void osinfo_db_relationship_keys(OsinfoDbIndex *index,
+                                        OsinfoEntity *entity,
+                                        GPtrArray *keys)
+{
+    gsize i;
+
+    if (index->objects == NULL) {
+        index->objects = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                               g_free, g_object_unref);
+        index->object_keys = g_ptr_array_new();
+    }
+
+    for (i = 0; i < G_N_ELEMENTS(osinfo_db_relationships); i++) {
+        OsinfoProductList *related =
+            osinfo_product_get_related(OSINFO_PRODUCT(entity),
+                                       osinfo_db_relationships[i]);
+        gint j;
+
+        for (j = 0; j < osinfo_list_get_length(OSINFO_LIST(related)); j++) {
+            OsinfoEntity *target = osinfo_list_get_nth(OSINFO_LIST(related), j);
+            gchar *key = osinfo_db_relationship_key(osinfo_db_relationships[i],
+                                                    OSINFO_PRODUCT(target));
+
+            if (!g_hash_table_contains(index->objects, key)) {
+                gchar *object_key = g_strdup(key);
+
+                g_hash_table_insert(index->objects, object_key,
+                                    g_object_ref(target));
+                g_ptr_array_add(index->object_keys, object_key);
+            }
+            g_ptr_array_add(keys, key);
+        }
+        g_object_unref(related);
+    }
+}
+
+/*
+ * The OS and platform of a deployment are construct-only properties, so
+ * unlike the lazy indexes above, the deployment index is kept up to date
+ * by osinfo_db_add_deployment() itself.
+ */
+static gchar *osinfo_db_deployment_key(OsinfoOs *os, OsinfoPlatform *platform)
+{
+    return g_strjoin("\n",
+                     osinfo_entity_get_id(OSINFO_ENTITY(os)),
+                     osinfo_entity_get_id(OSINFO_ENTITY(platform)),
+                     NULL);
+}
+
+/* Must be called with index_lock held */
+static void osinfo_db_index_deployment(OsinfoDb *db,
+                                       OsinfoDeployment *deployment)
+{
+    gchar *key = osinfo_db_deployment_key(osinfo_deployment_get_os(deployment),
+                                          osinfo_deployment_get_platform(deployment));
+
+    if (!g_hash_table_contains(db->priv->deployment_ids, key))
+        g_hash_table_insert(db->priv->deployment_ids, key, deployment);
+    else
+        g_free(key);
+}
+
+/*
+ * The device support tables reverse osinfo_os_get_all_devices() and
+ * osinfo_platform_get_all_devices() for every OS and platform. They depend
+ * on device links, their properties and the relationships between
+ * products, so they are rebuilt once any OS, platform or device of the
+ * database, or anything linked to them, changed.
+ *
+ * Must be called with index_lock held.
+ */
+static void osinfo_db_clear_device_support(OsinfoDb *db)
+{
+    g_clear_pointer(&db->priv->device_oses, g_hash_table_unref);
+    g_clear_pointer(&db->priv->device_platforms, g_hash_table_unref);
+    g_clear_pointer(&db->priv->device_unsupported_oses, g_hash_table_unref);
+}
+
+static void osinfo_db_add_device_support(GHashTable *table,
+                                         OsinfoDeviceList *devices,
+                                         OsinfoEntity *product)
+{
+    gint i;
+
+    for (i = 0; i < osinfo_list_get_length(OSINFO_LIST(devices)); i++) {
+        OsinfoEntity *device = osinfo_list_get_nth(OSINFO_LIST(devices), i);
+        const gchar *id = osinfo_entity_get_id(device);
+        GPtrArray *products = g_hash_table_lookup(table, id);
+
+        if (products == NULL) {
+            products = g_ptr_array_new();
+            g_hash_table_insert(table, g_strdup(id), products);
+        }
+        g_ptr_array_add(products, product);
+    }
+}
+
+static void osinfo_db_build_device_support(OsinfoDb *db)
+{
+    OsinfoList *oses = OSINFO_LIST(db->priv->oses);
+    OsinfoList *platforms = OSINFO_LIST(db->priv->platforms);
+    gint i;
+
+    osinfo_db_clear_device_support(db);
+
+    db->priv->device_support_generation =
+        osinfo_entity_domain_get_generation(db->priv->domain);
+    db->priv->device_oses =
+        g_hash_table_new_full(g_str_hash, g_str_equal,
+                              g_free, (GDestroyNotify)g_ptr_array_unref);
+    db->priv->device_platforms =
+        g_hash_table_new_full(g_str_hash, g_str_equal,
+                              g_free, (GDestroyNotify)g_ptr_array_unref);
+    db->priv->device_unsupported_oses =
+        g_hash_table_new_full(g_str_hash, g_str_equal,
+                              g_free, (GDestroyNotify)g_ptr_array_unref);
+
+    for (i = 0; i < osinfo_list_get_length(oses); i++) {
+        OsinfoOs *os = OSINFO_OS(osinfo_list_get_nth(oses, i));
+        OsinfoDeviceList *unsupported = osinfo_devicelist_new();
+        OsinfoDeviceList *devices =
+            osinfo_os_get_all_devices_internal(os, NULL, unsupported);
+
+        osinfo_db_add_device_support(db->priv->device_oses, devices,
+                                     OSINFO_ENTITY(os));
+        osinfo_db_add_device_support(db->priv->device_unsupported_oses,
+                                     unsupported, OSINFO_ENTITY(os));
+        g_object_unref(unsupported);
+        g_object_unref(devices);
+    }
+
+    for (i = 0; i < osinfo_list_get_length(platforms); i++) {
+        OsinfoPlatform *platform = OSINFO_PLATFORM(osinfo_list_get_nth(platforms, i));
+        OsinfoDeviceList *devices = osinfo_platform_get_all_devices(platform, NULL);
+
+        osinfo_db_add_device_support(db->priv->device_platforms, devices,
+                                     OSINFO_ENTITY(platform));
+        g_object_unref(devices);
+    }
+}
+
+static void osinfo_db_get_device_support(OsinfoDb *db,
+                                         GHashTable **table,
+                                         OsinfoDevice *device,
+                                         OsinfoList *list)
+{
+    GPtrArray *products;
+    guint i;
+
+    g_mutex_lock(&db->priv->index_lock);
+
+    if (*table == NULL ||
+        db->priv->device_support_generation !=
+        osinfo_entity_domain_get_generation(db->priv->domain))
+        osinfo_db_build_device_support(db);
+
+    products = g_hash_table_lookup(*table,
+                                   osinfo_entity_get_id(OSINFO_ENTITY(device)));
+    for (i = 0; products && i < products->len; i++)
+        osinfo_list_add(list, products->pdata[i]);
+
+    g_mutex_unlock(&db->priv->index_lock);
+}
+
+/*
+ * The support period of an OS runs from its release day to its EOL day,
+ * both inclusive, as julian day numbers. An unset release date starts
+ * the period at day 0 and an unset EOL date never ends it.
+ */
+typedef struct _OsinfoDbSupportPeriod OsinfoDbSupportPeriod;
+struct _OsinfoDbSupportPeriod {
+    OsinfoOs *os;
+    guint32 release;
+    guint32 eol;
+    /* Position of the OS in the database list */
+    guint position;
+};
+
+static void osinfo_db_support_period_clear(gpointer data)
+{
+    OsinfoDbSupportPeriod *period = data;
+
+    g_object_unref(period->os);
+}
+
+static gint osinfo_db_support_period_compare_position(gconstpointer a,
+                                                      gconstpointer b)
+{
+    const OsinfoDbSupportPeriod *pa = a;
+    const OsinfoDbSupportPeriod *pb = b;
+
+    return (pa->position > pb->position) - (pa->position < pb->position);
+}
+
+static gint osinfo_db_support_period_compare_release(gconstpointer a,
+                                                     gconstpointer b)
+{
+    const OsinfoDbSupportPeriod *pa = a;
+    const OsinfoDbSupportPeriod *pb = b;
+
+    if (pa->release != pb->release)
+        return pa->release < pb->release ? -1 : 1;
+
+    return osinfo_db_support_period_compare_position(a, b);
+}
+
+static gint osinfo_db_support_period_compare_eol(gconstpointer a,
+                                                 gconstpointer b)
+{
+    const OsinfoDbSupportPeriod *pa = a;
+    const OsinfoDbSupportPeriod *pb = b;
+
+    if (pa->eol != pb->eol)
+        return pa->eol < pb->eol ? -1 : 1;
+
+    return osinfo_db_support_period_compare_position(a, b);
+}
+
+static GArray *osinfo_db_support_periods_new(void)
+{
+    GArray *periods = g_array_new(FALSE, FALSE, sizeof(OsinfoDbSupportPeriod));
+
+    g_array_set_clear_func(periods, osinfo_db_support_period_clear);
+
+    return periods;
+}
+
+/* Must be called with index_lock held */
+static void osinfo_db_clear_support_periods(OsinfoDb *db)
+{
+    g_clear_pointer(&db->priv->os_by_release, g_array_unref);
+    g_clear_pointer(&db->priv->os_by_eol, g_array_unref);
+}
+
+static void osinfo_db_build_support_periods(OsinfoDb *db)
+{
+    OsinfoList *oses = OSINFO_LIST(db->priv->oses);
+    gint i;
+
+    osinfo_db_clear_support_periods(db);
+
+    db->priv->os_periods_generation =
+        osinfo_entity_domain_get_generation(db->priv->domain);
+    db->priv->os_by_release = osinfo_db_support_periods_new();
+    db->priv->os_by_eol = osinfo_db_support_periods_new();
+
+    for (i = 0; i < osinfo_list_get_length(oses); i++) {
+        OsinfoDbSupportPeriod period;
+
+        period.os = OSINFO_OS(osinfo_list_get_nth(oses, i));
+        period.position = i;
+        osinfo_product_get_support_days(OSINFO_PRODUCT(period.os),
+                                        &period.release, &period.eol);
+        if (period.eol == 0)
+            period.eol = G_MAXUINT32;
+
+        g_object_ref(period.os);
+        g_array_append_val(db->priv->os_by_release, period);
+        g_object_ref(period.os);
+        g_array_append_val(db->priv->os_by_eol, period);
+    }
+
+    g_array_sort(db->priv->os_by_release,
+                 osinfo_db_support_period_compare_release);
+    g_array_sort(db->priv->os_by_eol,
+                 osinfo_db_support_period_compare_eol);
+}
+
+/* Must be called with index_lock held */
+static void osinfo_db_ensure_support_periods(OsinfoDb *db)
+{
+    if (db->priv->os_by_release == NULL ||
+        db->priv->os_periods_generation !=
+        osinfo_entity_domain_get_generation(db->priv->domain))
+        osinfo_db_build_support_periods(db);
+}
+
+/* Number of periods, sorted by release, released on or before @day */
+static guint osinfo_db_support_periods_released_by(GArray *periods,
+                                                   guint32 day)
+{
+    guint lo = 0, hi = periods->len;
+
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (g_array_index(periods, OsinfoDbSupportPeriod, mid).release <= day)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/* Index of the first period, sorted by EOL, not ended before @day */
+static guint osinfo_db_support_periods_eol_from(GArray *periods,
+                                                guint32 day)
+{
+    guint lo = 0, hi = periods->len;
+
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (g_array_index(periods, OsinfoDbSupportPeriod, mid).eol < day)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
 static void
 osinfo_db_finalize(GObject *object)
 {
@@ -143,6 +1036,19 @@ osinfo_db_finalize(GObject *object)
     g_object_unref(db->priv->datamaps);
     g_object_unref(db->priv->scripts);
 
+    g_hash_table_unref(db->priv->os_properties);
+    g_hash_table_unref(db->priv->platform_properties);
+    g_hash_table_unref(db->priv->device_properties);
+    g_hash_table_unref(db->priv->deployment_properties);
+    osinfo_db_index_clear(&db->priv->device_ids);
+    osinfo_db_index_clear(&db->priv->os_relationships);
+    osinfo_db_index_clear(&db->priv->platform_relationships);
+    g_hash_table_unref(db->priv->deployment_ids);
+    osinfo_db_clear_device_support(db);
+    osinfo_db_clear_support_periods(db);
+    g_mutex_clear(&db->priv->index_lock);
+    osinfo_entity_domain_unref(db->priv->domain);
+
     /* Chain up to the parent class */
     G_OBJECT_CLASS(osinfo_db_parent_class)->finalize(object);
 }
@@ -168,6 +1074,20 @@ osinfo_db_init(OsinfoDb *db)
     db->priv->deployments = osinfo_deploymentlist_new();
     db->priv->datamaps = osinfo_datamaplist_new();
     db->priv->scripts = osinfo_install_scriptlist_new();
+    db->priv->domain = osinfo_entity_domain_new();
+    g_mutex_init(&db->priv->index_lock);
+    db->priv->os_properties = osinfo_db_property_indexes_new();
+    db->priv->platform_properties = osinfo_db_property_indexes_new();
+    db->priv->device_properties = osinfo_db_property_indexes_new();
+    db->priv->deployment_properties = osinfo_db_property_indexes_new();
+    db->priv->device_ids.keys_func = osinfo_db_device_id_keys;
+    db->priv->device_ids.domain = db->priv->domain;
+    db->priv->os_relationships.keys_func = osinfo_db_relationship_keys;
+    db->priv->os_relationships.domain = db->priv->domain;
+    db->priv->platform_relationships.keys_func = osinfo_db_relationship_keys;
+    db->priv->platform_relationships.domain = db->priv->domain;
+    db->priv->deployment_ids = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                     g_free, NULL);
 }
 
 /**
@@ -225,6 +1145,288 @@ OsinfoOs *osinfo_db_get_os(OsinfoDb *db, const gchar *id)
     return OSINFO_OS(osinfo_list_find_by_id(OSINFO_LIST(db->priv->oses), id));
 }
 
+
+/**
+ * osinfo_db_get_os_by_short_id:
+ * @db: the database
+ * @short_id: a short-id of the operating system
+ *
+ * Find the operating system which has @short_id amongst the values of
+ * its #OSINFO_PRODUCT_PROP_SHORT_ID property. Should several operating
+ * systems share the short-id, the first one added to @db is returned.
+ *
+ * Lookups are served from an index maintained by the database, rather
+ * than by filtering the whole operating system list.
+ *
+ * Returns: (transfer none): the operating system, or NULL if none is found
+ *
+ * Since: 1.13.0
+ */
+OsinfoOs *osinfo_db_get_os_by_short_id(OsinfoDb *db, const gchar *short_id)
+{
+    OsinfoEntity *os;
+
+    g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
+    g_return_val_if_fail(short_id != NULL, NULL);
+
+    g_mutex_lock(&db->priv->index_lock);
+    os = osinfo_db_index_lookup(osinfo_db_get_property_index(db->priv->os_properties,
+                                                             db->priv->domain,
+                                                             OSINFO_PRODUCT_PROP_SHORT_ID),
+                                OSINFO_LIST(db->priv->oses),
+                                short_id);
+    g_mutex_unlock(&db->priv->index_lock);
+
+    return os ? OSINFO_OS(os) : NULL;
+}
+
+
+/**
+ * osinfo_db_find_device_by_ids:
+ * @db: the database
+ * @bus_type: the bus type of the device, eg "pci" or "usb"
+ * @vendor_id: the vendor ID of the device
+ * @product_id: the product ID of the device
+ * @subsystem: (allow-none): the subsystem of the device, or %NULL
+ *
+ * Find the device matching the hardware IDs. The IDs are compared as
+ * strings against the #OSINFO_DEVICE_PROP_BUS_TYPE,
+ * #OSINFO_DEVICE_PROP_VENDOR_ID, #OSINFO_DEVICE_PROP_PRODUCT_ID and
+ * #OSINFO_DEVICE_PROP_SUBSYSTEM properties, just as an #OsinfoFilter
+ * would. If @subsystem is %NULL, devices match whatever their subsystem.
+ * Should several devices match, the first one added to @db is returned.
+ *
+ * Lookups are served from an index maintained by the database, rather
+ * than by filtering the whole device list.
+ *
+ * Returns: (transfer none): the device, or NULL if none is found
+ *
+ * Since: 1.13.0
+ */
+OsinfoDevice *osinfo_db_find_device_by_ids(OsinfoDb *db,
+                                           const gchar *bus_type,
+                                           const gchar *vendor_id,
+                                           const gchar *product_id,
+                                           const gchar *subsystem)
+{
+    OsinfoEntity *device;
+    gchar *key;
+
+    g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
+    g_return_val_if_fail(bus_type != NULL, NULL);
+    g_return_val_if_fail(vendor_id != NULL, NULL);
+    g_return_val_if_fail(product_id != NULL, NULL);
+
+    key = g_strjoin("\n", bus_type, vendor_id, product_id, subsystem, NULL);
+
+    g_mutex_lock(&db->priv->index_lock);
+    device = osinfo_db_index_lookup(&db->priv->device_ids,
+                                    OSINFO_LIST(db->priv->devices),
+                                    key);
+    g_mutex_unlock(&db->priv->index_lock);
+
+    g_free(key);
+
+    return device ? OSINFO_DEVICE(device) : NULL;
+}
+
+
+/**
+ * osinfo_db_get_oses_for_device:
+ * @db: the database
+ * @device: (transfer none): a device
+ * @supported: whether to look for operating systems supporting @device,
+ * or explicitly not supporting it
+ *
+ * If @supported is TRUE, get all the operating systems supporting @device,
+ * that is all the operating systems for which osinfo_os_get_all_devices()
+ * would include @device. Devices inherited through derived and cloned
+ * operating systems are thus accounted for, while devices explicitly
+ * marked as unsupported are not.
+ *
+ * If @supported is FALSE, get instead all the operating systems whose
+ * device links, own or inherited, mark @device as unsupported.
+ *
+ * Lookups are served from an index maintained by the database, rather
+ * than by listing the devices of every operating system.
+ *
+ * Returns: (transfer full): a list of operating systems
+ *
+ * Since: 1.13.0
+ */
+OsinfoOsList *osinfo_db_get_oses_for_device(OsinfoDb *db,
+                                            OsinfoDevice *device,
+                                            gboolean supported)
+{
+    OsinfoOsList *oses;
+
+    g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
+    g_return_val_if_fail(OSINFO_IS_DEVICE(device), NULL);
+
+    oses = osinfo_oslist_new();
+    osinfo_db_get_device_support(db,
+                                 supported ? &db->priv->device_oses :
+                                             &db->priv->device_unsupported_oses,
+                                 device, OSINFO_LIST(oses));
+
+    return oses;
+}
+
+
+/**
+ * osinfo_db_get_platforms_for_device:
+ * @db: the database
+ * @device: (transfer none): a device
+ *
+ * Get all the platforms supporting @device, that is all the platforms for
+ * which osinfo_platform_get_all_devices() would include @device.
+ *
+ * Returns: (transfer full): a list of platforms
+ *
+ * Since: 1.13.0
+ */
+OsinfoPlatformList *osinfo_db_get_platforms_for_device(OsinfoDb *db,
+                                                       OsinfoDevice *device)
+{
+    OsinfoPlatformList *platforms;
+
+    g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
+    g_return_val_if_fail(OSINFO_IS_DEVICE(device), NULL);
+
+    platforms = osinfo_platformlist_new();
+    osinfo_db_get_device_support(db, &db->priv->device_platforms,
+                                 device, OSINFO_LIST(platforms));
+
+    return platforms;
+}
+
+
+/**
+ * osinfo_db_get_oses_supported_on:
+ * @db: the database
+ * @date: (transfer none): a date
+ *
+ * Get all the operating systems supported on @date, that is the operating
+ * systems released on or before @date and not reaching their end of life
+ * before @date. An operating system without a release date is considered
+ * released, and one without an EOL date is considered still supported.
+ * This matches filtering the list of operating systems with
+ * osinfo_productfilter_add_support_date_constraint().
+ *
+ * Lookups are served from an index of the support periods maintained by
+ * the database, rather than by parsing the dates of every operating
+ * system.
+ *
+ * Returns: (transfer full): a list of operating systems, in the order of
+ * osinfo_db_get_os_list()
+ *
+ * Since: 1.13.0
+ */
+OsinfoOsList *osinfo_db_get_oses_supported_on(OsinfoDb *db, GDate *date)
+{
+    OsinfoOsList *oses;
+    GArray *matches;
+    guint32 day;
+    guint released, supported, i;
+
+    g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
+    g_return_val_if_fail(date != NULL && g_date_valid(date), NULL);
+
+    day = g_date_get_julian(date);
+    oses = osinfo_oslist_new();
+    matches = g_array_new(FALSE, FALSE, sizeof(OsinfoDbSupportPeriod));
+
+    g_mutex_lock(&db->priv->index_lock);
+    osinfo_db_ensure_support_periods(db);
+
+    /* Scan whichever of the released and not yet ended OSes is shorter */
+    released = osinfo_db_support_periods_released_by(db->priv->os_by_release, day);
+    supported = osinfo_db_support_periods_eol_from(db->priv->os_by_eol, day);
+    if (released <= db->priv->os_by_eol->len - supported) {
+        for (i = 0; i < released; i++) {
+            OsinfoDbSupportPeriod *period =
+                &g_array_index(db->priv->os_by_release, OsinfoDbSupportPeriod, i);
+
+            if (period->eol >= day)
+                g_array_append_vals(matches, period, 1);
+        }
+    } else {
+        for (i = supported; i < db->priv->os_by_eol->len; i++) {
+            OsinfoDbSupportPeriod *period =
+                &g_array_index(db->priv->os_by_eol, OsinfoDbSupportPeriod, i);
+
+            if (period->release <= day)
+                g_array_append_vals(matches, period, 1);
+        }
+    }
+
+    g_array_sort(matches, osinfo_db_support_period_compare_position);
+    for (i = 0; i < matches->len; i++)
+        osinfo_list_add(OSINFO_LIST(oses),
+                        OSINFO_ENTITY(g_array_index(matches, OsinfoDbSupportPeriod, i).os));
+
+    g_mutex_unlock(&db->priv->index_lock);
+
+    g_array_unref(matches);
+
+    return oses;
+}
+
+
+/**
+ * osinfo_db_get_oses_eol_between:
+ * @db: the database
+ * @start: (transfer none): the first day of the range
+ * @end: (transfer none): the last day of the range
+ *
+ * Get all the operating systems reaching their end of life between @start
+ * and @end, both inclusive. Operating systems without an EOL date are
+ * never included.
+ *
+ * Lookups are served from an index of the support periods maintained by
+ * the database, rather than by parsing the dates of every operating
+ * system.
+ *
+ * Returns: (transfer full): a list of operating systems, sorted by EOL date
+ *
+ * Since: 1.13.0
+ */
+OsinfoOsList *osinfo_db_get_oses_eol_between(OsinfoDb *db,
+                                             GDate *start,
+                                             GDate *end)
+{
+    OsinfoOsList *oses;
+    guint32 first, last;
+    guint i;
+
+    g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
+    g_return_val_if_fail(start != NULL && g_date_valid(start), NULL);
+    g_return_val_if_fail(end != NULL && g_date_valid(end), NULL);
+
+    first = g_date_get_julian(start);
+    last = g_date_get_julian(end);
+    oses = osinfo_oslist_new();
+
+    g_mutex_lock(&db->priv->index_lock);
+    osinfo_db_ensure_support_periods(db);
+
+    for (i = osinfo_db_support_periods_eol_from(db->priv->os_by_eol, first);
+         i < db->priv->os_by_eol->len; i++) {
+        OsinfoDbSupportPeriod *period =
+            &g_array_index(db->priv->os_by_eol, OsinfoDbSupportPeriod, i);
+
+        /* Also stops at OSes without an EOL date, sorted last */
+        if (period->eol > last || period->eol == G_MAXUINT32)
+            break;
+
+        osinfo_list_add(OSINFO_LIST(oses), OSINFO_ENTITY(period->os));
+    }
+
+    g_mutex_unlock(&db->priv->index_lock);
+
+    return oses;
+}
+
 /**
  * osinfo_db_get_deployment:
  * @db: the database
@@ -290,34 +1492,22 @@ OsinfoDeployment *osinfo_db_find_deployment(OsinfoDb *db,
                                             OsinfoOs *os,
                                             OsinfoPlatform *platform)
 {
-    GList *deployments;
-    GList *tmp;
+    OsinfoDeployment *deployment;
+    gchar *key;
 
     g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
     g_return_val_if_fail(OSINFO_IS_OS(os), NULL);
     g_return_val_if_fail(OSINFO_IS_PLATFORM(platform), NULL);
 
-    deployments = osinfo_list_get_elements(OSINFO_LIST(db->priv->deployments));
-    tmp = deployments;
-
-    while (tmp) {
-        OsinfoDeployment *deployment = OSINFO_DEPLOYMENT(tmp->data);
-        OsinfoOs *otheros = osinfo_deployment_get_os(deployment);
-        OsinfoPlatform *otherplatform = osinfo_deployment_get_platform(deployment);
+    key = osinfo_db_deployment_key(os, platform);
 
-        if (g_strcmp0(osinfo_entity_get_id(OSINFO_ENTITY(os)),
-                      osinfo_entity_get_id(OSINFO_ENTITY(otheros))) == 0 &&
-            g_strcmp0(osinfo_entity_get_id(OSINFO_ENTITY(platform)),
-                      osinfo_entity_get_id(OSINFO_ENTITY(otherplatform))) == 0) {
-            g_list_free(deployments);
-            return deployment;
-        }
+    g_mutex_lock(&db->priv->index_lock);
+    deployment = g_hash_table_lookup(db->priv->deployment_ids, key);
+    g_mutex_unlock(&db->priv->index_lock);
 
-        tmp = tmp->next;
-    }
+    g_free(key);
 
-    g_list_free(deployments);
-    return NULL;
+    return deployment;
 }
 
 
@@ -333,6 +1523,9 @@ OsinfoOsList *osinfo_db_get_os_list(OsinfoDb *db)
 
     g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
     new_list = osinfo_list_new_copy(OSINFO_LIST(db->priv->oses));
+    osinfo_db_set_list_filter(db, new_list,
+                              OSINFO_LIST(db->priv->oses),
+                              db->priv->os_properties);
 
     return OSINFO_OSLIST(new_list);
 }
@@ -349,6 +1542,9 @@ OsinfoPlatformList *osinfo_db_get_platform_list(OsinfoDb *db)
 
     g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
     new_list = osinfo_list_new_copy(OSINFO_LIST(db->priv->platforms));
+    osinfo_db_set_list_filter(db, new_list,
+                              OSINFO_LIST(db->priv->platforms),
+                              db->priv->platform_properties);
 
     return OSINFO_PLATFORMLIST(new_list);
 }
@@ -365,6 +1561,9 @@ OsinfoDeviceList *osinfo_db_get_device_list(OsinfoDb *db)
 
     g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
     new_list = osinfo_list_new_copy(OSINFO_LIST(db->priv->devices));
+    osinfo_db_set_list_filter(db, new_list,
+                              OSINFO_LIST(db->priv->devices),
+                              db->priv->device_properties);
 
     return OSINFO_DEVICELIST(new_list);
 }
@@ -382,6 +1581,9 @@ OsinfoDeploymentList *osinfo_db_get_deployment_list(OsinfoDb *db)
 
     g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
     new_list = osinfo_list_new_copy(OSINFO_LIST(db->priv->deployments));
+    osinfo_db_set_list_filter(db, new_list,
+                              OSINFO_LIST(db->priv->deployments),
+                              db->priv->deployment_properties);
 
     return OSINFO_DEPLOYMENTLIST(new_list);
 }
@@ -425,6 +1627,41 @@ OsinfoInstallScriptList *osinfo_db_get_install_script_list(OsinfoDb *db)
 }
 
 
+/**
+ * osinfo_db_preload_install_scripts:
+ * @db: the database
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: The location where to store any error, or %NULL
+ *
+ * Calls osinfo_install_script_preload() on every install script of the
+ * database, so generating scripts does not need to read any template.
+ *
+ * Returns: %TRUE on success, %FALSE if any template failed to load.
+ *
+ * Since: 1.13.0
+ */
+gboolean osinfo_db_preload_install_scripts(OsinfoDb *db,
+                                           GCancellable *cancellable,
+                                           GError **error)
+{
+    OsinfoList *scripts;
+    gint i;
+    gboolean ret = TRUE;
+
+    g_return_val_if_fail(OSINFO_IS_DB(db), FALSE);
+
+    scripts = OSINFO_LIST(db->priv->scripts);
+    for (i = 0; ret && i < osinfo_list_get_length(scripts); i++) {
+        OsinfoInstallScript *script =
+            OSINFO_INSTALL_SCRIPT(osinfo_list_get_nth(scripts, i));
+
+        ret = osinfo_install_script_preload(script, cancellable, error);
+    }
+
+    return ret;
+}
+
+
 /**
  * osinfo_db_add_os:
  * @db: the database
@@ -436,7 +1673,16 @@ void osinfo_db_add_os(OsinfoDb *db, OsinfoOs *os)
     g_return_if_fail(OSINFO_IS_DB(db));
     g_return_if_fail(OSINFO_IS_OS(os));
 
+    osinfo_entity_join_domain(OSINFO_ENTITY(os), db->priv->domain);
     osinfo_list_add(OSINFO_LIST(db->priv->oses), OSINFO_ENTITY(os));
+
+    g_mutex_lock(&db->priv->index_lock);
+    db->priv->version++;
+    g_hash_table_remove_all(db->priv->os_properties);
+    osinfo_db_index_clear(&db->priv->os_relationships);
+    osinfo_db_clear_device_support(db);
+    osinfo_db_clear_support_periods(db);
+    g_mutex_unlock(&db->priv->index_lock);
 }
 
 
@@ -451,7 +1697,15 @@ void osinfo_db_add_platform(OsinfoDb *db, OsinfoPlatform *platform)
     g_return_if_fail(OSINFO_IS_DB(db));
     g_return_if_fail(OSINFO_IS_PLATFORM(platform));
 
+    osinfo_entity_join_domain(OSINFO_ENTITY(platform), db->priv->domain);
     osinfo_list_add(OSINFO_LIST(db->priv->platforms), OSINFO_ENTITY(platform));
+
+    g_mutex_lock(&db->priv->index_lock);
+    db->priv->version++;
+    g_hash_table_remove_all(db->priv->platform_properties);
+    osinfo_db_index_clear(&db->priv->platform_relationships);
+    osinfo_db_clear_device_support(db);
+    g_mutex_unlock(&db->priv->index_lock);
 }
 
 
@@ -466,7 +1720,14 @@ void osinfo_db_add_device(OsinfoDb *db, OsinfoDevice *device)
     g_return_if_fail(OSINFO_IS_DB(db));
     g_return_if_fail(OSINFO_IS_DEVICE(device));
 
+    osinfo_entity_join_domain(OSINFO_ENTITY(device), db->priv->domain);
     osinfo_list_add(OSINFO_LIST(db->priv->devices), OSINFO_ENTITY(device));
+
+    g_mutex_lock(&db->priv->index_lock);
+    db->priv->version++;
+    g_hash_table_remove_all(db->priv->device_properties);
+    osinfo_db_index_clear(&db->priv->device_ids);
+    g_mutex_unlock(&db->priv->index_lock);
 }
 
 
@@ -478,10 +1739,34 @@ void osinfo_db_add_device(OsinfoDb *db, OsinfoDevice *device)
  */
 void osinfo_db_add_deployment(OsinfoDb *db, OsinfoDeployment *deployment)
 {
+    OsinfoList *list;
+    OsinfoEntity *preexisting;
+
     g_return_if_fail(OSINFO_IS_DB(db));
     g_return_if_fail(OSINFO_IS_DEPLOYMENT(deployment));
 
-    osinfo_list_add(OSINFO_LIST(db->priv->deployments), OSINFO_ENTITY(deployment));
+    osinfo_entity_join_domain(OSINFO_ENTITY(deployment), db->priv->domain);
+    list = OSINFO_LIST(db->priv->deployments);
+    preexisting = osinfo_list_find_by_id(list,
+                                         osinfo_entity_get_id(OSINFO_ENTITY(deployment)));
+
+    g_mutex_lock(&db->priv->index_lock);
+    db->priv->version++;
+    g_hash_table_remove_all(db->priv->deployment_properties);
+    if (preexisting != NULL) {
+        gint i;
+
+        /* The replaced deployment may be indexed, so start over */
+        osinfo_list_add(list, OSINFO_ENTITY(deployment));
+        g_hash_table_remove_all(db->priv->deployment_ids);
+        for (i = 0; i < osinfo_list_get_length(list); i++)
+            osinfo_db_index_deployment(db,
+                                       OSINFO_DEPLOYMENT(osinfo_list_get_nth(list, i)));
+    } else {
+        osinfo_list_add(list, OSINFO_ENTITY(deployment));
+        osinfo_db_index_deployment(db, deployment);
+    }
+    g_mutex_unlock(&db->priv->index_lock);
 }
 
 
@@ -497,6 +1782,7 @@ void osinfo_db_add_datamap(OsinfoDb *db, OsinfoDatamap *datamap)
     g_return_if_fail(OSINFO_IS_DB(db));
     g_return_if_fail(OSINFO_IS_DATAMAP(datamap));
 
+    osinfo_entity_join_domain(OSINFO_ENTITY(datamap), db->priv->domain);
     osinfo_list_add(OSINFO_LIST(db->priv->datamaps), OSINFO_ENTITY(datamap));
 }
 
@@ -513,6 +1799,7 @@ void osinfo_db_add_install_script(OsinfoDb *db, OsinfoInstallScript *script)
     g_return_if_fail(OSINFO_IS_DB(db));
     g_return_if_fail(OSINFO_IS_INSTALL_SCRIPT(script));
 
+    osinfo_entity_join_domain(OSINFO_ENTITY(script), db->priv->domain);
     osinfo_list_add(OSINFO_LIST(db->priv->scripts), OSINFO_ENTITY(script));
 }
 
@@ -1148,49 +2435,37 @@ OsinfoTreeList *osinfo_db_identify_treelist(OsinfoDb *db, OsinfoTree *tree)
     return matched_tree;
 }
 
-struct osinfo_db_populate_values_args {
-    GHashTable *values;
-    const gchar *property;
-};
-
-static void osinfo_db_get_property_values_in_entity(gpointer data, gpointer opaque)
+/*
+ * The values are interned, so they remain valid whatever happens to the
+ * entities and the indexes afterwards.
+ */
+static GList *osinfo_db_unique_values_for_property_in_entity(OsinfoDb *db,
+                                                             OsinfoList *entities,
+                                                             GHashTable *properties,
+                                                             const gchar *propName)
 {
-    OsinfoEntity *entity = OSINFO_ENTITY(data);
-    struct osinfo_db_populate_values_args *args = opaque;
-    GHashTable *newValues = args->values;
-    const gchar *property = args->property;
-    GList *values = osinfo_entity_get_param_value_list(entity, property);
-    GList *tmp = values;
+    OsinfoDbIndex *index;
+    GList *ret;
 
-    while (tmp) {
-        gchar *value = tmp->data;
+    g_mutex_lock(&db->priv->index_lock);
 
-        if (!g_hash_table_lookup(newValues, value)) {
-            g_hash_table_insert(newValues,
-                                value,
-                                GINT_TO_POINTER(1));
-        }
+    index = osinfo_db_get_property_index(properties, db->priv->domain, propName);
+    osinfo_db_index_refresh(index, entities);
 
-        tmp = tmp->next;
-    }
+    if (index->values == NULL) {
+        GHashTableIter iter;
+        gpointer value;
 
-    g_list_free(values);
-}
-
-static GList *osinfo_db_unique_values_for_property_in_entity(OsinfoList *entities, const gchar *propName)
-{
-    /* Deliberately no free func for key, since we return those to caller */
-    GHashTable *values = g_hash_table_new(g_str_hash, g_str_equal);
-    GList *ret;
-    struct osinfo_db_populate_values_args args = { values, propName };
-    GList *elements;
+        g_hash_table_iter_init(&iter, index->entities);
+        while (g_hash_table_iter_next(&iter, &value, NULL))
+            index->values = g_list_prepend(index->values,
+                                           (gpointer)g_intern_string(value));
+        index->values = g_list_sort(index->values, (GCompareFunc)strcmp);
+    }
+    ret = g_list_copy(index->values);
 
-    elements = osinfo_list_get_elements(entities);
-    g_list_foreach(elements, osinfo_db_get_property_values_in_entity, &args);
-    g_list_free(elements);
+    g_mutex_unlock(&db->priv->index_lock);
 
-    ret = g_hash_table_get_keys(values);
-    g_hash_table_unref(values);
     return ret;
 }
 
@@ -1200,7 +2475,9 @@ static GList *osinfo_db_unique_values_for_property_in_entity(OsinfoList *entitie
  * @propName: a property name
  *
  * Get all unique values for a named property amongst all
- * operating systems in the database
+ * operating systems in the database, sorted in byte order. The values
+ * are cached by the database, until it gains new entities or the
+ * entities are modified.
  *
  * Returns: (transfer container)(element-type utf8): a list of strings
  */
@@ -1209,7 +2486,10 @@ GList *osinfo_db_unique_values_for_property_in_os(OsinfoDb *db, const gchar *pro
     g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
     g_return_val_if_fail(propName != NULL, NULL);
 
-    return osinfo_db_unique_values_for_property_in_entity(OSINFO_LIST(db->priv->oses), propName);
+    return osinfo_db_unique_values_for_property_in_entity(db,
+                                                          OSINFO_LIST(db->priv->oses),
+                                                          db->priv->os_properties,
+                                                          propName);
 }
 
 
@@ -1219,7 +2499,9 @@ GList *osinfo_db_unique_values_for_property_in_os(OsinfoDb *db, const gchar *pro
  * @propName: a property name
  *
  * Get all unique values for a named property amongst all
- * platforms in the database
+ * platforms in the database, sorted in byte order. The values
+ * are cached by the database, until it gains new entities or the
+ * entities are modified.
  *
  * Returns: (transfer container)(element-type utf8): a list of strings
  */
@@ -1228,7 +2510,10 @@ GList *osinfo_db_unique_values_for_property_in_platform(OsinfoDb *db, const gcha
     g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
     g_return_val_if_fail(propName != NULL, NULL);
 
-    return osinfo_db_unique_values_for_property_in_entity(OSINFO_LIST(db->priv->platforms), propName);
+    return osinfo_db_unique_values_for_property_in_entity(db,
+                                                          OSINFO_LIST(db->priv->platforms),
+                                                          db->priv->platform_properties,
+                                                          propName);
 }
 
 
@@ -1238,7 +2523,9 @@ GList *osinfo_db_unique_values_for_property_in_platform(OsinfoDb *db, const gcha
  * @propName: a property name
  *
  * Get all unique values for a named property amongst all
- * devices in the database
+ * devices in the database, sorted in byte order. The values
+ * are cached by the database, until it gains new entities or the
+ * entities are modified.
  *
  * Returns: (transfer container)(element-type utf8): a list of strings
  */
@@ -1247,7 +2534,10 @@ GList *osinfo_db_unique_values_for_property_in_device(OsinfoDb *db, const gchar
     g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
     g_return_val_if_fail(propName != NULL, NULL);
 
-    return osinfo_db_unique_values_for_property_in_entity(OSINFO_LIST(db->priv->devices), propName);
+    return osinfo_db_unique_values_for_property_in_entity(db,
+                                                          OSINFO_LIST(db->priv->devices),
+                                                          db->priv->device_properties,
+                                                          propName);
 }
 
 /**
@@ -1256,7 +2546,9 @@ GList *osinfo_db_unique_values_for_property_in_device(OsinfoDb *db, const gchar
  * @propName: a property name
  *
  * Get all unique values for a named property amongst all
- * deployments in the database
+ * deployments in the database, sorted in byte order. The values
+ * are cached by the database, until it gains new entities or the
+ * entities are modified.
  *
  * Returns: (transfer container)(element-type utf8): a list of strings
  */
@@ -1265,29 +2557,95 @@ GList *osinfo_db_unique_values_for_property_in_deployment(OsinfoDb *db, const gc
     g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
     g_return_val_if_fail(propName != NULL, NULL);
 
-    return osinfo_db_unique_values_for_property_in_entity(OSINFO_LIST(db->priv->deployments), propName);
+    return osinfo_db_unique_values_for_property_in_entity(db,
+                                                          OSINFO_LIST(db->priv->deployments),
+                                                          db->priv->deployment_properties,
+                                                          propName);
 }
 
-struct __osinfoProductCheckRelationshipArgs {
-    OsinfoList *list;
-    OsinfoProductRelationship relshp;
-};
+/*
+ * Adds the targets of @relshp recorded in @index to @list, in the order
+ * the products of @entities first refer to them. Must be called with
+ * index_lock held.
+ */
+static void osinfo_db_add_relationship_targets(OsinfoDbIndex *index,
+                                               OsinfoList *entities,
+                                               OsinfoProductRelationship relshp,
+                                               OsinfoList *list)
+{
+    gchar *prefix = g_strdup_printf("%d\n", relshp);
+    guint i;
 
+    osinfo_db_index_refresh(index, entities);
 
-static void __osinfoAddProductIfRelationship(gpointer data, gpointer opaque)
-{
-    struct __osinfoProductCheckRelationshipArgs *args = opaque;
-    OsinfoProduct *product = OSINFO_PRODUCT(data);
-    OsinfoList *newList = args->list;
-    OsinfoProductList *thisList = osinfo_product_get_related(product, args->relshp);
-    int i;
+    for (i = 0; index->object_keys && i < index->object_keys->len; i++) {
+        const gchar *key = index->object_keys->pdata[i];
 
-    for (i = 0; i < osinfo_list_get_length(OSINFO_LIST(thisList)); i++) {
-        OsinfoEntity *entity = osinfo_list_get_nth(OSINFO_LIST(thisList), i);
-        osinfo_list_add(newList, entity);
+        if (g_str_has_prefix(key, prefix))
+            osinfo_list_add(list, g_hash_table_lookup(index->objects, key));
     }
 
-    g_object_unref(thisList);
+    g_free(prefix);
+}
+
+/* Must be called with index_lock held */
+static void osinfo_db_add_related_to(OsinfoDbIndex *index,
+                                     OsinfoList *entities,
+                                     const gchar *key,
+                                     OsinfoList *list)
+{
+    GPtrArray *products = osinfo_db_index_lookup_all(index, entities, key);
+    guint i;
+
+    for (i = 0; products && i < products->len; i++)
+        osinfo_list_add(list, products->pdata[i]);
+}
+
+/**
+ * osinfo_db_get_related_to:
+ * @db: the database
+ * @product: (transfer none): a product
+ * @relshp: the product relationship
+ *
+ * Get all the operating systems and platforms of the database having the
+ * relationship @relshp with @product, that is the products whose
+ * osinfo_product_get_related() would include @product. This is the
+ * reverse of osinfo_product_get_related(): for instance, with
+ * %OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM, it returns the products
+ * derived from @product.
+ *
+ * Lookups are served from an index maintained by the database, rather
+ * than by checking the relationships of every product.
+ *
+ * Returns: (transfer full): a list of products
+ *
+ * Since: 1.13.0
+ */
+OsinfoProductList *osinfo_db_get_related_to(OsinfoDb *db,
+                                            OsinfoProduct *product,
+                                            OsinfoProductRelationship relshp)
+{
+    OsinfoProductList *products;
+    gchar *key;
+
+    g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
+    g_return_val_if_fail(OSINFO_IS_PRODUCT(product), NULL);
+
+    products = osinfo_productlist_new();
+    key = osinfo_db_relationship_key(relshp, product);
+
+    g_mutex_lock(&db->priv->index_lock);
+    osinfo_db_add_related_to(&db->priv->os_relationships,
+                             OSINFO_LIST(db->priv->oses),
+                             key, OSINFO_LIST(products));
+    osinfo_db_add_related_to(&db->priv->platform_relationships,
+                             OSINFO_LIST(db->priv->platforms),
+                             key, OSINFO_LIST(products));
+    g_mutex_unlock(&db->priv->index_lock);
+
+    g_free(key);
+
+    return products;
 }
 
 /**
@@ -1296,27 +2654,24 @@ static void __osinfoAddProductIfRelationship(gpointer data, gpointer opaque)
  * @relshp: the product relationship
  *
  * Get all operating systems that are the referee
- * in an operating system relationship.
+ * in an operating system relationship, in the order the
+ * operating systems of the database refer to them.
  *
  * Returns: (transfer full): a list of operating systems
  */
 OsinfoOsList *osinfo_db_unique_values_for_os_relationship(OsinfoDb *db, OsinfoProductRelationship relshp)
 {
     OsinfoOsList *newList;
-    struct __osinfoProductCheckRelationshipArgs args;
-    GList *entities;
 
     g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
 
     newList = osinfo_oslist_new();
 
-    args.list = OSINFO_LIST(newList);
-    args.relshp = relshp;
-
-    entities = osinfo_list_get_elements(OSINFO_LIST(db->priv->oses));
-
-    g_list_foreach(entities, __osinfoAddProductIfRelationship, &args);
-    g_list_free(entities);
+    g_mutex_lock(&db->priv->index_lock);
+    osinfo_db_add_relationship_targets(&db->priv->os_relationships,
+                                       OSINFO_LIST(db->priv->oses),
+                                       relshp, OSINFO_LIST(newList));
+    g_mutex_unlock(&db->priv->index_lock);
 
     return newList;
 }
@@ -1328,27 +2683,24 @@ OsinfoOsList *osinfo_db_unique_values_for_os_relationship(OsinfoDb *db, OsinfoPr
  * @relshp: the product relationship
  *
  * Get all platforms that are the referee
- * in an platform relationship.
+ * in an platform relationship, in the order the
+ * platforms of the database refer to them.
  *
  * Returns: (transfer full): a list of virtualization platforms
  */
 OsinfoPlatformList *osinfo_db_unique_values_for_platform_relationship(OsinfoDb *db, OsinfoProductRelationship relshp)
 {
     OsinfoPlatformList *newList;
-    struct __osinfoProductCheckRelationshipArgs args;
-    GList *entities;
 
     g_return_val_if_fail(OSINFO_IS_DB(db), NULL);
 
     newList = osinfo_platformlist_new();
 
-    args.list = OSINFO_LIST(newList);
-    args.relshp = relshp;
-
-    entities = osinfo_list_get_elements(OSINFO_LIST(db->priv->platforms));
-
-    g_list_foreach(entities, __osinfoAddProductIfRelationship, &args);
-    g_list_free(entities);
+    g_mutex_lock(&db->priv->index_lock);
+    osinfo_db_add_relationship_targets(&db->priv->platform_relationships,
+                                       OSINFO_LIST(db->priv->platforms),
+                                       relshp, OSINFO_LIST(newList));
+    g_mutex_unlock(&db->priv->index_lock);
 
     return newList;
 }
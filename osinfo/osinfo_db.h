@@ -43,10 +43,25 @@ OsinfoDb *osinfo_db_new(void);
 OsinfoPlatform *osinfo_db_get_platform(OsinfoDb *db, const gchar *id);
 OsinfoDevice *osinfo_db_get_device(OsinfoDb *db, const gchar *id);
 OsinfoOs *osinfo_db_get_os(OsinfoDb *db, const gchar *id);
+OsinfoOs *osinfo_db_get_os_by_short_id(OsinfoDb *db, const gchar *short_id);
 OsinfoDeployment *osinfo_db_get_deployment(OsinfoDb *db, const gchar *id);
 OsinfoDatamap *osinfo_db_get_datamap(OsinfoDb *db, const gchar *id);
 OsinfoInstallScript *osinfo_db_get_install_script(OsinfoDb *db, const gchar *id);
 
+OsinfoDevice *osinfo_db_find_device_by_ids(OsinfoDb *db,
+                                           const gchar *bus_type,
+                                           const gchar *vendor_id,
+                                           const gchar *product_id,
+                                           const gchar *subsystem);
+OsinfoOsList *osinfo_db_get_oses_for_device(OsinfoDb *db,
+                                            OsinfoDevice *device,
+                                            gboolean supported);
+OsinfoPlatformList *osinfo_db_get_platforms_for_device(OsinfoDb *db,
+                                                       OsinfoDevice *device);
+OsinfoOsList *osinfo_db_get_oses_supported_on(OsinfoDb *db, GDate *date);
+OsinfoOsList *osinfo_db_get_oses_eol_between(OsinfoDb *db,
+                                             GDate *start,
+                                             GDate *end);
 OsinfoDeployment *osinfo_db_find_deployment(OsinfoDb *db,
                                             OsinfoOs *os,
                                             OsinfoPlatform *platform);
@@ -56,6 +71,9 @@ OsinfoPlatformList *osinfo_db_get_platform_list(OsinfoDb *db);
 OsinfoDeviceList *osinfo_db_get_device_list(OsinfoDb *db);
 OsinfoDeploymentList *osinfo_db_get_deployment_list(OsinfoDb *db);
 OsinfoInstallScriptList *osinfo_db_get_install_script_list(OsinfoDb *db);
+gboolean osinfo_db_preload_install_scripts(OsinfoDb *db,
+                                           GCancellable *cancellable,
+                                           GError **error);
 OsinfoDatamapList *osinfo_db_get_datamap_list(OsinfoDb *db);
 
 void osinfo_db_add_os(OsinfoDb *db, OsinfoOs *os);
@@ -100,3 +118,8 @@ OsinfoOsList *osinfo_db_unique_values_for_os_relationship(OsinfoDb *db, OsinfoPr
 
 // Get me all Platforms that 'upgrade' another Platform (or whatever relationship is specified)
 OsinfoPlatformList *osinfo_db_unique_values_for_platform_relationship(OsinfoDb *db, OsinfoProductRelationship relshp);
+
+// Get me all OSes and Platforms that 'upgrade' a given product (or whatever relationship is specified)
+OsinfoProductList *osinfo_db_get_related_to(OsinfoDb *db,
+                                            OsinfoProduct *product,
+                                            OsinfoProductRelationship relshp);
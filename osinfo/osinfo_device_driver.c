@@ -25,6 +25,7 @@
 #include <glib/gi18n-lib.h>
 
 #include "osinfo_device_driver_private.h"
+#include "osinfo_entity_private.h"
 
 /**
  * SECTION:osinfo_device_driver
@@ -167,6 +168,8 @@ void osinfo_device_driver_add_device(OsinfoDeviceDriver *driver,
 
     osinfo_list_add(OSINFO_LIST(driver->priv->devices),
                     OSINFO_ENTITY(device));
+    osinfo_entity_join(OSINFO_ENTITY(driver), OSINFO_ENTITY(device));
+    osinfo_entity_changed(OSINFO_ENTITY(driver));
 }
 
 /**
@@ -20,6 +20,7 @@
 
 #include <osinfo/osinfo.h>
 #include <glib/gi18n-lib.h>
+#include "osinfo_filter_private.h"
 
 /**
  * SECTION:osinfo_devicelinkfilter
@@ -40,6 +41,7 @@ struct _OsinfoDeviceLinkFilterPrivate
 G_DEFINE_TYPE_WITH_PRIVATE(OsinfoDeviceLinkFilter, osinfo_devicelinkfilter, OSINFO_TYPE_FILTER);
 
 static gboolean osinfo_devicelinkfilter_matches_default(OsinfoFilter *devicelinkfilter, OsinfoEntity *entity);
+static void osinfo_devicelinkfilter_compile_default(OsinfoFilter *filter);
 
 enum {
     PROP_0,
@@ -132,6 +134,8 @@ osinfo_devicelinkfilter_class_init(OsinfoDeviceLinkFilterClass *klass)
     g_object_class_install_properties(g_klass, LAST_PROP, properties);
 
     filter_klass->matches = osinfo_devicelinkfilter_matches_default;
+    osinfo_filter_class_set_compile_func(filter_klass,
+                                         osinfo_devicelinkfilter_compile_default);
 }
 
 
@@ -194,3 +198,12 @@ static gboolean osinfo_devicelinkfilter_matches_default(OsinfoFilter *filter, Os
 
     return TRUE;
 }
+
+
+static void osinfo_devicelinkfilter_compile_default(OsinfoFilter *filter)
+{
+    OsinfoDeviceLinkFilter *linkfilter = OSINFO_DEVICELINKFILTER(filter);
+
+    if (linkfilter->priv->targetFilter)
+        osinfo_filter_compile(linkfilter->priv->targetFilter);
+}
@@ -20,6 +20,7 @@
 
 #include <osinfo/osinfo.h>
 #include <glib/gi18n-lib.h>
+#include "osinfo_entity_private.h"
 
 /**
  * SECTION:osinfo_entity
@@ -40,10 +41,37 @@ struct _OsinfoEntityPrivate
     // Key: gchar*
     // Value: GList of gchar* values
     GHashTable *params;
+
+    // Bumped whenever params or links change
+    gint serial;
+
+    // Shared with the entities whose caches depend on this one
+    OsinfoEntityDomain *domain;
+};
+
+/*
+ * Entities which derive cached data from each other share a change
+ * domain, whose generation is updated whenever one of them changes: the
+ * entities added to a database, and the ones linked to them. Merging a
+ * domain into another makes it forward there, so entities never need to
+ * be updated, and forwarding is only ever set once, so it can be
+ * followed without a lock.
+ */
+struct _OsinfoEntityDomain
+{
+    gint refs;
+    gint generation;
+    OsinfoEntityDomain *forward;
 };
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE(OsinfoEntity, osinfo_entity, G_TYPE_OBJECT);
 
+// Source of domain generations, unique across all domains
+static gint osinfo_entity_generation;
+
+// Serializes domain merges
+static GMutex osinfo_entity_domain_lock;
+
 static void osinfo_entity_finalize(GObject *object);
 
 enum {
@@ -103,6 +131,7 @@ osinfo_entity_finalize(GObject *object)
 
     g_free(entity->priv->id);
     g_hash_table_destroy(entity->priv->params);
+    osinfo_entity_domain_unref(entity->priv->domain);
 
     /* Chain up to the parent class */
     G_OBJECT_CLASS(osinfo_entity_parent_class)->finalize(object);
@@ -152,6 +181,7 @@ osinfo_entity_init(OsinfoEntity *entity)
                                                g_str_equal,
                                                g_free,
                                                osinfo_entity_param_values_free);
+    entity->priv->domain = osinfo_entity_domain_new();
 }
 
 
@@ -175,6 +205,7 @@ void osinfo_entity_set_param(OsinfoEntity *entity, const gchar *key, const gchar
 
     values = g_list_append(values, g_strdup(value));
     g_hash_table_replace(entity->priv->params, g_strdup(key), values);
+    osinfo_entity_changed(entity);
 }
 
 
@@ -276,6 +307,7 @@ void osinfo_entity_add_param(OsinfoEntity *entity, const gchar *key, const gchar
 
     values = g_list_append(values, g_strdup(value));
     g_hash_table_insert(entity->priv->params, g_strdup(key), values);
+    osinfo_entity_changed(entity);
 }
 
 
@@ -290,7 +322,134 @@ void osinfo_entity_clear_param(OsinfoEntity *entity, const gchar *key)
 {
     g_return_if_fail(OSINFO_IS_ENTITY(entity));
 
-    g_hash_table_remove(entity->priv->params, key);
+    if (g_hash_table_remove(entity->priv->params, key))
+        osinfo_entity_changed(entity);
+}
+
+/*
+ * Sets @key to @value like osinfo_entity_set_param(), but without
+ * recording a change. This is meant for values derived from other
+ * entities, which do not affect anything else derived from @entity.
+ */
+void osinfo_entity_fill_param(OsinfoEntity *entity, const gchar *key, const gchar *value)
+{
+    g_hash_table_replace(entity->priv->params, g_strdup(key),
+                         g_list_append(NULL, g_strdup(value)));
+}
+
+/*
+ * Returns a new domain, which a database uses to track the changes of
+ * its entities.
+ */
+OsinfoEntityDomain *osinfo_entity_domain_new(void)
+{
+    OsinfoEntityDomain *domain = g_new0(OsinfoEntityDomain, 1);
+
+    domain->refs = 1;
+    domain->generation = g_atomic_int_add(&osinfo_entity_generation, 1) + 1;
+
+    return domain;
+}
+
+void osinfo_entity_domain_unref(OsinfoEntityDomain *domain)
+{
+    while (domain && g_atomic_int_dec_and_test(&domain->refs)) {
+        OsinfoEntityDomain *forward = domain->forward;
+
+        g_free(domain);
+        domain = forward;
+    }
+}
+
+static OsinfoEntityDomain *osinfo_entity_domain_resolve(OsinfoEntityDomain *domain)
+{
+    OsinfoEntityDomain *forward;
+
+    while ((forward = g_atomic_pointer_get(&domain->forward)))
+        domain = forward;
+
+    return domain;
+}
+
+static void osinfo_entity_domain_bump(OsinfoEntityDomain *domain)
+{
+    g_atomic_int_set(&domain->generation,
+                     g_atomic_int_add(&osinfo_entity_generation, 1) + 1);
+}
+
+/*
+ * Returns a value that changes whenever an entity of @domain is
+ * modified, so caches spanning many entities can tell cheaply that none
+ * of them changed.
+ */
+guint osinfo_entity_domain_get_generation(OsinfoEntityDomain *domain)
+{
+    return g_atomic_int_get(&osinfo_entity_domain_resolve(domain)->generation);
+}
+
+static void osinfo_entity_domain_merge(OsinfoEntityDomain *domain,
+                                       OsinfoEntityDomain *into)
+{
+    g_mutex_lock(&osinfo_entity_domain_lock);
+
+    domain = osinfo_entity_domain_resolve(domain);
+    into = osinfo_entity_domain_resolve(into);
+    if (domain != into) {
+        g_atomic_int_inc(&into->refs);
+        g_atomic_pointer_set(&domain->forward, into);
+        /* Caches of either domain were built against other entities */
+        osinfo_entity_domain_bump(into);
+    }
+
+    g_mutex_unlock(&osinfo_entity_domain_lock);
+}
+
+/*
+ * Makes changes to @entity, and to the entities it shares a domain
+ * with, update the generation of @domain.
+ */
+void osinfo_entity_join_domain(OsinfoEntity *entity, OsinfoEntityDomain *domain)
+{
+    osinfo_entity_domain_merge(entity->priv->domain, domain);
+}
+
+/*
+ * Records that the cached data of @entity or @other depend on the other
+ * one, so that both share a generation. Subclasses call this when
+ * linking entities together.
+ */
+void osinfo_entity_join(OsinfoEntity *entity, OsinfoEntity *other)
+{
+    osinfo_entity_domain_merge(other->priv->domain, entity->priv->domain);
+}
+
+/*
+ * Records a change to @entity. Besides params, which are tracked here,
+ * subclasses call this when links to other entities are added.
+ */
+void osinfo_entity_changed(OsinfoEntity *entity)
+{
+    g_atomic_int_inc(&entity->priv->serial);
+    /* A concurrent merge bumps the domain it forwards to afterwards */
+    osinfo_entity_domain_bump(osinfo_entity_domain_resolve(entity->priv->domain));
+}
+
+/*
+ * Returns a counter that changes whenever the parameters or links of
+ * @entity are modified, allowing data derived from them to be cached.
+ */
+guint osinfo_entity_get_serial(OsinfoEntity *entity)
+{
+    return g_atomic_int_get(&entity->priv->serial);
+}
+
+/*
+ * Returns a value that changes whenever @entity, or an entity it was
+ * joined with, is modified. See osinfo_entity_domain_get_generation().
+ */
+guint osinfo_entity_get_generation(OsinfoEntity *entity)
+{
+    return osinfo_entity_domain_get_generation(entity->priv->domain);
 }
 
 /**
@@ -507,6 +666,17 @@ gint osinfo_entity_get_param_value_enum(OsinfoEntity *entity,
     g_return_val_if_reached(default_value);
 }
 
+/*
+ * Like osinfo_entity_get_param_value_list(), but returns the values stored
+ * in @entity itself, without copying them. The list remains valid until the
+ * values of @key change. The "id" key is not handled.
+ */
+const GList *osinfo_entity_peek_param_value_list(OsinfoEntity *entity,
+                                                 const gchar *key)
+{
+    return g_hash_table_lookup(entity->priv->params, key);
+}
+
 /**
  * osinfo_entity_get_param_value_list:
  * @entity: an #OsinfoEntity containing the parameters
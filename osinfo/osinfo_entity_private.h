@@ -0,0 +1,38 @@
+/*
+ * libosinfo: an entity with a set of named parameters
+ *
+ * Copyright (C) 2009-2020 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <osinfo/osinfo_entity.h>
+
+typedef struct _OsinfoEntityDomain OsinfoEntityDomain;
+
+OsinfoEntityDomain *osinfo_entity_domain_new(void);
+void osinfo_entity_domain_unref(OsinfoEntityDomain *domain);
+guint osinfo_entity_domain_get_generation(OsinfoEntityDomain *domain);
+
+void osinfo_entity_changed(OsinfoEntity *entity);
+void osinfo_entity_fill_param(OsinfoEntity *entity, const gchar *key, const gchar *value);
+guint osinfo_entity_get_serial(OsinfoEntity *entity);
+guint osinfo_entity_get_generation(OsinfoEntity *entity);
+void osinfo_entity_join_domain(OsinfoEntity *entity, OsinfoEntityDomain *domain);
+void osinfo_entity_join(OsinfoEntity *entity, OsinfoEntity *other);
+const GList *osinfo_entity_peek_param_value_list(OsinfoEntity *entity,
+                                                 const gchar *key);
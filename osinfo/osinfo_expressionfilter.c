@@ -0,0 +1,691 @@
+/*
+ * libosinfo:
+ *
+ * Copyright (C) 2009-2020 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <osinfo/osinfo.h>
+#include <glib/gi18n-lib.h>
+#include <string.h>
+#include "osinfo_entity_private.h"
+#include "osinfo_expressionfilter_private.h"
+#include "osinfo_filter_private.h"
+
+/**
+ * SECTION:osinfo_expressionfilter
+ * @short_description: an entity filter built from an expression
+ * @see_also: #OsinfoFilter
+ *
+ * #OsinfoExpressionFilter is a specialization of #OsinfoFilter that
+ * matches entities against an expression. Conditions compare entity
+ * properties using more operators than equality, and are combined
+ * with each other, or with other filters, using AND, OR and NOT.
+ *
+ * Expressions are either built with the constructors of this class, or
+ * parsed from a string such as
+ *
+ * |[
+ * vendor="Fedora Project" and (version>=30 or short-id^=silverblue)
+ * ]|
+ *
+ * A condition is a property name, an operator and a value. The operators
+ * are "=", "!=", "^=" (prefix), "~" (regular expression), "<", "<=", ">"
+ * and ">=". Values containing spaces, parentheses or any of the "&", "|",
+ * "!", "<", ">" and "=" characters must be quoted with single or double
+ * quotes, so that "distro=fedora&&version>=30" needs no spaces.
+ * Conditions are combined with "and" or "&&", "or" or "||", negated with
+ * "not" or "!", and grouped with parentheses.
+ *
+ * A condition on a property having several values matches if any of the
+ * values satisfies it, except for "!=", which is a negated "=" and thus
+ * matches if no value equals the operand. Property constraints added to
+ * the filter with osinfo_filter_add_constraint() have to match as well.
+ *
+ * When filtering the lists returned by #OsinfoDb, the database property
+ * indexes are used to only check the entities which can match.
+ */
+
+struct _OsinfoExpressionFilterPrivate
+{
+    OsinfoExpressionFilterKind kind;
+
+    /* COMPARE nodes, property is interned */
+    const gchar *property;
+    OsinfoExpressionFilterOperator op;
+    gchar *value;
+    GRegex *regex;
+
+    /* AND, OR and NOT nodes, right is NULL for NOT */
+    OsinfoFilter *left;
+    OsinfoFilter *right;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE(OsinfoExpressionFilter, osinfo_expressionfilter, OSINFO_TYPE_FILTER);
+
+static gboolean osinfo_expressionfilter_matches_default(OsinfoFilter *filter, OsinfoEntity *entity);
+static void osinfo_expressionfilter_compile_default(OsinfoFilter *filter);
+
+/* OSINFO_ENTITY_PROP_ID, interned */
+static const gchar *osinfo_expressionfilter_id_key;
+
+static void
+osinfo_expressionfilter_finalize(GObject *object)
+{
+    OsinfoExpressionFilter *filter = OSINFO_EXPRESSIONFILTER(object);
+
+    g_free(filter->priv->value);
+    if (filter->priv->regex)
+        g_regex_unref(filter->priv->regex);
+    g_clear_object(&filter->priv->left);
+    g_clear_object(&filter->priv->right);
+
+    /* Chain up to the parent class */
+    G_OBJECT_CLASS(osinfo_expressionfilter_parent_class)->finalize(object);
+}
+
+/* Init functions */
+static void
+osinfo_expressionfilter_class_init(OsinfoExpressionFilterClass *klass)
+{
+    GObjectClass *g_klass = G_OBJECT_CLASS(klass);
+    OsinfoFilterClass *filter_klass = OSINFO_FILTER_CLASS(klass);
+
+    g_klass->finalize = osinfo_expressionfilter_finalize;
+
+    filter_klass->matches = osinfo_expressionfilter_matches_default;
+    osinfo_filter_class_set_compile_func(filter_klass,
+                                         osinfo_expressionfilter_compile_default);
+
+    osinfo_expressionfilter_id_key = g_intern_static_string(OSINFO_ENTITY_PROP_ID);
+}
+
+
+static void
+osinfo_expressionfilter_init(OsinfoExpressionFilter *filter)
+{
+    filter->priv = osinfo_expressionfilter_get_instance_private(filter);
+}
+
+
+/**
+ * osinfo_expressionfilter_new_compare:
+ * @propName: the name of the property
+ * @op: how the property values are compared to @propVal
+ * @propVal: the value to compare the property values to
+ * @error: return location for a #GError, or NULL
+ *
+ * Construct a new filter that matches entities with a value of
+ * @propName satisfying @op against @propVal.
+ *
+ * Returns: (transfer full): a new filter, or NULL if @op is
+ * OSINFO_EXPRESSION_FILTER_OPERATOR_REGEX and @propVal is not a
+ * valid regular expression
+ *
+ * Since: 1.13.0
+ */
+OsinfoExpressionFilter *osinfo_expressionfilter_new_compare(const gchar *propName,
+                                                            OsinfoExpressionFilterOperator op,
+                                                            const gchar *propVal,
+                                                            GError **error)
+{
+    OsinfoExpressionFilter *filter;
+    GRegex *regex = NULL;
+
+    g_return_val_if_fail(propName != NULL, NULL);
+    g_return_val_if_fail(propVal != NULL, NULL);
+
+    if (op == OSINFO_EXPRESSION_FILTER_OPERATOR_REGEX) {
+        regex = g_regex_new(propVal, G_REGEX_OPTIMIZE, 0, error);
+        if (regex == NULL)
+            return NULL;
+    }
+
+    filter = g_object_new(OSINFO_TYPE_EXPRESSIONFILTER, NULL);
+    filter->priv->kind = OSINFO_EXPRESSION_FILTER_KIND_COMPARE;
+    filter->priv->property = g_intern_string(propName);
+    filter->priv->op = op;
+    filter->priv->value = g_strdup(propVal);
+    filter->priv->regex = regex;
+
+    return filter;
+}
+
+
+static OsinfoExpressionFilter *
+osinfo_expressionfilter_new_operation(OsinfoExpressionFilterKind kind,
+                                      OsinfoFilter *left,
+                                      OsinfoFilter *right)
+{
+    OsinfoExpressionFilter *filter = g_object_new(OSINFO_TYPE_EXPRESSIONFILTER, NULL);
+
+    filter->priv->kind = kind;
+    filter->priv->left = g_object_ref(left);
+    if (right)
+        filter->priv->right = g_object_ref(right);
+
+    return filter;
+}
+
+
+/**
+ * osinfo_expressionfilter_new_and:
+ * @left: (transfer none): a filter
+ * @right: (transfer none): another filter
+ *
+ * Construct a new filter that matches entities matched by both
+ * @left and @right.
+ *
+ * Returns: (transfer full): a new filter
+ *
+ * Since: 1.13.0
+ */
+OsinfoExpressionFilter *osinfo_expressionfilter_new_and(OsinfoFilter *left,
+                                                        OsinfoFilter *right)
+{
+    g_return_val_if_fail(OSINFO_IS_FILTER(left), NULL);
+    g_return_val_if_fail(OSINFO_IS_FILTER(right), NULL);
+
+    return osinfo_expressionfilter_new_operation(OSINFO_EXPRESSION_FILTER_KIND_AND,
+                                                 left, right);
+}
+
+
+/**
+ * osinfo_expressionfilter_new_or:
+ * @left: (transfer none): a filter
+ * @right: (transfer none): another filter
+ *
+ * Construct a new filter that matches entities matched by either
+ * @left or @right.
+ *
+ * Returns: (transfer full): a new filter
+ *
+ * Since: 1.13.0
+ */
+OsinfoExpressionFilter *osinfo_expressionfilter_new_or(OsinfoFilter *left,
+                                                       OsinfoFilter *right)
+{
+    g_return_val_if_fail(OSINFO_IS_FILTER(left), NULL);
+    g_return_val_if_fail(OSINFO_IS_FILTER(right), NULL);
+
+    return osinfo_expressionfilter_new_operation(OSINFO_EXPRESSION_FILTER_KIND_OR,
+                                                 left, right);
+}
+
+
+/**
+ * osinfo_expressionfilter_new_not:
+ * @operand: (transfer none): a filter
+ *
+ * Construct a new filter that matches entities not matched by
+ * @operand.
+ *
+ * Returns: (transfer full): a new filter
+ *
+ * Since: 1.13.0
+ */
+OsinfoExpressionFilter *osinfo_expressionfilter_new_not(OsinfoFilter *operand)
+{
+    g_return_val_if_fail(OSINFO_IS_FILTER(operand), NULL);
+
+    return osinfo_expressionfilter_new_operation(OSINFO_EXPRESSION_FILTER_KIND_NOT,
+                                                 operand, NULL);
+}
+
+
+typedef struct _OsinfoExpressionParser OsinfoExpressionParser;
+struct _OsinfoExpressionParser
+{
+    const gchar *expression;
+    const gchar *pos;
+};
+
+static OsinfoFilter *osinfo_expression_parser_or(OsinfoExpressionParser *parser,
+                                                 GError **error);
+
+static void osinfo_expression_parser_error(OsinfoExpressionParser *parser,
+                                           const gchar *message,
+                                           GError **error)
+{
+    g_set_error(error, OSINFO_ERROR, 0,
+                _("%s at offset %d of expression '%s'"),
+                message, (int)(parser->pos - parser->expression),
+                parser->expression);
+}
+
+static gboolean osinfo_expression_parser_is_name_char(gchar c)
+{
+    return g_ascii_isalnum(c) || c == '-' || c == '_' || c == '.';
+}
+
+/* Whether @c ends an unquoted value, as it may start an operator */
+static gboolean osinfo_expression_parser_is_value_end(gchar c)
+{
+    return c == '\0' || g_ascii_isspace(c) || strchr("()&|!<>=", c) != NULL;
+}
+
+static void osinfo_expression_parser_skip_spaces(OsinfoExpressionParser *parser)
+{
+    while (g_ascii_isspace(*parser->pos))
+        parser->pos++;
+}
+
+/* Consumes @token if it comes next, keywords must not be followed by a name */
+static gboolean osinfo_expression_parser_accept(OsinfoExpressionParser *parser,
+                                                const gchar *token)
+{
+    gsize len = strlen(token);
+
+    osinfo_expression_parser_skip_spaces(parser);
+
+    if (strncmp(parser->pos, token, len) != 0)
+        return FALSE;
+    if (g_ascii_isalpha(token[0]) &&
+        osinfo_expression_parser_is_name_char(parser->pos[len]))
+        return FALSE;
+
+    parser->pos += len;
+    return TRUE;
+}
+
+static gchar *osinfo_expression_parser_value(OsinfoExpressionParser *parser,
+                                             GError **error)
+{
+    const gchar *start;
+
+    osinfo_expression_parser_skip_spaces(parser);
+
+    if (*parser->pos == '"' || *parser->pos == '\'') {
+        gchar quote = *parser->pos;
+        GString *value = g_string_new(NULL);
+
+        parser->pos++;
+        while (*parser->pos != quote) {
+            if (*parser->pos == '\0') {
+                osinfo_expression_parser_error(parser, _("Unterminated quoted value"), error);
+                g_string_free(value, TRUE);
+                return NULL;
+            }
+            /* Only the quote and the backslash itself can be escaped */
+            if (*parser->pos == '\\' &&
+                (parser->pos[1] == quote || parser->pos[1] == '\\'))
+                parser->pos++;
+            g_string_append_c(value, *parser->pos);
+            parser->pos++;
+        }
+        parser->pos++;
+
+        return g_string_free(value, FALSE);
+    }
+
+    start = parser->pos;
+    while (!osinfo_expression_parser_is_value_end(*parser->pos))
+        parser->pos++;
+
+    if (parser->pos == start) {
+        osinfo_expression_parser_error(parser, _("Expected a value"), error);
+        return NULL;
+    }
+
+    return g_strndup(start, parser->pos - start);
+}
+
+static OsinfoFilter *osinfo_expression_parser_compare(OsinfoExpressionParser *parser,
+                                                      GError **error)
+{
+    static const struct {
+        const gchar *token;
+        OsinfoExpressionFilterOperator op;
+        gboolean negate;
+    } operators[] = {
+        /* Longest tokens first */
+        { "<=", OSINFO_EXPRESSION_FILTER_OPERATOR_LESS_EQUAL, FALSE },
+        { ">=", OSINFO_EXPRESSION_FILTER_OPERATOR_GREATER_EQUAL, FALSE },
+        { "!=", OSINFO_EXPRESSION_FILTER_OPERATOR_EQUAL, TRUE },
+        { "^=", OSINFO_EXPRESSION_FILTER_OPERATOR_PREFIX, FALSE },
+        { "=", OSINFO_EXPRESSION_FILTER_OPERATOR_EQUAL, FALSE },
+        { "<", OSINFO_EXPRESSION_FILTER_OPERATOR_LESS, FALSE },
+        { ">", OSINFO_EXPRESSION_FILTER_OPERATOR_GREATER, FALSE },
+        { "~", OSINFO_EXPRESSION_FILTER_OPERATOR_REGEX, FALSE },
+    };
+    OsinfoFilter *filter = NULL;
+    const gchar *start;
+    gchar *name = NULL;
+    gchar *value = NULL;
+    gsize i;
+
+    osinfo_expression_parser_skip_spaces(parser);
+
+    start = parser->pos;
+    while (osinfo_expression_parser_is_name_char(*parser->pos))
+        parser->pos++;
+
+    if (parser->pos == start) {
+        osinfo_expression_parser_error(parser, _("Expected a property name"), error);
+        return NULL;
+    }
+    name = g_strndup(start, parser->pos - start);
+
+    for (i = 0; i < G_N_ELEMENTS(operators); i++) {
+        if (osinfo_expression_parser_accept(parser, operators[i].token))
+            break;
+    }
+    if (i == G_N_ELEMENTS(operators)) {
+        osinfo_expression_parser_error(parser, _("Expected a comparison operator"), error);
+        goto cleanup;
+    }
+
+    if (!(value = osinfo_expression_parser_value(parser, error)))
+        goto cleanup;
+
+    filter = OSINFO_FILTER(osinfo_expressionfilter_new_compare(name,
+                                                               operators[i].op,
+                                                               value,
+                                                               error));
+    if (filter && operators[i].negate) {
+        OsinfoFilter *negated = OSINFO_FILTER(osinfo_expressionfilter_new_not(filter));
+
+        g_object_unref(filter);
+        filter = negated;
+    }
+
+ cleanup:
+    g_free(name);
+    g_free(value);
+    return filter;
+}
+
+static OsinfoFilter *osinfo_expression_parser_unary(OsinfoExpressionParser *parser,
+                                                    GError **error)
+{
+    OsinfoFilter *filter;
+
+    if (osinfo_expression_parser_accept(parser, "not") ||
+        osinfo_expression_parser_accept(parser, "!")) {
+        OsinfoFilter *operand = osinfo_expression_parser_unary(parser, error);
+
+        if (operand == NULL)
+            return NULL;
+
+        filter = OSINFO_FILTER(osinfo_expressionfilter_new_not(operand));
+        g_object_unref(operand);
+        return filter;
+    }
+
+    if (osinfo_expression_parser_accept(parser, "(")) {
+        if (!(filter = osinfo_expression_parser_or(parser, error)))
+            return NULL;
+
+        if (!osinfo_expression_parser_accept(parser, ")")) {
+            osinfo_expression_parser_error(parser, _("Expected ')'"), error);
+            g_object_unref(filter);
+            return NULL;
+        }
+        return filter;
+    }
+
+    return osinfo_expression_parser_compare(parser, error);
+}
+
+static OsinfoFilter *osinfo_expression_parser_and(OsinfoExpressionParser *parser,
+                                                  GError **error)
+{
+    OsinfoFilter *filter = osinfo_expression_parser_unary(parser, error);
+
+    if (filter == NULL)
+        return NULL;
+
+    while (osinfo_expression_parser_accept(parser, "and") ||
+           osinfo_expression_parser_accept(parser, "&&")) {
+        OsinfoFilter *right = osinfo_expression_parser_unary(parser, error);
+        OsinfoFilter *left = filter;
+
+        if (right == NULL) {
+            g_object_unref(left);
+            return NULL;
+        }
+
+        filter = OSINFO_FILTER(osinfo_expressionfilter_new_and(left, right));
+        g_object_unref(left);
+        g_object_unref(right);
+    }
+
+    return filter;
+}
+
+static OsinfoFilter *osinfo_expression_parser_or(OsinfoExpressionParser *parser,
+                                                 GError **error)
+{
+    OsinfoFilter *filter = osinfo_expression_parser_and(parser, error);
+
+    if (filter == NULL)
+        return NULL;
+
+    while (osinfo_expression_parser_accept(parser, "or") ||
+           osinfo_expression_parser_accept(parser, "||")) {
+        OsinfoFilter *right = osinfo_expression_parser_and(parser, error);
+        OsinfoFilter *left = filter;
+
+        if (right == NULL) {
+            g_object_unref(left);
+            return NULL;
+        }
+
+        filter = OSINFO_FILTER(osinfo_expressionfilter_new_or(left, right));
+        g_object_unref(left);
+        g_object_unref(right);
+    }
+
+    return filter;
+}
+
+
+/**
+ * osinfo_expressionfilter_new_from_string:
+ * @expression: the expression to parse
+ * @error: return location for a #GError, or NULL
+ *
+ * Construct a new filter from @expression, using the syntax described
+ * in the #OsinfoExpressionFilter overview.
+ *
+ * Returns: (transfer full): a new filter, or NULL if @expression
+ * cannot be parsed
+ *
+ * Since: 1.13.0
+ */
+OsinfoExpressionFilter *osinfo_expressionfilter_new_from_string(const gchar *expression,
+                                                                GError **error)
+{
+    OsinfoExpressionParser parser = { expression, expression };
+    OsinfoFilter *filter;
+
+    g_return_val_if_fail(expression != NULL, NULL);
+
+    if (!(filter = osinfo_expression_parser_or(&parser, error)))
+        return NULL;
+
+    osinfo_expression_parser_skip_spaces(&parser);
+    if (*parser.pos != '\0') {
+        osinfo_expression_parser_error(&parser, _("Unexpected trailing input"), error);
+        g_object_unref(filter);
+        return NULL;
+    }
+
+    return OSINFO_EXPRESSIONFILTER(filter);
+}
+
+
+/*
+ * Compares @a and @b as version strings: runs of digits are compared
+ * numerically, other characters one by one.
+ */
+static gint osinfo_expressionfilter_compare_versions(const gchar *a,
+                                                     const gchar *b)
+{
+    while (*a != '\0' && *b != '\0') {
+        if (g_ascii_isdigit(*a) && g_ascii_isdigit(*b)) {
+            const gchar *astart, *bstart;
+            gsize alen, blen;
+            gint ret;
+
+            while (*a == '0')
+                a++;
+            while (*b == '0')
+                b++;
+
+            astart = a;
+            while (g_ascii_isdigit(*a))
+                a++;
+            bstart = b;
+            while (g_ascii_isdigit(*b))
+                b++;
+            alen = a - astart;
+            blen = b - bstart;
+
+            if (alen != blen)
+                return alen < blen ? -1 : 1;
+            if ((ret = memcmp(astart, bstart, alen)) != 0)
+                return ret < 0 ? -1 : 1;
+        } else {
+            if (*a != *b)
+                return (guchar)*a < (guchar)*b ? -1 : 1;
+            a++;
+            b++;
+        }
+    }
+
+    return (*a != '\0') - (*b != '\0');
+}
+
+
+/*
+ * Whether @value satisfies the condition of the COMPARE node @filter.
+ */
+gboolean osinfo_expressionfilter_compare_value(OsinfoExpressionFilter *filter,
+                                               const gchar *value)
+{
+    OsinfoExpressionFilterPrivate *priv = filter->priv;
+
+    if (value == NULL)
+        return FALSE;
+
+    switch (priv->op) {
+    case OSINFO_EXPRESSION_FILTER_OPERATOR_EQUAL:
+        return g_str_equal(value, priv->value);
+    case OSINFO_EXPRESSION_FILTER_OPERATOR_PREFIX:
+        return g_str_has_prefix(value, priv->value);
+    case OSINFO_EXPRESSION_FILTER_OPERATOR_REGEX:
+        return g_regex_match(priv->regex, value, 0, NULL);
+    case OSINFO_EXPRESSION_FILTER_OPERATOR_LESS:
+        return osinfo_expressionfilter_compare_versions(value, priv->value) < 0;
+    case OSINFO_EXPRESSION_FILTER_OPERATOR_LESS_EQUAL:
+        return osinfo_expressionfilter_compare_versions(value, priv->value) <= 0;
+    case OSINFO_EXPRESSION_FILTER_OPERATOR_GREATER:
+        return osinfo_expressionfilter_compare_versions(value, priv->value) > 0;
+    case OSINFO_EXPRESSION_FILTER_OPERATOR_GREATER_EQUAL:
+        return osinfo_expressionfilter_compare_versions(value, priv->value) >= 0;
+    default:
+        break;
+    }
+
+    g_return_val_if_reached(FALSE);
+}
+
+
+static gboolean osinfo_expressionfilter_matches_default(OsinfoFilter *filter, OsinfoEntity *entity)
+{
+    OsinfoExpressionFilter *exprfilter;
+    const GList *values;
+
+    g_return_val_if_fail(OSINFO_IS_EXPRESSIONFILTER(filter), FALSE);
+    g_return_val_if_fail(OSINFO_IS_ENTITY(entity), FALSE);
+
+    if (!OSINFO_FILTER_CLASS(osinfo_expressionfilter_parent_class)->matches(filter, entity))
+        return FALSE;
+
+    exprfilter = OSINFO_EXPRESSIONFILTER(filter);
+
+    switch (exprfilter->priv->kind) {
+    case OSINFO_EXPRESSION_FILTER_KIND_COMPARE:
+        if (exprfilter->priv->property == osinfo_expressionfilter_id_key)
+            return osinfo_expressionfilter_compare_value(exprfilter,
+                                                         osinfo_entity_get_id(entity));
+
+        values = osinfo_entity_peek_param_value_list(entity, exprfilter->priv->property);
+        for (; values; values = values->next) {
+            if (osinfo_expressionfilter_compare_value(exprfilter, values->data))
+                return TRUE;
+        }
+        return FALSE;
+
+    case OSINFO_EXPRESSION_FILTER_KIND_AND:
+        return osinfo_filter_matches(exprfilter->priv->left, entity) &&
+            osinfo_filter_matches(exprfilter->priv->right, entity);
+
+    case OSINFO_EXPRESSION_FILTER_KIND_OR:
+        return osinfo_filter_matches(exprfilter->priv->left, entity) ||
+            osinfo_filter_matches(exprfilter->priv->right, entity);
+
+    case OSINFO_EXPRESSION_FILTER_KIND_NOT:
+        return !osinfo_filter_matches(exprfilter->priv->left, entity);
+
+    default:
+        break;
+    }
+
+    g_return_val_if_reached(FALSE);
+}
+
+
+static void osinfo_expressionfilter_compile_default(OsinfoFilter *filter)
+{
+    OsinfoExpressionFilter *exprfilter = OSINFO_EXPRESSIONFILTER(filter);
+
+    if (exprfilter->priv->left)
+        osinfo_filter_compile(exprfilter->priv->left);
+    if (exprfilter->priv->right)
+        osinfo_filter_compile(exprfilter->priv->right);
+}
+
+
+OsinfoExpressionFilterKind osinfo_expressionfilter_get_kind(OsinfoExpressionFilter *filter)
+{
+    return filter->priv->kind;
+}
+
+void osinfo_expressionfilter_get_operands(OsinfoExpressionFilter *filter,
+                                          OsinfoFilter **left,
+                                          OsinfoFilter **right)
+{
+    *left = filter->priv->left;
+    *right = filter->priv->right;
+}
+
+const gchar *osinfo_expressionfilter_get_property(OsinfoExpressionFilter *filter)
+{
+    return filter->priv->property;
+}
+
+OsinfoExpressionFilterOperator osinfo_expressionfilter_get_operator(OsinfoExpressionFilter *filter)
+{
+    return filter->priv->op;
+}
+
+const gchar *osinfo_expressionfilter_get_value(OsinfoExpressionFilter *filter)
+{
+    return filter->priv->value;
+}
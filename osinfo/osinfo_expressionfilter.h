@@ -0,0 +1,78 @@
+/*
+ * libosinfo: a mechanism to filter entities with expressions
+ *
+ * Copyright (C) 2009-2020 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib-object.h>
+#include <osinfo/osinfo_filter.h>
+#include <osinfo/osinfo_macros.h>
+
+#define OSINFO_TYPE_EXPRESSIONFILTER (osinfo_expressionfilter_get_type ())
+OSINFO_DECLARE_TYPE_WITH_PRIVATE_AND_CLASS(OsinfoExpressionFilter,
+                                           osinfo_expressionfilter,
+                                           OSINFO,
+                                           EXPRESSIONFILTER,
+                                           OsinfoFilter)
+
+/**
+ * OsinfoExpressionFilterOperator:
+ * @OSINFO_EXPRESSION_FILTER_OPERATOR_EQUAL: the property value is equal
+ * to the operand
+ * @OSINFO_EXPRESSION_FILTER_OPERATOR_PREFIX: the property value starts
+ * with the operand
+ * @OSINFO_EXPRESSION_FILTER_OPERATOR_REGEX: the property value matches
+ * the operand as a regular expression
+ * @OSINFO_EXPRESSION_FILTER_OPERATOR_LESS: the property value sorts
+ * before the operand
+ * @OSINFO_EXPRESSION_FILTER_OPERATOR_LESS_EQUAL: the property value sorts
+ * before or equal to the operand
+ * @OSINFO_EXPRESSION_FILTER_OPERATOR_GREATER: the property value sorts
+ * after the operand
+ * @OSINFO_EXPRESSION_FILTER_OPERATOR_GREATER_EQUAL: the property value
+ * sorts after or equal to the operand
+ *
+ * How a property value is compared to the operand of an expression.
+ * Ordering operators compare values as version strings: runs of digits
+ * are compared numerically and other characters one by one, so numbers,
+ * versions and dates all sort naturally.
+ *
+ * Since: 1.13.0
+ */
+typedef enum {
+    OSINFO_EXPRESSION_FILTER_OPERATOR_EQUAL,
+    OSINFO_EXPRESSION_FILTER_OPERATOR_PREFIX,
+    OSINFO_EXPRESSION_FILTER_OPERATOR_REGEX,
+    OSINFO_EXPRESSION_FILTER_OPERATOR_LESS,
+    OSINFO_EXPRESSION_FILTER_OPERATOR_LESS_EQUAL,
+    OSINFO_EXPRESSION_FILTER_OPERATOR_GREATER,
+    OSINFO_EXPRESSION_FILTER_OPERATOR_GREATER_EQUAL,
+} OsinfoExpressionFilterOperator;
+
+OsinfoExpressionFilter *osinfo_expressionfilter_new_from_string(const gchar *expression,
+                                                                GError **error);
+OsinfoExpressionFilter *osinfo_expressionfilter_new_compare(const gchar *propName,
+                                                            OsinfoExpressionFilterOperator op,
+                                                            const gchar *propVal,
+                                                            GError **error);
+OsinfoExpressionFilter *osinfo_expressionfilter_new_and(OsinfoFilter *left,
+                                                        OsinfoFilter *right);
+OsinfoExpressionFilter *osinfo_expressionfilter_new_or(OsinfoFilter *left,
+                                                       OsinfoFilter *right);
+OsinfoExpressionFilter *osinfo_expressionfilter_new_not(OsinfoFilter *operand);
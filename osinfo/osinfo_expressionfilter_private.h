@@ -0,0 +1,44 @@
+/*
+ * libosinfo: a mechanism to filter entities with expressions
+ *
+ * Copyright (C) 2009-2020 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <osinfo/osinfo_expressionfilter.h>
+
+typedef enum {
+    OSINFO_EXPRESSION_FILTER_KIND_COMPARE,
+    OSINFO_EXPRESSION_FILTER_KIND_AND,
+    OSINFO_EXPRESSION_FILTER_KIND_OR,
+    OSINFO_EXPRESSION_FILTER_KIND_NOT,
+} OsinfoExpressionFilterKind;
+
+OsinfoExpressionFilterKind osinfo_expressionfilter_get_kind(OsinfoExpressionFilter *filter);
+
+/* The operands of binary nodes, @right is NULL for NOT nodes */
+void osinfo_expressionfilter_get_operands(OsinfoExpressionFilter *filter,
+                                          OsinfoFilter **left,
+                                          OsinfoFilter **right);
+
+/* The property compared by COMPARE nodes */
+const gchar *osinfo_expressionfilter_get_property(OsinfoExpressionFilter *filter);
+OsinfoExpressionFilterOperator osinfo_expressionfilter_get_operator(OsinfoExpressionFilter *filter);
+const gchar *osinfo_expressionfilter_get_value(OsinfoExpressionFilter *filter);
+gboolean osinfo_expressionfilter_compare_value(OsinfoExpressionFilter *filter,
+                                               const gchar *value);
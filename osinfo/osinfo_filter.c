@@ -20,6 +20,9 @@
 
 #include <osinfo/osinfo.h>
 #include <glib/gi18n-lib.h>
+#include <stdlib.h>
+#include "osinfo_entity_private.h"
+#include "osinfo_filter_private.h"
 
 /**
  * SECTION:osinfo_filter
@@ -35,18 +38,42 @@ struct _OsinfoFilterPrivate
     // Key: Constraint name
     // Value: GList of constraint values
     GHashTable *propertyConstraints;
+
+    /* Flat form of propertyConstraints, referencing its strings, built
+     * by osinfo_filter_compile() and dropped when a constraint changes */
+    OsinfoFilterConstraint *program;
+    gsize programLength;
+    gint compiled;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE(OsinfoFilter, osinfo_filter, G_TYPE_OBJECT);
 
 static void osinfo_filter_finalize(GObject *object);
 static gboolean osinfo_filter_matches_default(OsinfoFilter *filter, OsinfoEntity *entity);
+static void osinfo_filter_program_free(OsinfoFilter *filter);
+
+/* Protects the compilation of all filters */
+static GMutex osinfo_filter_compile_lock;
+/* OSINFO_ENTITY_PROP_ID, interned */
+static const gchar *osinfo_filter_id_key;
+
+static GQuark
+osinfo_filter_compile_quark(void)
+{
+    static GQuark quark;
+
+    if (!quark)
+        quark = g_quark_from_static_string("osinfo-filter-compile");
+
+    return quark;
+}
 
 static void
 osinfo_filter_finalize(GObject *object)
 {
     OsinfoFilter *filter = OSINFO_FILTER(object);
 
+    osinfo_filter_program_free(filter);
     g_hash_table_unref(filter->priv->propertyConstraints);
 
     /* Chain up to the parent class */
@@ -62,6 +89,8 @@ osinfo_filter_class_init(OsinfoFilterClass *klass)
     g_klass->finalize = osinfo_filter_finalize;
 
     klass->matches = osinfo_filter_matches_default;
+
+    osinfo_filter_id_key = g_intern_static_string(OSINFO_ENTITY_PROP_ID);
 }
 
 
@@ -132,6 +161,7 @@ void osinfo_filter_add_constraint(OsinfoFilter *filter,
     }
     values = g_list_prepend(values, g_strdup(propVal));
     g_hash_table_insert(filter->priv->propertyConstraints, g_strdup(propName), values);
+    osinfo_filter_program_free(filter);
 }
 
 
@@ -148,6 +178,7 @@ void osinfo_filter_clear_constraint(OsinfoFilter *filter, const gchar *propName)
     g_return_if_fail(OSINFO_IS_FILTER(filter));
 
     g_hash_table_remove(filter->priv->propertyConstraints, propName);
+    osinfo_filter_program_free(filter);
 }
 
 
@@ -162,6 +193,7 @@ void osinfo_filter_clear_constraints(OsinfoFilter *filter)
     g_return_if_fail(OSINFO_IS_FILTER(filter));
 
     g_hash_table_remove_all(filter->priv->propertyConstraints);
+    osinfo_filter_program_free(filter);
 }
 
 /**
@@ -201,67 +233,203 @@ GList *osinfo_filter_get_constraint_values(OsinfoFilter *filter, const gchar *pr
 }
 
 
-struct osinfo_filter_match_args {
-    OsinfoFilter *filter;
-    OsinfoEntity *entity;
-    gboolean matched;
-};
+static void osinfo_filter_program_free(OsinfoFilter *filter)
+{
+    gsize i;
 
-static void osinfo_filter_match_iterator(gpointer key, gpointer value, gpointer data)
+    for (i = 0; i < filter->priv->programLength; i++)
+        g_free(filter->priv->program[i].values);
+    g_clear_pointer(&filter->priv->program, g_free);
+    filter->priv->programLength = 0;
+    g_atomic_int_set(&filter->priv->compiled, FALSE);
+}
+
+
+static int osinfo_filter_constraint_compare(const void *a, const void *b)
 {
-    struct osinfo_filter_match_args *args = data;
-    OsinfoEntity *entity = args->entity;
-    const gchar *propName = key;
-    GList *propValues = value;
+    const OsinfoFilterConstraint *aconstraint = a;
+    const OsinfoFilterConstraint *bconstraint = b;
+    gboolean aid = aconstraint->key == osinfo_filter_id_key;
+    gboolean bid = bconstraint->key == osinfo_filter_id_key;
+
+    if (aid != bid)
+        return aid ? -1 : 1;
+
+    if (aconstraint->nvalues != bconstraint->nvalues)
+        return aconstraint->nvalues < bconstraint->nvalues ? -1 : 1;
+
+    return 0;
+}
 
-    GList *values = osinfo_entity_get_param_value_list(entity, propName);
 
-    if (propValues && !values) {
-        args->matched = FALSE;
+static void osinfo_filter_ensure_compiled(OsinfoFilter *filter)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+    gsize i = 0;
+
+    if (g_atomic_int_get(&filter->priv->compiled))
         return;
-    }
 
-    while (propValues) {
-        const gchar *propValue = propValues->data;
-        gboolean found = FALSE;
-        GList *tmp = values;
-        while (tmp) {
-            const gchar *testValue = tmp->data;
-            if (g_strcmp0(propValue, testValue) == 0) {
-                found = TRUE;
-                break;
-            }
+    g_mutex_lock(&osinfo_filter_compile_lock);
+    if (filter->priv->compiled)
+        goto cleanup;
+
+    filter->priv->programLength = g_hash_table_size(filter->priv->propertyConstraints);
+    filter->priv->program = g_new0(OsinfoFilterConstraint,
+                                   filter->priv->programLength);
+
+    g_hash_table_iter_init(&iter, filter->priv->propertyConstraints);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        OsinfoFilterConstraint *constraint = &filter->priv->program[i++];
+        GList *tmp;
+
+        constraint->key = g_intern_string(key);
+        constraint->values = g_new0(const gchar *, g_list_length(value));
 
-            tmp = tmp->next;
+        /* Repeating a value does not make it required more than once */
+        for (tmp = value; tmp; tmp = tmp->next) {
+            gsize j;
+
+            for (j = 0; j < constraint->nvalues; j++) {
+                if (g_str_equal(constraint->values[j], tmp->data))
+                    break;
+            }
+            if (j == constraint->nvalues)
+                constraint->values[constraint->nvalues++] = tmp->data;
         }
-        if (!found) {
-            args->matched = FALSE;
-            g_list_free(values);
-            return;
+    }
+
+    /* Check the cheapest constraints first */
+    qsort(filter->priv->program, filter->priv->programLength,
+          sizeof(OsinfoFilterConstraint), osinfo_filter_constraint_compare);
+
+    g_atomic_int_set(&filter->priv->compiled, TRUE);
+
+ cleanup:
+    g_mutex_unlock(&osinfo_filter_compile_lock);
+}
+
+
+static gboolean osinfo_filter_constraint_matches(const OsinfoFilterConstraint *constraint,
+                                                 OsinfoEntity *entity)
+{
+    const GList *values;
+    gsize i;
+
+    if (constraint->key == osinfo_filter_id_key) {
+        const gchar *id = osinfo_entity_get_id(entity);
+
+        for (i = 0; i < constraint->nvalues; i++) {
+            if (g_strcmp0(constraint->values[i], id) != 0)
+                return FALSE;
         }
+        return TRUE;
+    }
+
+    values = osinfo_entity_peek_param_value_list(entity, constraint->key);
+    for (i = 0; i < constraint->nvalues; i++) {
+        const GList *tmp;
 
-        propValues = propValues->next;
+        for (tmp = values; tmp; tmp = tmp->next) {
+            if (g_strcmp0(constraint->values[i], tmp->data) == 0)
+                break;
+        }
+        if (tmp == NULL)
+            return FALSE;
     }
-    g_list_free(values);
+
+    return TRUE;
 }
 
 
 static gboolean osinfo_filter_matches_default(OsinfoFilter *filter, OsinfoEntity *entity)
 {
-    struct osinfo_filter_match_args args;
+    gsize i;
 
     g_return_val_if_fail(OSINFO_IS_FILTER(filter), FALSE);
     g_return_val_if_fail(OSINFO_IS_ENTITY(entity), FALSE);
 
-    args.filter = filter;
-    args.entity = entity;
-    args.matched = TRUE;
+    osinfo_filter_ensure_compiled(filter);
+
+    for (i = 0; i < filter->priv->programLength; i++) {
+        if (!osinfo_filter_constraint_matches(&filter->priv->program[i], entity))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/*
+ * Returns the property constraints of @filter in compiled form, valid
+ * until its constraints change.
+ */
+const OsinfoFilterConstraint *osinfo_filter_get_compiled_constraints(OsinfoFilter *filter,
+                                                                     gsize *nconstraints)
+{
+    osinfo_filter_ensure_compiled(filter);
+
+    *nconstraints = filter->priv->programLength;
+    return filter->priv->program;
+}
+
+
+/*
+ * Registers @compile to compile the state which the type of @klass adds
+ * to its parent. It is run by osinfo_filter_compile() after the property
+ * constraints and the state of the parent types are compiled, so it must
+ * not chain up. Types without one are only matched by their matches()
+ * implementation.
+ */
+void osinfo_filter_class_set_compile_func(OsinfoFilterClass *klass,
+                                          OsinfoFilterCompileFunc compile)
+{
+    g_type_set_qdata(G_TYPE_FROM_CLASS(klass),
+                     osinfo_filter_compile_quark(),
+                     (gpointer)compile);
+}
+
+
+/* Compiles the state of @filter added by @type and its parent types */
+static void osinfo_filter_compile_type(OsinfoFilter *filter, GType type)
+{
+    OsinfoFilterCompileFunc compile;
+
+    if (type == OSINFO_TYPE_FILTER) {
+        osinfo_filter_ensure_compiled(filter);
+        return;
+    }
+
+    osinfo_filter_compile_type(filter, g_type_parent(type));
+
+    compile = (OsinfoFilterCompileFunc)g_type_get_qdata(type, osinfo_filter_compile_quark());
+    if (compile)
+        compile(filter);
+}
 
-    g_hash_table_foreach(filter->priv->propertyConstraints,
-                         osinfo_filter_match_iterator,
-                         &args);
 
-    return args.matched;
+/**
+ * osinfo_filter_compile:
+ * @filter: a filter object
+ *
+ * Prepares @filter for matching entities. Its constraints are flattened
+ * into a form checked against the values stored in each entity, without
+ * copying them.
+ *
+ * Filters are compiled on their first use and again after their
+ * constraints change, so this only moves that work ahead of time, for
+ * example before sharing @filter between threads. The subclasses provided
+ * by the library also compile their own constraints, and the filters they
+ * are built from.
+ *
+ * Since: 1.13.0
+ */
+void osinfo_filter_compile(OsinfoFilter *filter)
+{
+    g_return_if_fail(OSINFO_IS_FILTER(filter));
+
+    osinfo_filter_compile_type(filter, G_OBJECT_TYPE(filter));
 }
 
 
@@ -53,3 +53,5 @@ GList *osinfo_filter_get_constraint_values(OsinfoFilter *filter,
 
 gboolean osinfo_filter_matches(OsinfoFilter *filter,
                                OsinfoEntity *entity);
+
+void osinfo_filter_compile(OsinfoFilter *filter);
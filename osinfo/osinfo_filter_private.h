@@ -0,0 +1,43 @@
+/*
+ * libosinfo: an entity filter
+ *
+ * Copyright (C) 2009-2020 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <osinfo/osinfo_filter.h>
+
+typedef struct _OsinfoFilterConstraint OsinfoFilterConstraint;
+
+/*
+ * A property constraint of a compiled filter: the entity must have all
+ * of the distinct @values for the interned property @key.
+ */
+struct _OsinfoFilterConstraint {
+    const gchar *key;
+    const gchar **values;
+    gsize nvalues;
+};
+
+const OsinfoFilterConstraint *osinfo_filter_get_compiled_constraints(OsinfoFilter *filter,
+                                                                     gsize *nconstraints);
+
+typedef void (*OsinfoFilterCompileFunc)(OsinfoFilter *filter);
+
+void osinfo_filter_class_set_compile_func(OsinfoFilterClass *klass,
+                                          OsinfoFilterCompileFunc compile);
@@ -24,8 +24,10 @@
 #include <libxslt/transform.h>
 #include <libxslt/xsltutils.h>
 #include <libxslt/xsltInternals.h>
+#include <libxslt/imports.h>
 #include <glib/gi18n-lib.h>
 #include "osinfo_install_script_private.h"
+#include "osinfo_entity_private.h"
 
 /**
  * SECTION:osinfo_install_script
@@ -38,12 +40,29 @@
  * comes from an #OsinfoInstallConfig object.
  */
 
+typedef struct _OsinfoInstallScriptTemplate OsinfoInstallScriptTemplate;
+typedef struct _OsinfoInstallScriptEntityNodes OsinfoInstallScriptEntityNodes;
+typedef struct _OsinfoInstallScriptEntityNodesKey OsinfoInstallScriptEntityNodesKey;
+
 struct _OsinfoInstallScriptPrivate
 {
     gchar *output_prefix;
     gchar *output_filename;
     OsinfoInstallConfigParamList *config_params;
     OsinfoAvatarFormat *avatar;
+
+    /* Protects template, template_doc and template_doc_data */
+    GMutex template_lock;
+    OsinfoInstallScriptTemplate *template;
+    /* Inline template, as handed over by the loader */
+    xmlDocPtr template_doc;
+    /* template_doc serialized, once asked for */
+    gchar *template_doc_data;
+
+    /* Protects entity_nodes */
+    GMutex entity_lock;
+    /* OsinfoInstallScriptEntityNodesKey -> OsinfoInstallScriptEntityNodes */
+    GHashTable *entity_nodes;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE(OsinfoInstallScript, osinfo_install_script, OSINFO_TYPE_ENTITY);
@@ -68,6 +87,134 @@ typedef struct _OsinfoInstallScriptGenerateData OsinfoInstallScriptGenerateData;
 typedef struct _OsinfoInstallScriptGenerateOutputData OsinfoInstallScriptGenerateOutputData;
 typedef struct _OsinfoInstallScriptGenerateSyncData OsinfoInstallScriptGenerateSyncData;
 
+/*
+ * A compiled stylesheet, along with the template text it was compiled
+ * from, or NULL when it was compiled from the script's template_doc.
+ * It is reference counted as it may still be in use by another
+ * thread's transform when the script replaces it.
+ */
+struct _OsinfoInstallScriptTemplate {
+    gint refs;
+    gchar *source;
+    xsltStylesheetPtr xsl;
+    /* Names the stylesheet may reference when transforming the
+     * install-script-config and the command-line documents, or NULL
+     * if unknown */
+    GHashTable *names;
+    GHashTable *command_line_names;
+
+    /* Set by osinfo_install_script_preload() for templates read from
+     * the template URI, which is then not read again to generate */
+    gchar *uri;
+    gboolean has_mtime;
+    guint64 mtime;
+};
+
+static OsinfoInstallScriptTemplate *
+osinfo_install_script_template_ref(OsinfoInstallScriptTemplate *template)
+{
+    g_atomic_int_inc(&template->refs);
+
+    return template;
+}
+
+static void
+osinfo_install_script_template_unref(OsinfoInstallScriptTemplate *template)
+{
+    if (!g_atomic_int_dec_and_test(&template->refs))
+        return;
+
+    xsltFreeStylesheet(template->xsl);
+    if (template->names)
+        g_hash_table_unref(template->names);
+    if (template->command_line_names)
+        g_hash_table_unref(template->command_line_names);
+    g_free(template->uri);
+    g_free(template->source);
+    g_free(template);
+}
+
+/*
+ * The os, media and tree the entity nodes were built for. These are only
+ * compared as pointers, the nodes weakly reference the entities themselves.
+ */
+struct _OsinfoInstallScriptEntityNodesKey {
+    gconstpointer os;
+    gconstpointer media;
+    gconstpointer tree;
+};
+
+/* How many sets of entity nodes a script keeps */
+#define OSINFO_INSTALL_SCRIPT_MAX_ENTITY_NODES 16
+
+/*
+ * The script, os, media and tree nodes of the generated input document,
+ * which are the same for every config. They only contain the parameters
+ * referenced by the template they were built for. The entities are only weakly
+ * referenced, as OSes hold references to their install scripts, and the
+ * entity serials are recorded so changes to their parameters are noticed.
+ * Like templates, these are reference counted as another thread may still
+ * be copying from them when the script replaces them.
+ */
+struct _OsinfoInstallScriptEntityNodes {
+    gint refs;
+    OsinfoInstallScriptEntityNodesKey key;
+    OsinfoInstallScriptTemplate *template;
+    /* The names of the template the nodes were pruned to, or NULL */
+    GHashTable *names;
+    guint script_serial;
+    GWeakRef os;
+    guint os_serial;
+    GWeakRef media;
+    guint media_serial;
+    GWeakRef tree;
+    guint tree_serial;
+    xmlDocPtr doc;
+};
+
+static OsinfoInstallScriptEntityNodes *
+osinfo_install_script_entity_nodes_ref(OsinfoInstallScriptEntityNodes *nodes)
+{
+    g_atomic_int_inc(&nodes->refs);
+
+    return nodes;
+}
+
+static void
+osinfo_install_script_entity_nodes_unref(OsinfoInstallScriptEntityNodes *nodes)
+{
+    if (!g_atomic_int_dec_and_test(&nodes->refs))
+        return;
+
+    osinfo_install_script_template_unref(nodes->template);
+    g_weak_ref_clear(&nodes->os);
+    g_weak_ref_clear(&nodes->media);
+    g_weak_ref_clear(&nodes->tree);
+    xmlFreeDoc(nodes->doc);
+    g_free(nodes);
+}
+
+static guint
+osinfo_install_script_entity_nodes_key_hash(gconstpointer data)
+{
+    const OsinfoInstallScriptEntityNodesKey *key = data;
+
+    return g_direct_hash(key->os) ^
+        (g_direct_hash(key->media) * 31) ^
+        (g_direct_hash(key->tree) * 37);
+}
+
+static gboolean
+osinfo_install_script_entity_nodes_key_equal(gconstpointer a,
+                                             gconstpointer b)
+{
+    const OsinfoInstallScriptEntityNodesKey *key_a = a;
+    const OsinfoInstallScriptEntityNodesKey *key_b = b;
+
+    return key_a->os == key_b->os &&
+        key_a->media == key_b->media &&
+        key_a->tree == key_b->tree;
+}
 
 static void
 osinfo_install_script_set_property(GObject    *object,
@@ -190,6 +337,16 @@ osinfo_install_script_finalize(GObject *object)
     if (script->priv->avatar)
         g_object_unref(script->priv->avatar);
 
+    if (script->priv->template)
+        osinfo_install_script_template_unref(script->priv->template);
+    xmlFreeDoc(script->priv->template_doc);
+    g_free(script->priv->template_doc_data);
+    g_mutex_clear(&script->priv->template_lock);
+
+    if (script->priv->entity_nodes)
+        g_hash_table_unref(script->priv->entity_nodes);
+    g_mutex_clear(&script->priv->entity_lock);
+
     /* Chain up to the parent class */
     G_OBJECT_CLASS(osinfo_install_script_parent_class)->finalize(object);
 }
@@ -380,6 +537,8 @@ osinfo_install_script_init(OsinfoInstallScript *list)
 {
     list->priv = osinfo_install_script_get_instance_private(list);
     list->priv->config_params = osinfo_install_config_paramlist_new();
+    g_mutex_init(&list->priv->template_lock);
+    g_mutex_init(&list->priv->entity_lock);
 }
 
 
@@ -472,8 +631,74 @@ const gchar *osinfo_install_script_get_template_uri(OsinfoInstallScript *script)
  */
 const gchar *osinfo_install_script_get_template_data(OsinfoInstallScript *script)
 {
-    return osinfo_entity_get_param_value(OSINFO_ENTITY(script),
+    const gchar *data;
+
+    g_mutex_lock(&script->priv->template_lock);
+
+    data = osinfo_entity_get_param_value(OSINFO_ENTITY(script),
                                          OSINFO_INSTALL_SCRIPT_PROP_TEMPLATE_DATA);
+
+    /* Inline templates coming from the database are only kept as a
+     * document, so they're serialized the first time they're asked for.
+     * The string is owned by the script rather than stored as a param,
+     * so that it stays valid and serializing it records no change. */
+    if (data == NULL && script->priv->template_doc != NULL) {
+        if (script->priv->template_doc_data == NULL) {
+            xmlBufferPtr buf;
+
+            if ((buf = xmlBufferCreate()) != NULL) {
+                if (xmlNodeDump(buf, script->priv->template_doc,
+                                xmlDocGetRootElement(script->priv->template_doc),
+                                0, 1) >= 0)
+                    script->priv->template_doc_data =
+                        g_strdup((const gchar *)xmlBufferContent(buf));
+                xmlBufferFree(buf);
+            }
+        }
+
+        data = script->priv->template_doc_data;
+    }
+
+    g_mutex_unlock(&script->priv->template_lock);
+
+    return data;
+}
+
+void osinfo_install_script_set_template_doc(OsinfoInstallScript *script,
+                                            xmlDocPtr doc)
+{
+    g_return_if_fail(OSINFO_IS_INSTALL_SCRIPT(script));
+
+    g_mutex_lock(&script->priv->template_lock);
+
+    /* Only called by the loader, before the script is handed out */
+    xmlFreeDoc(script->priv->template_doc);
+    script->priv->template_doc = doc;
+    g_clear_pointer(&script->priv->template_doc_data, g_free);
+
+    if (script->priv->template != NULL) {
+        osinfo_install_script_template_unref(script->priv->template);
+        script->priv->template = NULL;
+    }
+
+    osinfo_entity_clear_param(OSINFO_ENTITY(script),
+                              OSINFO_INSTALL_SCRIPT_PROP_TEMPLATE_DATA);
+
+    g_mutex_unlock(&script->priv->template_lock);
+}
+
+static gboolean
+osinfo_install_script_has_template_data(OsinfoInstallScript *script)
+{
+    gboolean ret;
+
+    g_mutex_lock(&script->priv->template_lock);
+    ret = script->priv->template_doc != NULL;
+    g_mutex_unlock(&script->priv->template_lock);
+
+    return ret ||
+        osinfo_entity_get_param_value(OSINFO_ENTITY(script),
+                                      OSINFO_INSTALL_SCRIPT_PROP_TEMPLATE_DATA) != NULL;
 }
 
 /**
@@ -714,6 +939,445 @@ static xsltStylesheetPtr osinfo_install_script_load_template(const gchar *uri,
     return xslt;
 }
 
+static xsltStylesheetPtr osinfo_install_script_load_template_doc(xmlDocPtr template,
+                                                                 GError **error)
+{
+    xsltStylesheetPtr xslt;
+    xmlDocPtr doc;
+
+    /* The stylesheet takes ownership of the document it's compiled from */
+    if (!(doc = xmlCopyDoc(template, 1))) {
+        g_set_error_literal(error, OSINFO_ERROR, 0,
+                            _("Unable to read XSL template"));
+        return NULL;
+    }
+
+    if (!(xslt = xsltParseStylesheetDoc(doc))) {
+        g_set_error_literal(error, OSINFO_ERROR, 0,
+                            _("Unable to parse XSL template"));
+        xmlFreeDoc(doc);
+        return NULL;
+    }
+
+    return xslt;
+}
+
+
+/*
+ * Elements of the input document which have the entity parameters as
+ * children, and whose string value thus depends on all of them.
+ */
+static const gchar *const osinfo_install_script_containers[] = {
+    "install-script-config", "command-line",
+    "script", "os", "media", "tree", "config",
+};
+
+static gboolean
+osinfo_install_script_is_container(const gchar *name)
+{
+    gsize i;
+
+    for (i = 0; i < G_N_ELEMENTS(osinfo_install_script_containers); i++) {
+        if (g_str_equal(name, osinfo_install_script_containers[i]))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+static gboolean
+osinfo_install_script_is_name_char(gchar c)
+{
+    return g_ascii_isalnum(c) || c == '-' || c == '_' || c == '.';
+}
+
+static const gchar *
+osinfo_install_script_skip_space(const gchar *p)
+{
+    while (g_ascii_isspace(*p))
+        p++;
+    return p;
+}
+
+/*
+ * Collects the element names referenced by an XPath expression or
+ * pattern into @names. Returns FALSE if the expression may also depend
+ * on parameters it does not name, e.g. through wildcards, parent
+ * axes, or by taking the string value of an entity node.
+ *
+ * @context_is_container tells whether the context node of the
+ * expression may be one of the entity nodes.
+ */
+static gboolean
+osinfo_install_script_analyze_xpath(const gchar *expr,
+                                    gboolean pattern,
+                                    gboolean context_is_container,
+                                    GHashTable *names)
+{
+    const gchar *p = expr;
+
+    while (*p) {
+        const gchar *start;
+        const gchar *next;
+        gchar *name;
+
+        if (g_ascii_isspace(*p)) {
+            p++;
+        } else if (*p == '"' || *p == '\'') {
+            if (!(next = strchr(p + 1, *p)))
+                return FALSE;
+            p = next + 1;
+        } else if (*p == '*') {
+            return FALSE;
+        } else if (*p == '$') {
+            /* Variable references name no elements */
+            for (p++; osinfo_install_script_is_name_char(*p) || *p == ':'; p++)
+                ;
+        } else if (*p == '/') {
+            if (p[1] == '/')
+                p++;
+            next = osinfo_install_script_skip_space(p + 1);
+            /* A bare "/" is the root, whose string value is everything */
+            if (!pattern &&
+                !g_ascii_isalpha(*next) && *next != '_' &&
+                *next != '@' && *next != '.')
+                return FALSE;
+            p = next;
+        } else if (*p == '.' && !g_ascii_isdigit(p[1])) {
+            if (p[1] == '.')
+                return FALSE;
+            next = osinfo_install_script_skip_space(p + 1);
+            if (*next != '/' && context_is_container)
+                return FALSE;
+            p++;
+        } else if (g_ascii_isdigit(*p) || *p == '.') {
+            while (g_ascii_isdigit(*p) || *p == '.')
+                p++;
+        } else if (g_ascii_isalpha(*p) || *p == '_') {
+            start = p;
+            while (osinfo_install_script_is_name_char(*p) ||
+                   (p[0] == ':' && p[1] != ':'))
+                p++;
+            name = g_strndup(start, p - start);
+            next = osinfo_install_script_skip_space(p);
+
+            if (next[0] == ':' && next[1] == ':') {
+                /* Only axes going down or sideways can be followed */
+                gboolean ok = g_str_equal(name, "child") ||
+                    g_str_equal(name, "attribute") ||
+                    g_str_equal(name, "descendant") ||
+                    g_str_equal(name, "following-sibling") ||
+                    g_str_equal(name, "preceding-sibling");
+                g_free(name);
+                if (!ok)
+                    return FALSE;
+                p = next + 2;
+                continue;
+            }
+
+            if (*next == '(') {
+                /* Node type tests and functions working on the context node */
+                gboolean ok = !g_str_equal(name, "node");
+                if (context_is_container &&
+                    *osinfo_install_script_skip_space(next + 1) == ')' &&
+                    (g_str_equal(name, "string") ||
+                     g_str_equal(name, "normalize-space") ||
+                     g_str_equal(name, "string-length") ||
+                     g_str_equal(name, "number") ||
+                     g_str_equal(name, "current")))
+                    ok = FALSE;
+                g_free(name);
+                if (!ok)
+                    return FALSE;
+                p = next + 1;
+                continue;
+            }
+
+            if (osinfo_install_script_is_container(name)) {
+                g_free(name);
+                if (!pattern && *next != '/')
+                    return FALSE;
+                continue;
+            }
+
+            g_hash_table_add(names, name);
+        } else {
+            p++;
+        }
+    }
+
+    return TRUE;
+}
+
+/*
+ * Whether templates matching @pattern may be applied to one of the
+ * entity nodes, or to the root.
+ */
+static gboolean
+osinfo_install_script_pattern_is_container(const gchar *pattern)
+{
+    const gchar *step;
+    gchar *name;
+    gboolean ret;
+
+    if (pattern == NULL || strchr(pattern, '|') || strchr(pattern, '['))
+        return TRUE;
+
+    if ((step = strrchr(pattern, '/')))
+        step++;
+    else
+        step = pattern;
+
+    name = g_strstrip(g_strdup(step));
+    ret = *name == '\0' || osinfo_install_script_is_container(name);
+    g_free(name);
+    return ret;
+}
+
+static gboolean
+osinfo_install_script_analyze_nodes(xmlNodePtr node,
+                                    gboolean context_is_container,
+                                    GHashTable *names)
+{
+    for (; node != NULL; node = node->next) {
+        gboolean is_xsl;
+        gboolean context = context_is_container;
+        xmlAttrPtr attr;
+
+        if (node->type != XML_ELEMENT_NODE)
+            continue;
+
+        is_xsl = node->ns != NULL && xmlStrEqual(node->ns->href, XSLT_NAMESPACE);
+
+        if (is_xsl &&
+            (xmlStrEqual(node->name, BAD_CAST "include") ||
+             xmlStrEqual(node->name, BAD_CAST "import")))
+            return FALSE;
+
+        /* Without a select, templates are applied to all the children of
+         * the context node, and the built-in rules output their text */
+        if (is_xsl &&
+            xmlStrEqual(node->name, BAD_CAST "apply-templates") &&
+            !xmlHasNsProp(node, BAD_CAST "select", NULL))
+            return FALSE;
+
+        if (is_xsl && xmlStrEqual(node->name, BAD_CAST "template")) {
+            /* Named templates run in the context of their caller */
+            xmlChar *match = xmlGetNoNsProp(node, BAD_CAST "match");
+            context = osinfo_install_script_pattern_is_container((const gchar *)match);
+            xmlFree(match);
+        } else if (is_xsl && xmlStrEqual(node->name, BAD_CAST "for-each")) {
+            /* The selected nodes are checked by the select expression */
+            context = FALSE;
+        }
+
+        for (attr = node->properties; attr != NULL; attr = attr->next) {
+            xmlChar *value = xmlNodeListGetString(node->doc, attr->children, 1);
+            const gchar *aname = (const gchar *)attr->name;
+            gboolean ok = TRUE;
+
+            if (value == NULL)
+                continue;
+
+            if (is_xsl && attr->ns == NULL &&
+                (g_str_equal(aname, "match") ||
+                 g_str_equal(aname, "count") ||
+                 g_str_equal(aname, "from"))) {
+                ok = osinfo_install_script_analyze_xpath((const gchar *)value,
+                                                         TRUE, FALSE, names);
+            } else if (is_xsl && attr->ns == NULL &&
+                       (g_str_equal(aname, "select") ||
+                        g_str_equal(aname, "test") ||
+                        g_str_equal(aname, "use") ||
+                        g_str_equal(aname, "value"))) {
+                /* xsl:sort works on the nodes selected by its parent */
+                ok = osinfo_install_script_analyze_xpath((const gchar *)value,
+                                                         FALSE,
+                                                         xmlStrEqual(node->name, BAD_CAST "sort") ?
+                                                         FALSE : context_is_container,
+                                                         names);
+            } else {
+                /* Attribute value templates */
+                const gchar *p = (const gchar *)value;
+                const gchar *end;
+
+                while (ok && (p = strchr(p, '{'))) {
+                    if (!(end = strchr(p, '}'))) {
+                        ok = FALSE;
+                        break;
+                    }
+                    if (p[1] != '{') {
+                        gchar *expr = g_strndup(p + 1, end - p - 1);
+                        ok = osinfo_install_script_analyze_xpath(expr, FALSE,
+                                                                 context,
+                                                                 names);
+                        g_free(expr);
+                    }
+                    p = end + 1;
+                }
+            }
+
+            xmlFree(value);
+            if (!ok)
+                return FALSE;
+        }
+
+        if (!osinfo_install_script_analyze_nodes(node->children, context, names))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+ * Whether a top level template of @stylesheet in the default mode
+ * matches the root or the document element @name. Otherwise the
+ * built-in template rules output the text of the whole document.
+ */
+static gboolean
+osinfo_install_script_matches_document(xmlNodePtr stylesheet,
+                                       const gchar *name)
+{
+    xmlNodePtr node;
+    gboolean ret = FALSE;
+
+    for (node = stylesheet->children; node != NULL && !ret; node = node->next) {
+        xmlChar *match;
+        gchar **patterns;
+        gsize i;
+
+        if (node->type != XML_ELEMENT_NODE ||
+            node->ns == NULL ||
+            !xmlStrEqual(node->ns->href, XSLT_NAMESPACE) ||
+            !xmlStrEqual(node->name, BAD_CAST "template") ||
+            xmlHasNsProp(node, BAD_CAST "mode", NULL))
+            continue;
+
+        if (!(match = xmlGetNoNsProp(node, BAD_CAST "match")))
+            continue;
+
+        patterns = g_strsplit((const gchar *)match, "|", -1);
+        for (i = 0; patterns[i] != NULL && !ret; i++) {
+            const gchar *pattern = g_strstrip(patterns[i]);
+
+            if (*pattern == '/')
+                pattern = osinfo_install_script_skip_space(pattern + 1);
+            ret = *pattern == '\0' || g_str_equal(pattern, name);
+        }
+        g_strfreev(patterns);
+        xmlFree(match);
+    }
+
+    return ret;
+}
+
+/*
+ * Determines the parameter names which @xsl may reference when
+ * transforming a document whose element is @document, so the input
+ * document only needs to contain those. Returns NULL when that cannot
+ * be determined, in which case all parameters must be emitted.
+ */
+static GHashTable *
+osinfo_install_script_analyze_template(xsltStylesheetPtr xsl,
+                                       const gchar *document)
+{
+    GHashTable *names;
+    xmlNodePtr root;
+
+    if (xsl->doc == NULL || xsl->imports != NULL || xsl->docList != NULL)
+        return NULL;
+
+    root = xmlDocGetRootElement(xsl->doc);
+    if (root == NULL ||
+        !osinfo_install_script_matches_document(root, document)) {
+        g_debug("The template may rely on the built-in template rules");
+        return NULL;
+    }
+
+    names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    if (!osinfo_install_script_analyze_nodes(root, TRUE, names)) {
+        g_debug("Unable to determine the parameters used by the template");
+        g_hash_table_unref(names);
+        return NULL;
+    }
+
+    return names;
+}
+
+/*
+ * Returns the compiled stylesheet for @template, compiling it only when
+ * it differs from the one used by the previous generation. A NULL
+ * @template stands for the script's own inline template.
+ */
+static OsinfoInstallScriptTemplate *
+osinfo_install_script_get_template(OsinfoInstallScript *script,
+                                   const gchar *uri,
+                                   const gchar *template,
+                                   GError **error)
+{
+    OsinfoInstallScriptTemplate *ret = NULL;
+    xsltStylesheetPtr xslt;
+    gboolean from_doc;
+
+    g_mutex_lock(&script->priv->template_lock);
+
+    from_doc = template == NULL && script->priv->template_doc != NULL;
+    if (template == NULL && !from_doc)
+        template = osinfo_entity_get_param_value(OSINFO_ENTITY(script),
+                                                 OSINFO_INSTALL_SCRIPT_PROP_TEMPLATE_DATA);
+
+    if (script->priv->template != NULL &&
+        g_strcmp0(script->priv->template->source, template) == 0) {
+        ret = osinfo_install_script_template_ref(script->priv->template);
+        goto cleanup;
+    }
+
+    if (from_doc)
+        xslt = osinfo_install_script_load_template_doc(script->priv->template_doc, error);
+    else
+        xslt = osinfo_install_script_load_template(uri, template, error);
+    if (!xslt)
+        goto cleanup;
+
+    if (script->priv->template != NULL)
+        osinfo_install_script_template_unref(script->priv->template);
+
+    script->priv->template = g_new0(OsinfoInstallScriptTemplate, 1);
+    script->priv->template->refs = 1;
+    script->priv->template->source = g_strdup(template);
+    script->priv->template->xsl = xslt;
+    script->priv->template->names =
+        osinfo_install_script_analyze_template(xslt, "install-script-config");
+    script->priv->template->command_line_names =
+        osinfo_install_script_analyze_template(xslt, "command-line");
+
+    ret = osinfo_install_script_template_ref(script->priv->template);
+
+ cleanup:
+    g_mutex_unlock(&script->priv->template_lock);
+    return ret;
+}
+
+
+/*
+ * Returns the template preloaded from @uri, if any.
+ */
+static OsinfoInstallScriptTemplate *
+osinfo_install_script_get_preloaded_template(OsinfoInstallScript *script,
+                                             const gchar *uri)
+{
+    OsinfoInstallScriptTemplate *ret = NULL;
+
+    g_mutex_lock(&script->priv->template_lock);
+    if (uri != NULL &&
+        script->priv->template != NULL &&
+        g_strcmp0(script->priv->template->uri, uri) == 0)
+        ret = osinfo_install_script_template_ref(script->priv->template);
+    g_mutex_unlock(&script->priv->template_lock);
+
+    return ret;
+}
+
 
 static OsinfoDatamap *
 osinfo_install_script_get_param_datamap(OsinfoInstallScript *script,
@@ -788,6 +1452,7 @@ static void propagate_libxml_error(GError **error, const char *format, ...)
 static xmlNodePtr osinfo_install_script_generate_entity_xml(OsinfoInstallScript *script,
                                                             OsinfoEntity *entity,
                                                             const gchar *name,
+                                                            GHashTable *names,
                                                             GError **error)
 {
     xmlNodePtr node = NULL;
@@ -816,6 +1481,20 @@ static xmlNodePtr osinfo_install_script_generate_entity_xml(OsinfoInstallScript
         g_autoptr(GList) values = NULL;
         GList *tmp2;
 
+        /* The template is not an input of its own transform, and it may
+         * not even have been serialized at all */
+        if (OSINFO_IS_INSTALL_SCRIPT(entity) &&
+            g_str_equal(tmp1->data, OSINFO_INSTALL_SCRIPT_PROP_TEMPLATE_DATA)) {
+            tmp1 = tmp1->next;
+            continue;
+        }
+
+        /* Parameters the template cannot reference */
+        if (names != NULL && !g_hash_table_contains(names, tmp1->data)) {
+            tmp1 = tmp1->next;
+            continue;
+        }
+
         if (OSINFO_IS_INSTALL_CONFIG(entity))
             values = osinfo_install_script_get_param_value_list(script,
                                                                 OSINFO_INSTALL_CONFIG(entity),
@@ -854,71 +1533,256 @@ static xmlNodePtr osinfo_install_script_generate_entity_xml(OsinfoInstallScript
 }
 
 
-static xmlDocPtr osinfo_install_script_generate_config_xml(OsinfoInstallScript *script,
-                                                           OsinfoOs *os,
-                                                           OsinfoMedia *media,
-                                                           OsinfoTree *tree,
-                                                           OsinfoInstallConfig *config,
-                                                           const gchar *node_name,
-                                                           GError **error)
+static gboolean
+osinfo_install_script_entity_nodes_match(GWeakRef *ref,
+                                         guint serial,
+                                         OsinfoEntity *entity)
 {
-    xmlDocPtr doc = xmlNewDoc((xmlChar *)"1.0");
-    xmlNodePtr root;
-    xmlNodePtr node;
+    GObject *obj = g_weak_ref_get(ref);
+    gboolean ret;
+
+    ret = obj == (GObject *)entity &&
+        (entity == NULL || osinfo_entity_get_serial(entity) == serial);
+
+    if (obj != NULL)
+        g_object_unref(obj);
+    return ret;
+}
 
-    root = xmlNewDocNode(NULL,
-                         NULL,
-                         (xmlChar*)node_name,
-                         NULL);
-    xmlDocSetRootElement(doc, root);
+
+static gboolean
+osinfo_install_script_entity_nodes_add(OsinfoInstallScript *script,
+                                       xmlNodePtr root,
+                                       OsinfoEntity *entity,
+                                       const gchar *name,
+                                       GHashTable *names,
+                                       GError **error)
+{
+    xmlNodePtr node;
 
     if (!(node = osinfo_install_script_generate_entity_xml(script,
-                                                           OSINFO_ENTITY(script),
-                                                           "script",
+                                                           entity,
+                                                           name,
+                                                           names,
                                                            error)))
-        goto error;
+        return FALSE;
     if (!(xmlAddChild(root, node))) {
-        propagate_libxml_error(error, _("Unable to set XML root"));
-        goto error;
+        xmlFreeNode(node);
+        propagate_libxml_error(error, _("Unable to set '%s' node"), name);
+        return FALSE;
     }
 
-    if (!(node = osinfo_install_script_generate_entity_xml(script,
-                                                           OSINFO_ENTITY(os),
-                                                           "os",
-                                                           error)))
+    return TRUE;
+}
+
+
+static OsinfoInstallScriptEntityNodes *
+osinfo_install_script_build_entity_nodes(OsinfoInstallScript *script,
+                                         OsinfoInstallScriptTemplate *template,
+                                         GHashTable *names,
+                                         OsinfoOs *os,
+                                         OsinfoMedia *media,
+                                         OsinfoTree *tree,
+                                         GError **error)
+{
+    OsinfoInstallScriptEntityNodes *nodes = g_new0(OsinfoInstallScriptEntityNodes, 1);
+    xmlNodePtr root;
+
+    nodes->refs = 1;
+    nodes->key.os = os;
+    nodes->key.media = media;
+    nodes->key.tree = tree;
+    nodes->template = osinfo_install_script_template_ref(template);
+    nodes->names = names;
+    g_weak_ref_init(&nodes->os, os);
+    g_weak_ref_init(&nodes->media, media);
+    g_weak_ref_init(&nodes->tree, tree);
+
+    /* Record the serials first, so that changes made while the nodes
+     * are being built cause them to be rebuilt on the next use */
+    nodes->script_serial = osinfo_entity_get_serial(OSINFO_ENTITY(script));
+    nodes->os_serial = osinfo_entity_get_serial(OSINFO_ENTITY(os));
+    if (media != NULL)
+        nodes->media_serial = osinfo_entity_get_serial(OSINFO_ENTITY(media));
+    if (tree != NULL)
+        nodes->tree_serial = osinfo_entity_get_serial(OSINFO_ENTITY(tree));
+
+    nodes->doc = xmlNewDoc((xmlChar *)"1.0");
+    root = xmlNewDocNode(NULL, NULL, (xmlChar *)"entities", NULL);
+    xmlDocSetRootElement(nodes->doc, root);
+
+    if (!osinfo_install_script_entity_nodes_add(script, root,
+                                                OSINFO_ENTITY(script),
+                                                "script", names,
+                                                error))
         goto error;
-    if (!(xmlAddChild(root, node))) {
-        propagate_libxml_error(error, _("Unable to set XML root"));
+
+    if (!osinfo_install_script_entity_nodes_add(script, root,
+                                                OSINFO_ENTITY(os),
+                                                "os", names,
+                                                error))
         goto error;
-    }
 
-    if (media != NULL) {
-        if (!(node = osinfo_install_script_generate_entity_xml(script,
-                                                               OSINFO_ENTITY(media),
-                                                               "media",
-                                                               error)))
-            goto error;
-        if (!(xmlAddChild(root, node))) {
-            propagate_libxml_error(error, _("Unable to set 'media' node"));
-            goto error;
-        }
-    }
+    if (media != NULL &&
+        !osinfo_install_script_entity_nodes_add(script, root,
+                                                OSINFO_ENTITY(media),
+                                                "media", names,
+                                                error))
+        goto error;
 
-    if (tree != NULL) {
-        if (!(node = osinfo_install_script_generate_entity_xml(script,
-                                                               OSINFO_ENTITY(tree),
-                                                               "tree",
-                                                               error)))
-            goto error;
-        if (!(xmlAddChild(root, node))) {
-            propagate_libxml_error(error, _("Unable to set 'tree' node"));
-            goto error;
+    if (tree != NULL &&
+        !osinfo_install_script_entity_nodes_add(script, root,
+                                                OSINFO_ENTITY(tree),
+                                                "tree", names,
+                                                error))
+        goto error;
+
+    return nodes;
+
+ error:
+    osinfo_install_script_entity_nodes_unref(nodes);
+    return NULL;
+}
+
+
+static gboolean
+osinfo_install_script_entity_nodes_is_dead(gpointer key G_GNUC_UNUSED,
+                                           gpointer value,
+                                           gpointer opaque G_GNUC_UNUSED)
+{
+    OsinfoInstallScriptEntityNodes *nodes = value;
+    GObject *os = g_weak_ref_get(&nodes->os);
+
+    if (os == NULL)
+        return TRUE;
+
+    g_object_unref(os);
+    return FALSE;
+}
+
+
+/*
+ * The entity nodes are kept for each combination of os, media and tree
+ * the script was recently generated for, so that callers alternating
+ * between a few of them do not rebuild the nodes every time.
+ */
+static OsinfoInstallScriptEntityNodes *
+osinfo_install_script_get_entity_nodes(OsinfoInstallScript *script,
+                                       OsinfoInstallScriptTemplate *template,
+                                       GHashTable *names,
+                                       OsinfoOs *os,
+                                       OsinfoMedia *media,
+                                       OsinfoTree *tree,
+                                       GError **error)
+{
+    OsinfoInstallScriptEntityNodesKey key = { os, media, tree };
+    OsinfoInstallScriptEntityNodes *nodes = NULL;
+    OsinfoInstallScriptEntityNodes *ret = NULL;
+    GHashTable *table;
+
+    g_mutex_lock(&script->priv->entity_lock);
+
+    if (script->priv->entity_nodes == NULL)
+        script->priv->entity_nodes =
+            g_hash_table_new_full(osinfo_install_script_entity_nodes_key_hash,
+                                  osinfo_install_script_entity_nodes_key_equal,
+                                  NULL,
+                                  (GDestroyNotify)osinfo_install_script_entity_nodes_unref);
+    table = script->priv->entity_nodes;
+
+    nodes = g_hash_table_lookup(table, &key);
+    if (nodes != NULL &&
+        nodes->template == template &&
+        nodes->names == names &&
+        nodes->script_serial == osinfo_entity_get_serial(OSINFO_ENTITY(script)) &&
+        osinfo_install_script_entity_nodes_match(&nodes->os, nodes->os_serial,
+                                                 OSINFO_ENTITY(os)) &&
+        osinfo_install_script_entity_nodes_match(&nodes->media, nodes->media_serial,
+                                                 media ? OSINFO_ENTITY(media) : NULL) &&
+        osinfo_install_script_entity_nodes_match(&nodes->tree, nodes->tree_serial,
+                                                 tree ? OSINFO_ENTITY(tree) : NULL)) {
+        ret = osinfo_install_script_entity_nodes_ref(nodes);
+        goto cleanup;
+    }
+
+    if (!(nodes = osinfo_install_script_build_entity_nodes(script, template, names,
+                                                           os, media, tree, error)))
+        goto cleanup;
+
+    /* Entries for entities which went away are dropped first, and only
+     * then everything, to keep the cache small */
+    if (!g_hash_table_contains(table, &nodes->key) &&
+        g_hash_table_size(table) >= OSINFO_INSTALL_SCRIPT_MAX_ENTITY_NODES &&
+        g_hash_table_foreach_remove(table,
+                                    osinfo_install_script_entity_nodes_is_dead,
+                                    NULL) == 0)
+        g_hash_table_remove_all(table);
+
+    g_hash_table_replace(table, &nodes->key, nodes);
+    ret = osinfo_install_script_entity_nodes_ref(nodes);
+
+ cleanup:
+    g_mutex_unlock(&script->priv->entity_lock);
+    return ret;
+}
+
+
+static xmlDocPtr osinfo_install_script_generate_config_xml(OsinfoInstallScript *script,
+                                                           OsinfoInstallScriptTemplate *template,
+                                                           OsinfoOs *os,
+                                                           OsinfoMedia *media,
+                                                           OsinfoTree *tree,
+                                                           OsinfoInstallConfig *config,
+                                                           const gchar *node_name,
+                                                           GError **error)
+{
+    OsinfoInstallScriptEntityNodes *nodes;
+    GHashTable *names;
+    xmlDocPtr doc = xmlNewDoc((xmlChar *)"1.0");
+    xmlNodePtr root;
+    xmlNodePtr node;
+    xmlNodePtr child;
+
+    root = xmlNewDocNode(NULL,
+                         NULL,
+                         (xmlChar*)node_name,
+                         NULL);
+    xmlDocSetRootElement(doc, root);
+
+    /* Only the config node differs between generations, the other
+     * ones are copied from the nodes built by a previous generation */
+    if (g_str_equal(node_name, "command-line"))
+        names = template->command_line_names;
+    else
+        names = template->names;
+    if (!(nodes = osinfo_install_script_get_entity_nodes(script, template, names,
+                                                         os, media, tree, error)))
+        goto error;
+
+    for (child = xmlDocGetRootElement(nodes->doc)->children;
+         child != NULL;
+         child = child->next) {
+        if (!(node = xmlDocCopyNode(child, doc, 1))) {
+            propagate_libxml_error(error, _("Unable to copy XML node '%s'"),
+                                   (const gchar *)child->name);
+            osinfo_install_script_entity_nodes_unref(nodes);
+            goto error;
+        }
+        if (!(xmlAddChild(root, node))) {
+            xmlFreeNode(node);
+            propagate_libxml_error(error, _("Unable to set XML root"));
+            osinfo_install_script_entity_nodes_unref(nodes);
+            goto error;
         }
     }
+    osinfo_install_script_entity_nodes_unref(nodes);
 
+    /* The config is not pruned, its parameters go through datamaps
+     * and there are few of them anyway */
     if (!(node = osinfo_install_script_generate_entity_xml(script,
                                                            OSINFO_ENTITY(config),
                                                            "config",
+                                                           NULL,
                                                            error)))
         goto error;
     if (!(xmlAddChild(root, node))) {
@@ -934,25 +1798,36 @@ static xmlDocPtr osinfo_install_script_generate_config_xml(OsinfoInstallScript *
     return NULL;
 }
 
-static gchar *osinfo_install_script_apply_xslt(xsltStylesheetPtr ss,
-                                               xmlDocPtr doc,
-                                               GError **error)
+static xmlDocPtr osinfo_install_script_run_xslt(xsltStylesheetPtr ss,
+                                                xmlDocPtr doc,
+                                                GError **error)
 {
     xsltTransformContextPtr ctxt;
-    xmlChar *xsltResult;
-    gchar *ret = NULL;
     xmlDocPtr docOut = NULL;
-    int len;
 
     if (!(ctxt = xsltNewTransformContext(ss, doc))) {
         g_set_error_literal(error, OSINFO_ERROR, 0, _("Unable to create XSL transform context"));
-        goto cleanup;
+        return NULL;
     }
 
-    if (!(docOut = xsltApplyStylesheetUser(ss, doc, NULL, NULL, NULL, ctxt))) {
+    if (!(docOut = xsltApplyStylesheetUser(ss, doc, NULL, NULL, NULL, ctxt)))
         g_set_error_literal(error, OSINFO_ERROR, 0, _("Unable to apply XSL transform context"));
+
+    xsltFreeTransformContext(ctxt);
+    return docOut;
+}
+
+static gchar *osinfo_install_script_apply_xslt(xsltStylesheetPtr ss,
+                                               xmlDocPtr doc,
+                                               GError **error)
+{
+    xmlChar *xsltResult;
+    gchar *ret = NULL;
+    xmlDocPtr docOut = NULL;
+    int len;
+
+    if (!(docOut = osinfo_install_script_run_xslt(ss, doc, error)))
         goto cleanup;
-    }
 
     if (xsltSaveResultToString(&xsltResult, &len, docOut, ss) < 0) {
         g_set_error_literal(error, OSINFO_ERROR, 0, _("Unable to convert XSL output to string"));
@@ -963,7 +1838,157 @@ static gchar *osinfo_install_script_apply_xslt(xsltStylesheetPtr ss,
 
  cleanup:
     xmlFreeDoc(docOut);
-    xsltFreeTransformContext(ctxt);
+    return ret;
+}
+
+typedef struct _OsinfoInstallScriptStreamData OsinfoInstallScriptStreamData;
+
+struct _OsinfoInstallScriptStreamData {
+    GOutputStream *stream;
+    GCancellable *cancellable;
+    GError *error;
+};
+
+static int osinfo_install_script_stream_write(void *opaque,
+                                              const char *buffer,
+                                              int len)
+{
+    OsinfoInstallScriptStreamData *data = opaque;
+
+    if (data->error != NULL)
+        return -1;
+
+    if (!g_output_stream_write_all(data->stream, buffer, len, NULL,
+                                   data->cancellable, &data->error))
+        return -1;
+
+    return len;
+}
+
+/*
+ * Serializes the transform result straight into @buf's sink, using
+ * the output encoding of the stylesheet as xsltSaveResultToString()
+ * would. Consumes @buf.
+ */
+static gboolean osinfo_install_script_save_xslt(xsltStylesheetPtr ss,
+                                                xmlDocPtr docOut,
+                                                xmlOutputBufferPtr buf)
+{
+    int ret;
+
+    if (buf == NULL)
+        return FALSE;
+
+    ret = xsltSaveResultTo(buf, docOut, ss);
+    if (xmlOutputBufferClose(buf) < 0)
+        return FALSE;
+
+    return ret >= 0;
+}
+
+static xmlCharEncodingHandlerPtr
+osinfo_install_script_get_encoder(xsltStylesheetPtr ss)
+{
+    const xmlChar *encoding;
+    xmlCharEncodingHandlerPtr encoder;
+
+    XSLT_GET_IMPORT_PTR(encoding, ss, encoding);
+    if (encoding == NULL)
+        return NULL;
+
+    encoder = xmlFindCharEncodingHandler((const char *)encoding);
+    if (encoder != NULL &&
+        xmlStrEqual((const xmlChar *)encoder->name, (const xmlChar *)"UTF-8"))
+        return NULL;
+
+    return encoder;
+}
+
+static gboolean osinfo_install_script_apply_xslt_to_stream(xsltStylesheetPtr ss,
+                                                           xmlDocPtr doc,
+                                                           GOutputStream *stream,
+                                                           GCancellable *cancellable,
+                                                           GError **error)
+{
+    OsinfoInstallScriptStreamData data = { stream, cancellable, NULL };
+    xmlDocPtr docOut;
+    gboolean ret;
+
+    if (!(docOut = osinfo_install_script_run_xslt(ss, doc, error)))
+        return FALSE;
+
+    ret = osinfo_install_script_save_xslt(ss, docOut,
+                                          xmlOutputBufferCreateIO(osinfo_install_script_stream_write,
+                                                                  NULL,
+                                                                  &data,
+                                                                  osinfo_install_script_get_encoder(ss)));
+    xmlFreeDoc(docOut);
+
+    if (data.error != NULL) {
+        g_propagate_error(error, data.error);
+        return FALSE;
+    }
+    if (!ret) {
+        g_set_error_literal(error, OSINFO_ERROR, 0, _("Unable to write XSL output to stream"));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean osinfo_install_script_apply_xslt_to_fd(xsltStylesheetPtr ss,
+                                                       xmlDocPtr doc,
+                                                       int fd,
+                                                       GError **error)
+{
+    xmlDocPtr docOut;
+    gboolean ret;
+
+    if (!(docOut = osinfo_install_script_run_xslt(ss, doc, error)))
+        return FALSE;
+
+    ret = osinfo_install_script_save_xslt(ss, docOut,
+                                          xmlOutputBufferCreateFd(fd,
+                                                                  osinfo_install_script_get_encoder(ss)));
+    xmlFreeDoc(docOut);
+
+    if (!ret) {
+        g_set_error_literal(error, OSINFO_ERROR, 0, _("Unable to write XSL output to file descriptor"));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/*
+ * Applies an already compiled template. This only reads from the
+ * script, OS, media and tree entities and builds a new document for
+ * every call, so it may be invoked from several threads at once.
+ */
+static gboolean osinfo_install_script_apply_template_xsl(OsinfoInstallScript *script,
+                                                         OsinfoInstallScriptTemplate *templateXsl,
+                                                         OsinfoOs *os,
+                                                         OsinfoMedia *media,
+                                                         OsinfoTree *tree,
+                                                         const gchar *node_name,
+                                                         gchar **result,
+                                                         OsinfoInstallConfig *config,
+                                                         GError **error)
+{
+    gboolean ret = FALSE;
+    xmlDocPtr configXml = NULL;
+
+    if (!(configXml = osinfo_install_script_generate_config_xml(script, templateXsl, os, media, tree, config, node_name, error)))
+        goto cleanup;
+
+    if (!(*result = osinfo_install_script_apply_xslt(templateXsl->xsl, configXml, error)))
+        goto cleanup;
+
+    ret = TRUE;
+
+ cleanup:
+    xmlFreeDoc(configXml);
     return ret;
 }
 
@@ -979,21 +2004,18 @@ static gboolean osinfo_install_script_apply_template(OsinfoInstallScript *script
                                                      OsinfoInstallConfig *config,
                                                      GError **error)
 {
-    gboolean ret = FALSE;
-    xsltStylesheetPtr templateXsl = osinfo_install_script_load_template(templateUri, template, error);
-    xmlDocPtr configXml = osinfo_install_script_generate_config_xml(script, os, media, tree, config, node_name, error);
+    gboolean ret;
+    OsinfoInstallScriptTemplate *templateXsl;
 
-    if (!templateXsl || !configXml)
-        goto cleanup;
-
-    if (!(*result = osinfo_install_script_apply_xslt(templateXsl, configXml, error)))
-        goto cleanup;
+    if (!(templateXsl = osinfo_install_script_get_template(script, templateUri, template, error)))
+        return FALSE;
 
-    ret = TRUE;
+    ret = osinfo_install_script_apply_template_xsl(script, templateXsl,
+                                                   os, media, tree,
+                                                   node_name, result,
+                                                   config, error);
 
- cleanup:
-    xsltFreeStylesheet(templateXsl);
-    xmlFreeDoc(configXml);
+    osinfo_install_script_template_unref(templateXsl);
     return ret;
 }
 
@@ -1056,13 +2078,14 @@ static void osinfo_install_script_generate_async_common(OsinfoInstallScript *scr
                                                         gpointer user_data)
 {
     OsinfoInstallScriptGenerateData *data;
-    const gchar *templateData;
+    OsinfoInstallScriptTemplate *templateXsl;
+    gboolean hasTemplateData;
     const gchar *templateUri;
 
     g_return_if_fail(os != NULL);
 
     data = g_new0(OsinfoInstallScriptGenerateData, 1);
-    templateData = osinfo_install_script_get_template_data(script);
+    hasTemplateData = osinfo_install_script_has_template_data(script);
     templateUri = osinfo_install_script_get_template_uri(script);
 
     data->os = g_object_ref(os);
@@ -1077,7 +2100,7 @@ static void osinfo_install_script_generate_async_common(OsinfoInstallScript *scr
                            callback,
                            user_data);
 
-    if (templateData) {
+    if (hasTemplateData) {
         GError *error = NULL;
         gchar *output;
         if (!osinfo_install_script_apply_template(script,
@@ -1085,7 +2108,7 @@ static void osinfo_install_script_generate_async_common(OsinfoInstallScript *scr
                                                   media,
                                                   NULL,
                                                   "<data>",
-                                                  templateData,
+                                                  NULL,
                                                   "install-script-config",
                                                   &output,
                                                   data->config,
@@ -1097,6 +2120,26 @@ static void osinfo_install_script_generate_async_common(OsinfoInstallScript *scr
         }
         g_task_return_pointer(data->res, output, g_free);
         osinfo_install_script_generate_data_free(data);
+    } else if ((templateXsl = osinfo_install_script_get_preloaded_template(script,
+                                                                           templateUri))) {
+        GError *error = NULL;
+        gchar *output;
+        if (!osinfo_install_script_apply_template_xsl(script,
+                                                      templateXsl,
+                                                      os,
+                                                      media,
+                                                      tree,
+                                                      "install-script-config",
+                                                      &output,
+                                                      data->config,
+                                                      &error)) {
+            g_prefix_error(&error, _("Failed to apply script template %s: "), templateUri);
+            g_task_return_error(data->res, error);
+        } else {
+            g_task_return_pointer(data->res, output, g_free);
+        }
+        osinfo_install_script_template_unref(templateXsl);
+        osinfo_install_script_generate_data_free(data);
     } else {
         GFile *file = g_file_new_for_uri(templateUri);
 
@@ -1108,6 +2151,104 @@ static void osinfo_install_script_generate_async_common(OsinfoInstallScript *scr
     }
 }
 
+/**
+ * osinfo_install_script_preload:
+ * @script:     the install script
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: The location where to store any error, or %NULL
+ *
+ * Reads and compiles the script template ahead of time. Templates
+ * referenced by URI are kept in memory, and the URI is not read again
+ * when generating scripts. Calling this again revalidates the template
+ * and only reads it again when its modification time has changed.
+ *
+ * Returns: %TRUE on success, %FALSE on error.
+ *
+ * Since: 1.13.0
+ */
+gboolean osinfo_install_script_preload(OsinfoInstallScript *script,
+                                       GCancellable *cancellable,
+                                       GError **error)
+{
+    OsinfoInstallScriptTemplate *template;
+    const gchar *templateUri;
+    GFileInfo *info = NULL;
+    GFile *file = NULL;
+    gchar *input = NULL;
+    gboolean has_mtime = FALSE;
+    guint64 mtime = 0;
+    gboolean fresh;
+    gboolean ret = FALSE;
+
+    g_return_val_if_fail(OSINFO_IS_INSTALL_SCRIPT(script), FALSE);
+
+    if (osinfo_install_script_has_template_data(script)) {
+        if (!(template = osinfo_install_script_get_template(script, "<data>", NULL, error))) {
+            g_prefix_error(error, "%s", _("Failed to apply script template: "));
+            return FALSE;
+        }
+        osinfo_install_script_template_unref(template);
+        return TRUE;
+    }
+
+    templateUri = osinfo_install_script_get_template_uri(script);
+    file = g_file_new_for_uri(templateUri);
+
+    /* Not all URIs report a modification time, those are always read */
+    if (!(info = g_file_query_info(file,
+                                   G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                                   G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                                   G_FILE_QUERY_INFO_NONE,
+                                   cancellable,
+                                   error))) {
+        g_prefix_error(error, _("Failed to load script template %s: "), templateUri);
+        goto cleanup;
+    }
+    if (g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_TIME_MODIFIED)) {
+        has_mtime = TRUE;
+        mtime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED) *
+            G_USEC_PER_SEC +
+            g_file_info_get_attribute_uint32(info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+    }
+
+    g_mutex_lock(&script->priv->template_lock);
+    template = script->priv->template;
+    fresh = template != NULL &&
+        g_strcmp0(template->uri, templateUri) == 0 &&
+        has_mtime && template->has_mtime && template->mtime == mtime;
+    g_mutex_unlock(&script->priv->template_lock);
+    if (fresh) {
+        ret = TRUE;
+        goto cleanup;
+    }
+
+    if (!g_file_load_contents(file, cancellable, &input, NULL, NULL, error)) {
+        g_prefix_error(error, _("Failed to load script template %s: "), templateUri);
+        goto cleanup;
+    }
+
+    if (!(template = osinfo_install_script_get_template(script, templateUri, input, error))) {
+        g_prefix_error(error, _("Failed to apply script template %s: "), templateUri);
+        goto cleanup;
+    }
+
+    g_mutex_lock(&script->priv->template_lock);
+    if (template->uri == NULL)
+        template->uri = g_strdup(templateUri);
+    template->has_mtime = has_mtime;
+    template->mtime = mtime;
+    g_mutex_unlock(&script->priv->template_lock);
+    osinfo_install_script_template_unref(template);
+
+    ret = TRUE;
+
+ cleanup:
+    g_free(input);
+    g_clear_object(&info);
+    g_object_unref(file);
+    return ret;
+}
+
 /**
  * osinfo_install_script_generate_async:
  * @script:     the install script
@@ -1275,45 +2416,6 @@ struct _OsinfoInstallScriptGenerateSyncData {
     GFile *file;
 };
 
-static void osinfo_install_script_generate_output_done(GObject *src,
-                                                       GAsyncResult *res,
-                                                       gpointer user_data)
-{
-    OsinfoInstallScriptGenerateSyncData *data = user_data;
-
-    data->file =
-        osinfo_install_script_generate_output_finish(OSINFO_INSTALL_SCRIPT(src),
-                                                     res,
-                                                     &data->error);
-    g_main_loop_quit(data->loop);
-}
-
-static void osinfo_install_script_generate_output_for_media_done(GObject *src,
-                                                                 GAsyncResult *res,
-                                                                 gpointer user_data)
-{
-    OsinfoInstallScriptGenerateSyncData *data = user_data;
-
-    data->file =
-        osinfo_install_script_generate_output_for_media_finish(OSINFO_INSTALL_SCRIPT(src),
-                                                               res,
-                                                               &data->error);
-    g_main_loop_quit(data->loop);
-}
-
-static void osinfo_install_script_generate_output_for_tree_done(GObject *src,
-                                                                 GAsyncResult *res,
-                                                                 gpointer user_data)
-{
-    OsinfoInstallScriptGenerateSyncData *data = user_data;
-
-    data->file =
-        osinfo_install_script_generate_output_for_tree_finish(OSINFO_INSTALL_SCRIPT(src),
-                                                              res,
-                                                              &data->error);
-    g_main_loop_quit(data->loop);
-}
-
 static void osinfo_install_script_generate_output_close_file(GObject *src,
                                                             GAsyncResult *res,
                                                             gpointer user_data)
@@ -1614,6 +2716,29 @@ static void osinfo_install_script_generate_output_write_file(GObject *src,
     }
 }
 
+static GFile *osinfo_install_script_get_output_file(OsinfoInstallScript *script,
+                                                   GFile *output_dir)
+{
+    const gchar *filename;
+    const gchar *prefix;
+    GFile *file;
+
+    prefix =
+        osinfo_install_script_get_output_prefix(script);
+    filename =
+        osinfo_install_script_get_output_filename(script);
+
+    if (prefix) {
+        gchar *output_filename  = g_strdup_printf("%s-%s", prefix, filename);
+        file = g_file_get_child(output_dir, output_filename);
+        g_free(output_filename);
+    } else {
+        file = g_file_get_child(output_dir, filename);
+    }
+
+    return file;
+}
+
 static void osinfo_install_script_generate_output_async_common(OsinfoInstallScript *script,
                                                                OsinfoOs *os,
                                                                OsinfoMedia *media,
@@ -1624,19 +2749,14 @@ static void osinfo_install_script_generate_output_async_common(OsinfoInstallScri
                                                                GAsyncReadyCallback callback,
                                                                gpointer user_data)
 {
-    const gchar *filename;
-    const gchar *prefix;
     OsinfoInstallScriptGenerateOutputData *data =
         g_new0(OsinfoInstallScriptGenerateOutputData, 1);
 
-    OsinfoInstallScriptGenerateSyncData *data_sync = user_data;
-
     data->res = g_task_new(G_OBJECT(script),
                            cancellable,
                            callback,
                            user_data);
 
-    data->error = data_sync->error;
     if (media != NULL) {
         data->output = osinfo_install_script_generate_for_media(script,
                                                                 media,
@@ -1659,18 +2779,7 @@ static void osinfo_install_script_generate_output_async_common(OsinfoInstallScri
     data->output_pos = 0;
     data->output_len = strlen(data->output);
 
-    prefix =
-        osinfo_install_script_get_output_prefix(script);
-    filename =
-        osinfo_install_script_get_output_filename(script);
-
-    if (prefix) {
-        gchar *output_filename  = g_strdup_printf("%s-%s", prefix, filename);
-        data->file = g_file_get_child(output_dir, output_filename);
-        g_free(output_filename);
-    } else {
-        data->file = g_file_get_child(output_dir, filename);
-    }
+    data->file = osinfo_install_script_get_output_file(script, output_dir);
 
     g_file_replace_async(data->file,
                          NULL,
@@ -1721,6 +2830,16 @@ void osinfo_install_script_generate_output_async(OsinfoInstallScript *script,
                                                        user_data);
 }
 
+static gboolean osinfo_install_script_generate_to_common(OsinfoInstallScript *script,
+                                                         OsinfoOs *os,
+                                                         OsinfoMedia *media,
+                                                         OsinfoTree *tree,
+                                                         OsinfoInstallConfig *config,
+                                                         GOutputStream *stream,
+                                                         int fd,
+                                                         GCancellable *cancellable,
+                                                         GError **error);
+
 static GFile *osinfo_install_script_generate_output_common(OsinfoInstallScript *script,
                                                            OsinfoOs *os,
                                                            OsinfoMedia *media,
@@ -1730,49 +2849,55 @@ static GFile *osinfo_install_script_generate_output_common(OsinfoInstallScript *
                                                            GCancellable *cancellable,
                                                            GError **error)
 {
-    GMainLoop *loop = g_main_loop_new(g_main_context_get_thread_default(),
-                                      FALSE);
-    OsinfoInstallScriptGenerateSyncData data = {
-        loop, NULL, NULL, NULL
-    };
+    GFile *file = osinfo_install_script_get_output_file(script, output_dir);
+    GFileOutputStream *stream;
+    gboolean existed;
 
-    if (media != NULL) {
-        osinfo_install_script_generate_output_for_media_async
-            (script,
-             media,
-             config,
-             output_dir,
-             cancellable,
-             osinfo_install_script_generate_output_for_media_done,
-             &data);
-    } else if (tree != NULL) {
-        osinfo_install_script_generate_output_for_tree_async
-            (script,
-             tree,
-             config,
-             output_dir,
-             cancellable,
-             osinfo_install_script_generate_output_for_tree_done,
-             &data);
-    } else {
-        osinfo_install_script_generate_output_async
-            (script,
-             os,
-             config,
-             output_dir,
-             cancellable,
-             osinfo_install_script_generate_output_done,
-             &data);
-    }
+    existed = g_file_query_file_type(file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                     cancellable) != G_FILE_TYPE_UNKNOWN;
 
-    g_main_loop_run(loop);
+    if (!(stream = g_file_replace(file,
+                                  NULL,
+                                  TRUE,
+                                  G_FILE_CREATE_NONE,
+                                  cancellable,
+                                  error)))
+        goto error;
 
-    if (data.error)
-        g_propagate_error(error, data.error);
+    /* The script is streamed straight into the file, rather than being
+     * built in memory and then written out */
+    if (!osinfo_install_script_generate_to_common(script,
+                                                  os,
+                                                  media,
+                                                  tree,
+                                                  config,
+                                                  G_OUTPUT_STREAM(stream),
+                                                  -1,
+                                                  cancellable,
+                                                  error)) {
+        /* Closing with a cancelled cancellable discards the new file
+         * instead of replacing the existing one */
+        GCancellable *abort = g_cancellable_new();
+        g_cancellable_cancel(abort);
+        g_output_stream_close(G_OUTPUT_STREAM(stream), abort, NULL);
+        g_object_unref(abort);
+        goto error;
+    }
 
-    g_main_loop_unref(loop);
+    if (!g_output_stream_close(G_OUTPUT_STREAM(stream), cancellable, error))
+        goto error;
+
+    g_object_unref(stream);
+    return file;
 
-    return data.file;
+ error:
+    /* Without an existing target, g_file_replace() writes to the new
+     * file directly, so it is removed rather than left incomplete */
+    if (stream != NULL && !existed)
+        g_file_delete(file, NULL, NULL);
+    g_clear_object(&stream);
+    g_object_unref(file);
+    return NULL;
 }
 
 /**
@@ -1954,6 +3079,885 @@ GFile *osinfo_install_script_generate_output_for_tree(OsinfoInstallScript *scrip
                                                         error);
 }
 
+
+typedef struct _OsinfoInstallScriptBatchData OsinfoInstallScriptBatchData;
+
+struct _OsinfoInstallScriptBatchData {
+    OsinfoInstallScript *script;
+    OsinfoInstallScriptTemplate *template;
+    OsinfoOs *os;
+    OsinfoMedia *media;
+    OsinfoTree *tree;
+    OsinfoInstallConfig **configs;
+    GFile *output_dir;
+    const gchar *filename;
+    GCancellable *cancellable;
+
+    /* One slot per config, each only written by the job for that config */
+    gchar **outputs;
+    GFile **files;
+
+    /* Protects error */
+    GMutex lock;
+    GError *error;
+};
+
+
+static gboolean
+osinfo_install_script_batch_failed(OsinfoInstallScriptBatchData *data)
+{
+    gboolean failed;
+
+    g_mutex_lock(&data->lock);
+    failed = data->error != NULL;
+    g_mutex_unlock(&data->lock);
+
+    return failed;
+}
+
+
+static void osinfo_install_script_batch_worker(gpointer job,
+                                               gpointer opaque)
+{
+    OsinfoInstallScriptBatchData *data = opaque;
+    gsize idx = GPOINTER_TO_SIZE(job) - 1;
+    GError *error = NULL;
+    gchar *output = NULL;
+    gchar *name = NULL;
+    GFile *file = NULL;
+
+    if (osinfo_install_script_batch_failed(data))
+        return;
+
+    if (g_cancellable_set_error_if_cancelled(data->cancellable, &error))
+        goto cleanup;
+
+    if (!osinfo_install_script_apply_template_xsl(data->script,
+                                                  data->template,
+                                                  data->os,
+                                                  data->media,
+                                                  data->tree,
+                                                  "install-script-config",
+                                                  &output,
+                                                  data->configs[idx],
+                                                  &error)) {
+        g_prefix_error(&error, "%s", _("Failed to apply script template: "));
+        goto cleanup;
+    }
+
+    if (data->output_dir == NULL) {
+        data->outputs[idx] = g_steal_pointer(&output);
+        goto cleanup;
+    }
+
+    name = g_strdup_printf("%" G_GSIZE_FORMAT "-%s", idx, data->filename);
+    file = g_file_get_child(data->output_dir, name);
+    if (!g_file_replace_contents(file,
+                                 output,
+                                 strlen(output),
+                                 NULL,
+                                 FALSE,
+                                 G_FILE_CREATE_NONE,
+                                 NULL,
+                                 data->cancellable,
+                                 &error))
+        goto cleanup;
+
+    data->files[idx] = g_steal_pointer(&file);
+
+ cleanup:
+    if (error != NULL) {
+        g_mutex_lock(&data->lock);
+        if (data->error == NULL)
+            data->error = g_steal_pointer(&error);
+        g_mutex_unlock(&data->lock);
+        g_clear_error(&error);
+    }
+    g_clear_object(&file);
+    g_free(name);
+    g_free(output);
+}
+
+
+static OsinfoInstallScriptTemplate *
+osinfo_install_script_load_script_template(OsinfoInstallScript *script,
+                                           GCancellable *cancellable,
+                                           GError **error)
+{
+    OsinfoInstallScriptTemplate *template;
+    const gchar *templateUri;
+    GFile *file;
+    gchar *input = NULL;
+
+    if (osinfo_install_script_has_template_data(script)) {
+        if (!(template = osinfo_install_script_get_template(script, "<data>", NULL, error)))
+            g_prefix_error(error, "%s", _("Failed to apply script template: "));
+        return template;
+    }
+
+    templateUri = osinfo_install_script_get_template_uri(script);
+    if ((template = osinfo_install_script_get_preloaded_template(script, templateUri)))
+        return template;
+
+    file = g_file_new_for_uri(templateUri);
+    if (!g_file_load_contents(file, cancellable, &input, NULL, NULL, error)) {
+        g_prefix_error(error, _("Failed to load script template %s: "), templateUri);
+        g_object_unref(file);
+        return NULL;
+    }
+    g_object_unref(file);
+
+    if (!(template = osinfo_install_script_get_template(script, templateUri, input, error)))
+        g_prefix_error(error, _("Failed to apply script template %s: "), templateUri);
+
+    g_free(input);
+    return template;
+}
+
+
+/*
+ * Returns a reference on @os, or on the OS of @media or @tree when
+ * @os is NULL.
+ */
+static OsinfoOs *
+osinfo_install_script_resolve_os(OsinfoOs *os,
+                                 OsinfoMedia *media,
+                                 OsinfoTree *tree,
+                                 GError **error)
+{
+    OsinfoOs *ret = NULL;
+
+    if (os != NULL)
+        ret = g_object_ref(os);
+    else if (media != NULL)
+        ret = osinfo_media_get_os(media);
+    else if (tree != NULL)
+        ret = osinfo_tree_get_os(tree);
+
+    if (ret == NULL)
+        g_set_error_literal(error, OSINFO_ERROR, 0,
+                            _("No OS provided for the install script"));
+
+    return ret;
+}
+
+
+static gboolean osinfo_install_script_generate_batch_common(OsinfoInstallScript *script,
+                                                            OsinfoOs *os,
+                                                            OsinfoMedia *media,
+                                                            OsinfoTree *tree,
+                                                            OsinfoInstallConfig **configs,
+                                                            gsize n_configs,
+                                                            GFile *output_dir,
+                                                            gchar **outputs,
+                                                            GFile **files,
+                                                            GCancellable *cancellable,
+                                                            GError **error)
+{
+    OsinfoInstallScriptBatchData data = { 0 };
+    GThreadPool *pool;
+    gboolean ret = FALSE;
+    gsize i;
+
+    data.script = script;
+    data.media = media;
+    data.tree = tree;
+    data.configs = configs;
+    data.output_dir = output_dir;
+    data.filename = osinfo_install_script_get_output_filename(script);
+    data.cancellable = cancellable;
+    data.outputs = outputs;
+    data.files = files;
+    g_mutex_init(&data.lock);
+
+    if (!(data.os = osinfo_install_script_resolve_os(os, media, tree, error)))
+        goto cleanup;
+
+    if (output_dir != NULL && data.filename == NULL) {
+        g_set_error_literal(error, OSINFO_ERROR, 0,
+                            _("Install script has no output filename"));
+        goto cleanup;
+    }
+
+    if (!(data.template = osinfo_install_script_load_script_template(script,
+                                                                     cancellable,
+                                                                     error)))
+        goto cleanup;
+
+    /* libxml2 must be initialized before it is used from several threads */
+    xmlInitParser();
+
+    if (!(pool = g_thread_pool_new(osinfo_install_script_batch_worker,
+                                   &data,
+                                   (gint)MIN(n_configs, g_get_num_processors()),
+                                   FALSE,
+                                   error)))
+        goto cleanup;
+
+    for (i = 0; i < n_configs; i++)
+        g_thread_pool_push(pool, GSIZE_TO_POINTER(i + 1), NULL);
+
+    /* Waits for every queued config to be processed */
+    g_thread_pool_free(pool, FALSE, TRUE);
+
+    if (data.error != NULL) {
+        g_propagate_error(error, g_steal_pointer(&data.error));
+        goto cleanup;
+    }
+
+    ret = TRUE;
+
+ cleanup:
+    if (data.template != NULL)
+        osinfo_install_script_template_unref(data.template);
+    g_clear_object(&data.os);
+    g_mutex_clear(&data.lock);
+    return ret;
+}
+
+
+/**
+ * osinfo_install_script_generate_batch:
+ * @script:     the install script
+ * @os: (allow-none): the os, or %NULL to use the one of @media or @tree
+ * @media: (allow-none): the media, or %NULL
+ * @tree: (allow-none): the tree, or %NULL
+ * @configs: (array length=n_configs): the install script configs
+ * @n_configs: the number of elements in @configs
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: The location where to store any error, or %NULL
+ *
+ * Creates an install script for each of the @configs. The script template
+ * is only compiled once and the transforms are run in parallel on a pool
+ * of worker threads.
+ *
+ * This is equivalent to calling #osinfo_install_script_generate(),
+ * #osinfo_install_script_generate_for_media() or
+ * #osinfo_install_script_generate_for_tree() once for each config, but
+ * considerably faster when generating scripts for many guests.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): the generated scripts,
+ * in the same order as @configs, or %NULL on error.
+ *
+ * Since: 1.13.0
+ */
+gchar **osinfo_install_script_generate_batch(OsinfoInstallScript *script,
+                                             OsinfoOs *os,
+                                             OsinfoMedia *media,
+                                             OsinfoTree *tree,
+                                             OsinfoInstallConfig **configs,
+                                             gsize n_configs,
+                                             GCancellable *cancellable,
+                                             GError **error)
+{
+    gchar **outputs;
+
+    g_return_val_if_fail(OSINFO_IS_INSTALL_SCRIPT(script), NULL);
+    g_return_val_if_fail(configs != NULL || n_configs == 0, NULL);
+
+    outputs = g_new0(gchar *, n_configs + 1);
+    if (n_configs == 0)
+        return outputs;
+
+    if (!osinfo_install_script_generate_batch_common(script,
+                                                     os,
+                                                     media,
+                                                     tree,
+                                                     configs,
+                                                     n_configs,
+                                                     NULL,
+                                                     outputs,
+                                                     NULL,
+                                                     cancellable,
+                                                     error)) {
+        g_strfreev(outputs);
+        return NULL;
+    }
+
+    return outputs;
+}
+
+
+/**
+ * osinfo_install_script_generate_output_batch:
+ * @script:     the install script
+ * @os: (allow-none): the os, or %NULL to use the one of @media or @tree
+ * @media: (allow-none): the media, or %NULL
+ * @tree: (allow-none): the tree, or %NULL
+ * @configs: (array length=n_configs): the install script configs
+ * @n_configs: the number of elements in @configs
+ * @output_dir: the directory where the files containing the output scripts
+ *              will be written
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: The location where to store any error, or %NULL
+ *
+ * Same as #osinfo_install_script_generate_batch(), but the script created
+ * for the n-th config is written to a file named after the index of the
+ * config and the script's output filename, for example "0-fedora.ks".
+ * On error, the files already written are removed.
+ *
+ * Returns: (transfer full) (element-type GFile): the files containing the
+ * scripts, in the same order as @configs, or %NULL on error.
+ *
+ * Since: 1.13.0
+ */
+GList *osinfo_install_script_generate_output_batch(OsinfoInstallScript *script,
+                                                   OsinfoOs *os,
+                                                   OsinfoMedia *media,
+                                                   OsinfoTree *tree,
+                                                   OsinfoInstallConfig **configs,
+                                                   gsize n_configs,
+                                                   GFile *output_dir,
+                                                   GCancellable *cancellable,
+                                                   GError **error)
+{
+    GFile **files;
+    GList *ret = NULL;
+    gboolean ok;
+    gsize i;
+
+    g_return_val_if_fail(OSINFO_IS_INSTALL_SCRIPT(script), NULL);
+    g_return_val_if_fail(configs != NULL || n_configs == 0, NULL);
+    g_return_val_if_fail(G_IS_FILE(output_dir), NULL);
+
+    if (n_configs == 0)
+        return NULL;
+
+    files = g_new0(GFile *, n_configs);
+    ok = osinfo_install_script_generate_batch_common(script,
+                                                     os,
+                                                     media,
+                                                     tree,
+                                                     configs,
+                                                     n_configs,
+                                                     output_dir,
+                                                     NULL,
+                                                     files,
+                                                     cancellable,
+                                                     error);
+
+    for (i = n_configs; i > 0; i--) {
+        if (ok) {
+            ret = g_list_prepend(ret, files[i - 1]);
+        } else if (files[i - 1] != NULL) {
+            /* Don't leave the scripts of a failed batch behind */
+            g_file_delete(files[i - 1], NULL, NULL);
+            g_object_unref(files[i - 1]);
+        }
+    }
+    g_free(files);
+
+    return ret;
+}
+
+static gboolean osinfo_install_script_generate_to_common(OsinfoInstallScript *script,
+                                                         OsinfoOs *os,
+                                                         OsinfoMedia *media,
+                                                         OsinfoTree *tree,
+                                                         OsinfoInstallConfig *config,
+                                                         GOutputStream *stream,
+                                                         int fd,
+                                                         GCancellable *cancellable,
+                                                         GError **error)
+{
+    OsinfoInstallScriptTemplate *template = NULL;
+    OsinfoOs *scriptOs = NULL;
+    xmlDocPtr configXml = NULL;
+    gboolean ret = FALSE;
+
+    if (!(scriptOs = osinfo_install_script_resolve_os(os, media, tree, error)))
+        goto cleanup;
+
+    if (!(template = osinfo_install_script_load_script_template(script,
+                                                                cancellable,
+                                                                error)))
+        goto cleanup;
+
+    if (!(configXml = osinfo_install_script_generate_config_xml(script,
+                                                                template,
+                                                                scriptOs,
+                                                                media,
+                                                                tree,
+                                                                config,
+                                                                "install-script-config",
+                                                                error)))
+        goto cleanup;
+
+    if (stream != NULL)
+        ret = osinfo_install_script_apply_xslt_to_stream(template->xsl,
+                                                         configXml,
+                                                         stream,
+                                                         cancellable,
+                                                         error);
+    else
+        ret = osinfo_install_script_apply_xslt_to_fd(template->xsl,
+                                                     configXml,
+                                                     fd,
+                                                     error);
+    if (!ret)
+        g_prefix_error(error, "%s", _("Failed to apply script template: "));
+
+ cleanup:
+    xmlFreeDoc(configXml);
+    if (template != NULL)
+        osinfo_install_script_template_unref(template);
+    g_clear_object(&scriptOs);
+    return ret;
+}
+
+
+/**
+ * osinfo_install_script_generate_to_stream:
+ * @script:     the install script
+ * @os: (allow-none): the os, or %NULL to use the one of @media or @tree
+ * @media: (allow-none): the media, or %NULL
+ * @tree: (allow-none): the tree, or %NULL
+ * @config:     the install script config
+ * @stream:     the stream to write the script to
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: The location where to store any error, or %NULL
+ *
+ * Creates an install script and writes it to @stream as it is being
+ * serialized, without building the whole script in memory first. The
+ * stream is not closed.
+ *
+ * Returns: %TRUE on success, %FALSE on error.
+ *
+ * Since: 1.13.0
+ */
+gboolean osinfo_install_script_generate_to_stream(OsinfoInstallScript *script,
+                                                  OsinfoOs *os,
+                                                  OsinfoMedia *media,
+                                                  OsinfoTree *tree,
+                                                  OsinfoInstallConfig *config,
+                                                  GOutputStream *stream,
+                                                  GCancellable *cancellable,
+                                                  GError **error)
+{
+    g_return_val_if_fail(OSINFO_IS_INSTALL_SCRIPT(script), FALSE);
+    g_return_val_if_fail(OSINFO_IS_INSTALL_CONFIG(config), FALSE);
+    g_return_val_if_fail(G_IS_OUTPUT_STREAM(stream), FALSE);
+
+    return osinfo_install_script_generate_to_common(script,
+                                                    os,
+                                                    media,
+                                                    tree,
+                                                    config,
+                                                    stream,
+                                                    -1,
+                                                    cancellable,
+                                                    error);
+}
+
+
+/**
+ * osinfo_install_script_generate_to_fd:
+ * @script:     the install script
+ * @os: (allow-none): the os, or %NULL to use the one of @media or @tree
+ * @media: (allow-none): the media, or %NULL
+ * @tree: (allow-none): the tree, or %NULL
+ * @config:     the install script config
+ * @fd:         the file descriptor to write the script to
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: The location where to store any error, or %NULL
+ *
+ * Same as #osinfo_install_script_generate_to_stream(), but writes the
+ * script to a file descriptor, which is not closed. @cancellable is
+ * only honoured while the script template is being loaded.
+ *
+ * Returns: %TRUE on success, %FALSE on error.
+ *
+ * Since: 1.13.0
+ */
+gboolean osinfo_install_script_generate_to_fd(OsinfoInstallScript *script,
+                                              OsinfoOs *os,
+                                              OsinfoMedia *media,
+                                              OsinfoTree *tree,
+                                              OsinfoInstallConfig *config,
+                                              int fd,
+                                              GCancellable *cancellable,
+                                              GError **error)
+{
+    g_return_val_if_fail(OSINFO_IS_INSTALL_SCRIPT(script), FALSE);
+    g_return_val_if_fail(OSINFO_IS_INSTALL_CONFIG(config), FALSE);
+    g_return_val_if_fail(fd >= 0, FALSE);
+
+    return osinfo_install_script_generate_to_common(script,
+                                                    os,
+                                                    media,
+                                                    tree,
+                                                    config,
+                                                    NULL,
+                                                    fd,
+                                                    cancellable,
+                                                    error);
+}
+
+/*
+ * Writer for "newc" cpio archives, the format the Linux kernel expects
+ * for initramfs images. Archives appended to an existing initrd are
+ * unpacked on top of it.
+ */
+#define OSINFO_CPIO_MODE_DIR  0040755
+#define OSINFO_CPIO_MODE_FILE 0100644
+#define OSINFO_CPIO_TRAILER   "TRAILER!!!"
+
+typedef struct _OsinfoInstallScriptArchive OsinfoInstallScriptArchive;
+
+struct _OsinfoInstallScriptArchive {
+    GOutputStream *stream;
+    GCancellable *cancellable;
+    guint32 ino;
+    /* Paths of the entries written so far */
+    GHashTable *entries;
+};
+
+static gboolean osinfo_install_script_archive_pad(OsinfoInstallScriptArchive *archive,
+                                                  gsize len,
+                                                  GError **error)
+{
+    static const gchar zeros[4] = { 0 };
+    gsize pad = (4 - (len % 4)) % 4;
+
+    if (pad == 0)
+        return TRUE;
+
+    return g_output_stream_write_all(archive->stream, zeros, pad, NULL,
+                                     archive->cancellable, error);
+}
+
+static gboolean osinfo_install_script_archive_write_header(OsinfoInstallScriptArchive *archive,
+                                                           const gchar *name,
+                                                           guint32 mode,
+                                                           guint64 size,
+                                                           GError **error)
+{
+    gsize namesize = strlen(name) + 1;
+    gboolean trailer = g_str_equal(name, OSINFO_CPIO_TRAILER);
+    gchar *header;
+    gboolean ret;
+
+    if (size > G_MAXUINT32) {
+        g_set_error(error, OSINFO_ERROR, 0,
+                    _("File %s is too large for the archive"), name);
+        return FALSE;
+    }
+
+    header = g_strdup_printf("070701"
+                             "%08X%08X%08X%08X%08X%08X%08X"
+                             "%08X%08X%08X%08X%08X%08X",
+                             trailer ? 0 : ++archive->ino, /* ino */
+                             mode,
+                             0, /* uid */
+                             0, /* gid */
+                             mode == OSINFO_CPIO_MODE_DIR ? 2 : 1, /* nlink */
+                             0, /* mtime */
+                             (guint32)size,
+                             0, 0, /* devmajor, devminor */
+                             0, 0, /* rdevmajor, rdevminor */
+                             (guint32)namesize,
+                             0 /* check */);
+
+    ret = g_output_stream_write_all(archive->stream, header, strlen(header), NULL,
+                                    archive->cancellable, error) &&
+        g_output_stream_write_all(archive->stream, name, namesize, NULL,
+                                  archive->cancellable, error) &&
+        osinfo_install_script_archive_pad(archive, strlen(header) + namesize, error);
+
+    g_free(header);
+    return ret;
+}
+
+/*
+ * Adds the entry for @path, preceded by entries for its parent
+ * directories when they were not added yet.
+ */
+static gboolean osinfo_install_script_archive_add_entry(OsinfoInstallScriptArchive *archive,
+                                                        const gchar *path,
+                                                        guint64 size,
+                                                        GError **error)
+{
+    const gchar *sep;
+
+    for (sep = strchr(path, '/'); sep != NULL; sep = strchr(sep + 1, '/')) {
+        gchar *dir = g_strndup(path, sep - path);
+
+        if (g_hash_table_contains(archive->entries, dir)) {
+            g_free(dir);
+            continue;
+        }
+
+        if (!osinfo_install_script_archive_write_header(archive, dir,
+                                                        OSINFO_CPIO_MODE_DIR,
+                                                        0, error)) {
+            g_free(dir);
+            return FALSE;
+        }
+        g_hash_table_add(archive->entries, dir);
+    }
+
+    if (g_hash_table_contains(archive->entries, path)) {
+        g_set_error(error, OSINFO_ERROR, 0,
+                    _("Duplicate archive entry %s"), path);
+        return FALSE;
+    }
+    g_hash_table_add(archive->entries, g_strdup(path));
+
+    return osinfo_install_script_archive_write_header(archive, path,
+                                                      OSINFO_CPIO_MODE_FILE,
+                                                      size, error);
+}
+
+static gboolean osinfo_install_script_archive_add_data(OsinfoInstallScriptArchive *archive,
+                                                       const gchar *path,
+                                                       gconstpointer data,
+                                                       gsize size,
+                                                       GError **error)
+{
+    return osinfo_install_script_archive_add_entry(archive, path, size, error) &&
+        g_output_stream_write_all(archive->stream, data, size, NULL,
+                                  archive->cancellable, error) &&
+        osinfo_install_script_archive_pad(archive, size, error);
+}
+
+static gboolean osinfo_install_script_archive_add_file(OsinfoInstallScriptArchive *archive,
+                                                       const gchar *path,
+                                                       GFile *file,
+                                                       GError **error)
+{
+    GFileInfo *info = NULL;
+    GFileInputStream *input = NULL;
+    gchar *data = NULL;
+    gsize len;
+    gssize copied;
+    guint64 size;
+    gboolean ret = FALSE;
+
+    if (!(info = g_file_query_info(file,
+                                   G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                   G_FILE_QUERY_INFO_NONE,
+                                   archive->cancellable,
+                                   error)))
+        goto cleanup;
+
+    /* Remote files may not report their size upfront */
+    if (!g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_STANDARD_SIZE)) {
+        if (!g_file_load_contents(file, archive->cancellable, &data, &len, NULL, error))
+            goto cleanup;
+        ret = osinfo_install_script_archive_add_data(archive, path, data, len, error);
+        goto cleanup;
+    }
+
+    size = g_file_info_get_size(info);
+    if (!(input = g_file_read(file, archive->cancellable, error)))
+        goto cleanup;
+
+    if (!osinfo_install_script_archive_add_entry(archive, path, size, error))
+        goto cleanup;
+
+    if ((copied = g_output_stream_splice(archive->stream,
+                                         G_INPUT_STREAM(input),
+                                         G_OUTPUT_STREAM_SPLICE_NONE,
+                                         archive->cancellable,
+                                         error)) < 0)
+        goto cleanup;
+
+    if ((guint64)copied != size) {
+        g_set_error(error, OSINFO_ERROR, 0,
+                    _("File %s changed while being archived"), path);
+        goto cleanup;
+    }
+
+    ret = osinfo_install_script_archive_pad(archive, size, error);
+
+ cleanup:
+    if (!ret)
+        g_prefix_error(error, _("Unable to archive %s: "), path);
+    g_free(data);
+    g_clear_object(&input);
+    g_clear_object(&info);
+    return ret;
+}
+
+/*
+ * Whether @name is a relative path which stays below the directory it
+ * is resolved against.
+ */
+static gboolean osinfo_install_script_archive_is_relative(const gchar *name)
+{
+    gchar **segments;
+    gboolean ret = TRUE;
+    gsize i;
+
+    if (name == NULL || *name == '\0' || g_path_is_absolute(name))
+        return FALSE;
+
+    segments = g_strsplit(name, "/", -1);
+    for (i = 0; ret && segments[i] != NULL; i++) {
+        ret = *segments[i] != '\0' &&
+            !g_str_equal(segments[i], ".") &&
+            !g_str_equal(segments[i], "..");
+    }
+    g_strfreev(segments);
+
+    return ret;
+}
+
+static gboolean osinfo_install_script_archive_add_driver(OsinfoInstallScriptArchive *archive,
+                                                         OsinfoDeviceDriver *driver,
+                                                         GError **error)
+{
+    const gchar *location = osinfo_device_driver_get_location(driver);
+    const gchar *arch = osinfo_device_driver_get_architecture(driver);
+    GList *files = osinfo_device_driver_get_files(driver);
+    GList *tmp;
+    GFile *base;
+    gboolean ret = TRUE;
+
+    if (location == NULL) {
+        g_list_free(files);
+        return TRUE;
+    }
+
+    if (arch != NULL && !osinfo_install_script_archive_is_relative(arch)) {
+        g_set_error(error, OSINFO_ERROR, 0,
+                    _("Invalid architecture %s of driver %s"),
+                    arch, osinfo_entity_get_id(OSINFO_ENTITY(driver)));
+        g_list_free(files);
+        return FALSE;
+    }
+
+    base = g_file_new_for_uri(location);
+    for (tmp = files; ret && tmp != NULL; tmp = tmp->next) {
+        GFile *file;
+        gchar *path;
+
+        if (!osinfo_install_script_archive_is_relative(tmp->data)) {
+            g_set_error(error, OSINFO_ERROR, 0,
+                        _("Invalid file name %s of driver %s"),
+                        (const gchar *)tmp->data,
+                        osinfo_entity_get_id(OSINFO_ENTITY(driver)));
+            ret = FALSE;
+            break;
+        }
+
+        /* Drivers for different architectures often share file names */
+        file = g_file_resolve_relative_path(base, tmp->data);
+        if (arch != NULL)
+            path = g_strdup_printf("drivers/%s/%s", arch, (const gchar *)tmp->data);
+        else
+            path = g_strdup_printf("drivers/%s", (const gchar *)tmp->data);
+
+        ret = osinfo_install_script_archive_add_file(archive, path, file, error);
+
+        g_free(path);
+        g_object_unref(file);
+    }
+
+    g_object_unref(base);
+    g_list_free(files);
+    return ret;
+}
+
+/**
+ * osinfo_install_script_generate_initrd_archive:
+ * @scripts: (element-type OsinfoInstallScript): the install scripts
+ * @os: (allow-none): the os, or %NULL to use the one of @media or @tree
+ * @media: (allow-none): the media, or %NULL
+ * @tree: (allow-none): the tree, or %NULL
+ * @config:     the install script config
+ * @drivers: (allow-none): the drivers to add to the archive, or %NULL
+ * @stream:     the stream to write the archive to
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: The location where to store any error, or %NULL
+ *
+ * Generates @scripts and writes them, along with the files of @drivers,
+ * to @stream as a "newc" cpio archive, ready to be appended to the
+ * installer's initrd for the
+ * #OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_INITRD injection method.
+ *
+ * Each script is stored at the root of the archive, under its output
+ * filename. Driver files are stored under a "drivers" directory, in a
+ * subdirectory named after the driver's architecture, using their path
+ * relative to the driver's location. The file names must be relative
+ * paths without ".." segments. The driver files are copied straight from
+ * their location into @stream. The stream is not closed.
+ *
+ * Returns: %TRUE on success, %FALSE on error.
+ *
+ * Since: 1.13.0
+ */
+gboolean osinfo_install_script_generate_initrd_archive(GList *scripts,
+                                                       OsinfoOs *os,
+                                                       OsinfoMedia *media,
+                                                       OsinfoTree *tree,
+                                                       OsinfoInstallConfig *config,
+                                                       OsinfoDeviceDriverList *drivers,
+                                                       GOutputStream *stream,
+                                                       GCancellable *cancellable,
+                                                       GError **error)
+{
+    OsinfoInstallScriptArchive archive = { stream, cancellable, 0, NULL };
+    GOutputStream *output = NULL;
+    GList *tmp;
+    gboolean ret = FALSE;
+    gint i;
+
+    g_return_val_if_fail(OSINFO_IS_INSTALL_CONFIG(config), FALSE);
+    g_return_val_if_fail(G_IS_OUTPUT_STREAM(stream), FALSE);
+
+    archive.entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    for (tmp = scripts; tmp != NULL; tmp = tmp->next) {
+        OsinfoInstallScript *script = OSINFO_INSTALL_SCRIPT(tmp->data);
+        const gchar *filename = osinfo_install_script_get_output_filename(script);
+
+        if (filename == NULL) {
+            g_set_error(error, OSINFO_ERROR, 0,
+                        _("Install script %s has no output filename"),
+                        osinfo_entity_get_id(OSINFO_ENTITY(script)));
+            goto cleanup;
+        }
+
+        /* The size of each entry goes in its header, so the script
+         * is generated in full before being written out */
+        output = g_memory_output_stream_new(NULL, 0, g_realloc, g_free);
+        if (!osinfo_install_script_generate_to_common(script, os, media, tree,
+                                                      config, output, -1,
+                                                      cancellable, error))
+            goto cleanup;
+
+        if (!osinfo_install_script_archive_add_data(&archive,
+                                                    filename,
+                                                    g_memory_output_stream_get_data(G_MEMORY_OUTPUT_STREAM(output)),
+                                                    g_memory_output_stream_get_data_size(G_MEMORY_OUTPUT_STREAM(output)),
+                                                    error))
+            goto cleanup;
+
+        g_clear_object(&output);
+    }
+
+    for (i = 0; drivers != NULL && i < osinfo_list_get_length(OSINFO_LIST(drivers)); i++) {
+        OsinfoEntity *driver = osinfo_list_get_nth(OSINFO_LIST(drivers), i);
+
+        if (!osinfo_install_script_archive_add_driver(&archive,
+                                                      OSINFO_DEVICE_DRIVER(driver),
+                                                      error))
+            goto cleanup;
+    }
+
+    if (!osinfo_install_script_archive_write_header(&archive, OSINFO_CPIO_TRAILER,
+                                                    0, 0, error))
+        goto cleanup;
+
+    ret = TRUE;
+
+ cleanup:
+    g_clear_object(&output);
+    g_hash_table_unref(archive.entries);
+    return ret;
+}
+
 /**
  * osinfo_install_script_generate_command_line:
  * @script: the install script
@@ -1982,17 +3986,17 @@ gchar *osinfo_install_script_generate_command_line(OsinfoInstallScript *script,
                                                    OsinfoOs *os,
                                                    OsinfoInstallConfig *config)
 {
-    const gchar *templateData = osinfo_install_script_get_template_data(script);
+    gboolean hasTemplateData = osinfo_install_script_has_template_data(script);
     gchar *output = NULL;
 
-    if (templateData) {
+    if (hasTemplateData) {
         GError *error = NULL;
         if (!osinfo_install_script_apply_template(script,
                                                   os,
                                                   NULL,
                                                   NULL,
                                                   "<data>",
-                                                  templateData,
+                                                  NULL,
                                                   "command-line",
                                                   &output,
                                                   config,
@@ -2027,7 +4031,7 @@ gchar *osinfo_install_script_generate_command_line_for_media(OsinfoInstallScript
                                                              OsinfoMedia *media,
                                                              OsinfoInstallConfig *config)
 {
-    const gchar *templateData = osinfo_install_script_get_template_data(script);
+    gboolean hasTemplateData = osinfo_install_script_has_template_data(script);
     gchar *output = NULL;
     OsinfoOs *os;
 
@@ -2036,14 +4040,14 @@ gchar *osinfo_install_script_generate_command_line_for_media(OsinfoInstallScript
     os = osinfo_media_get_os(media);
     g_return_val_if_fail(os != NULL, NULL);
 
-    if (templateData) {
+    if (hasTemplateData) {
         GError *error = NULL;
         if (!osinfo_install_script_apply_template(script,
                                                   os,
                                                   media,
                                                   NULL,
                                                   "<data>",
-                                                  templateData,
+                                                  NULL,
                                                   "command-line",
                                                   &output,
                                                   config,
@@ -2079,7 +4083,7 @@ gchar *osinfo_install_script_generate_command_line_for_tree(OsinfoInstallScript
                                                             OsinfoTree *tree,
                                                             OsinfoInstallConfig *config)
 {
-    const gchar *templateData = osinfo_install_script_get_template_data(script);
+    gboolean hasTemplateData = osinfo_install_script_has_template_data(script);
     gchar *output = NULL;
     OsinfoOs *os;
 
@@ -2088,14 +4092,14 @@ gchar *osinfo_install_script_generate_command_line_for_tree(OsinfoInstallScript
     os = osinfo_tree_get_os(tree);
     g_return_val_if_fail(os != NULL, NULL);
 
-    if (templateData) {
+    if (hasTemplateData) {
         GError *error = NULL;
         if (!osinfo_install_script_apply_template(script,
                                                   os,
                                                   NULL,
                                                   tree,
                                                   "<data>",
-                                                  templateData,
+                                                  NULL,
                                                   "command-line",
                                                   &output,
                                                   config,
@@ -2317,6 +4321,98 @@ osinfo_install_script_get_preferred_injection_method(OsinfoInstallScript *script
     return value->value;
 }
 
+static gchar *osinfo_install_script_index_key(const gchar *profile,
+                                              OsinfoInstallScriptInjectionMethod method)
+{
+    return g_strdup_printf("%s\n%u", profile, method);
+}
+
+static void osinfo_install_script_index_insert(GHashTable *index,
+                                               const gchar *profile,
+                                               OsinfoInstallScriptInjectionMethod method,
+                                               OsinfoInstallScript *script)
+{
+    gchar *key = osinfo_install_script_index_key(profile, method);
+    GPtrArray *scripts = g_hash_table_lookup(index, key);
+
+    /* The scripts are kept in the order they were added, the first one
+     * being preferred */
+    if (scripts == NULL) {
+        scripts = g_ptr_array_new_with_free_func(g_object_unref);
+        g_hash_table_insert(index, key, scripts);
+    } else {
+        g_free(key);
+    }
+
+    g_ptr_array_add(scripts, g_object_ref(script));
+}
+
+/*
+ * Creates an index of install scripts by profile and injection method,
+ * filled by osinfo_install_script_index_add() and queried by
+ * osinfo_install_script_index_lookup().
+ */
+GHashTable *osinfo_install_script_index_new(void)
+{
+    return g_hash_table_new_full(g_str_hash, g_str_equal,
+                                 g_free, (GDestroyNotify)g_ptr_array_unref);
+}
+
+void osinfo_install_script_index_add(GHashTable *index,
+                                     OsinfoInstallScriptList *scripts)
+{
+    gint i;
+
+    for (i = 0; i < osinfo_list_get_length(OSINFO_LIST(scripts)); i++) {
+        OsinfoInstallScript *script =
+            OSINFO_INSTALL_SCRIPT(osinfo_list_get_nth(OSINFO_LIST(scripts), i));
+        const gchar *profile = osinfo_install_script_get_profile(script);
+        guint methods = osinfo_install_script_get_injection_methods(script);
+        guint method;
+
+        if (profile == NULL)
+            continue;
+
+        osinfo_install_script_index_insert(index, profile, 0, script);
+        for (method = OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_CDROM;
+             method <= OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_WEB;
+             method <<= 1) {
+            if ((methods & method) != 0)
+                osinfo_install_script_index_insert(index, profile, method, script);
+        }
+    }
+}
+
+OsinfoInstallScript *
+osinfo_install_script_index_lookup(GHashTable *index,
+                                   const gchar *profile,
+                                   OsinfoInstallScriptInjectionMethod method)
+{
+    OsinfoInstallScript *script = NULL;
+    GPtrArray *scripts;
+    gchar *key;
+    guint lowest = method & (~(guint)method + 1);
+    guint i;
+
+    /* A script supporting several methods is among the scripts
+     * supporting any single one of them */
+    key = osinfo_install_script_index_key(profile, lowest);
+    scripts = g_hash_table_lookup(index, key);
+    g_free(key);
+
+    for (i = 0; scripts != NULL && i < scripts->len; i++) {
+        guint methods =
+            osinfo_install_script_get_injection_methods(scripts->pdata[i]);
+
+        if ((methods & method) == method) {
+            script = scripts->pdata[i];
+            break;
+        }
+    }
+
+    return script;
+}
+
 /**
  * osinfo_install_script_set_installation_source:
  * @script: the install script
@@ -24,6 +24,7 @@
 #include <gio/gio.h>
 #include <osinfo/osinfo_install_config_param.h>
 #include <osinfo/osinfo_avatar_format.h>
+#include <osinfo/osinfo_device_driverlist.h>
 
 #define OSINFO_TYPE_INSTALL_SCRIPT (osinfo_install_script_get_type ())
 OSINFO_DECLARE_TYPE_WITH_PRIVATE_AND_CLASS(OsinfoInstallScript,
@@ -149,6 +150,10 @@ const gchar *osinfo_install_script_get_expected_filename(OsinfoInstallScript *sc
 
 OsinfoAvatarFormat *osinfo_install_script_get_avatar_format(OsinfoInstallScript *script);
 
+gboolean osinfo_install_script_preload(OsinfoInstallScript *script,
+                                       GCancellable *cancellable,
+                                       GError **error);
+
 void osinfo_install_script_generate_async(OsinfoInstallScript *script,
                                           OsinfoOs *os,
                                           OsinfoInstallConfig *config,
@@ -217,6 +222,51 @@ GFile *osinfo_install_script_generate_output_for_media(OsinfoInstallScript *scri
                                                        GCancellable *cancellable,
                                                        GError **error);
 
+gchar **osinfo_install_script_generate_batch(OsinfoInstallScript *script,
+                                             OsinfoOs *os,
+                                             OsinfoMedia *media,
+                                             OsinfoTree *tree,
+                                             OsinfoInstallConfig **configs,
+                                             gsize n_configs,
+                                             GCancellable *cancellable,
+                                             GError **error);
+GList *osinfo_install_script_generate_output_batch(OsinfoInstallScript *script,
+                                                   OsinfoOs *os,
+                                                   OsinfoMedia *media,
+                                                   OsinfoTree *tree,
+                                                   OsinfoInstallConfig **configs,
+                                                   gsize n_configs,
+                                                   GFile *output_dir,
+                                                   GCancellable *cancellable,
+                                                   GError **error);
+
+gboolean osinfo_install_script_generate_to_stream(OsinfoInstallScript *script,
+                                                  OsinfoOs *os,
+                                                  OsinfoMedia *media,
+                                                  OsinfoTree *tree,
+                                                  OsinfoInstallConfig *config,
+                                                  GOutputStream *stream,
+                                                  GCancellable *cancellable,
+                                                  GError **error);
+gboolean osinfo_install_script_generate_to_fd(OsinfoInstallScript *script,
+                                              OsinfoOs *os,
+                                              OsinfoMedia *media,
+                                              OsinfoTree *tree,
+                                              OsinfoInstallConfig *config,
+                                              int fd,
+                                              GCancellable *cancellable,
+                                              GError **error);
+
+gboolean osinfo_install_script_generate_initrd_archive(GList *scripts,
+                                                       OsinfoOs *os,
+                                                       OsinfoMedia *media,
+                                                       OsinfoTree *tree,
+                                                       OsinfoInstallConfig *config,
+                                                       OsinfoDeviceDriverList *drivers,
+                                                       GOutputStream *stream,
+                                                       GCancellable *cancellable,
+                                                       GError **error);
+
 gchar *osinfo_install_script_generate_command_line(OsinfoInstallScript *script,
                                                    OsinfoOs *os,
                                                    OsinfoInstallConfig *config);
@@ -20,10 +20,23 @@
 
 #pragma once
 
+#include <libxml/tree.h>
 #include <osinfo/osinfo_install_script.h>
+#include <osinfo/osinfo_install_scriptlist.h>
 #include <osinfo/osinfo_avatar_format.h>
 
 void osinfo_install_script_add_config_param(OsinfoInstallScript *script, OsinfoInstallConfigParam *param);
 
 void osinfo_install_script_set_avatar_format(OsinfoInstallScript *script,
                                              OsinfoAvatarFormat *avatar);
+
+void osinfo_install_script_set_template_doc(OsinfoInstallScript *script,
+                                            xmlDocPtr doc);
+
+GHashTable *osinfo_install_script_index_new(void);
+void osinfo_install_script_index_add(GHashTable *index,
+                                     OsinfoInstallScriptList *scripts);
+OsinfoInstallScript *
+osinfo_install_script_index_lookup(GHashTable *index,
+                                   const gchar *profile,
+                                   OsinfoInstallScriptInjectionMethod method);
@@ -19,6 +19,7 @@
  */
 
 #include <osinfo/osinfo.h>
+#include "osinfo_list_private.h"
 #include <glib/gi18n-lib.h>
 
 /**
@@ -36,6 +37,11 @@ struct _OsinfoListPrivate
     GHashTable *entities;
 
     GType elementType;
+
+    /* Optional shortcut for osinfo_list_add_filtered() */
+    OsinfoListFilterFunc filterFunc;
+    gpointer filterData;
+    GDestroyNotify filterDataDestroy;
 };
 
 enum {
@@ -95,6 +101,7 @@ osinfo_list_finalize(GObject *object)
 {
     OsinfoList *list = OSINFO_LIST(object);
 
+    osinfo_list_set_filter_func(list, NULL, NULL, NULL);
     g_ptr_array_free(list->priv->array, TRUE);
     g_hash_table_unref(list->priv->entities);
 
@@ -246,6 +253,25 @@ OsinfoEntity *osinfo_list_find_by_id(OsinfoList *list, const gchar *id)
 }
 
 
+/*
+ * Sets a function able to answer osinfo_list_add_filtered() for @list
+ * without matching every entity, typically using an index of the
+ * entities. It is dropped as soon as @list is modified.
+ */
+void osinfo_list_set_filter_func(OsinfoList *list,
+                                 OsinfoListFilterFunc func,
+                                 gpointer data,
+                                 GDestroyNotify destroy)
+{
+    if (list->priv->filterDataDestroy)
+        list->priv->filterDataDestroy(list->priv->filterData);
+
+    list->priv->filterFunc = func;
+    list->priv->filterData = data;
+    list->priv->filterDataDestroy = destroy;
+}
+
+
 /**
  * osinfo_list_add:
  * @list: the entity list
@@ -260,6 +286,9 @@ void osinfo_list_add(OsinfoList *list, OsinfoEntity *entity)
     g_return_if_fail(OSINFO_IS_LIST(list));
     g_return_if_fail(G_TYPE_CHECK_INSTANCE_TYPE(entity, list->priv->elementType));
 
+    /* The filter function only knows about the original content */
+    osinfo_list_set_filter_func(list, NULL, NULL, NULL);
+
     g_object_ref(entity);
     preexisting = osinfo_list_find_by_id(list, osinfo_entity_get_id(entity));
     if (preexisting != NULL) {
@@ -288,6 +317,12 @@ void osinfo_list_add_filtered(OsinfoList *list, OsinfoList *source, OsinfoFilter
     g_return_if_fail(OSINFO_IS_LIST(list));
     g_return_if_fail(osinfo_list_get_element_type(list) == osinfo_list_get_element_type(source));
 
+    if (source->priv->filterFunc &&
+        source->priv->filterFunc(list, source, filter, source->priv->filterData))
+        return;
+
+    osinfo_filter_compile(filter);
+
     len = osinfo_list_get_length(source);
     for (i = 0; i < len; i++) {
         OsinfoEntity *entity = osinfo_list_get_nth(source, i);
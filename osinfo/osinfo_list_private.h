@@ -0,0 +1,38 @@
+/*
+ * libosinfo: a list of entities
+ *
+ * Copyright (C) 2009-2020 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <osinfo/osinfo_list.h>
+
+/*
+ * Adds the entities of @source matched by @filter to @list, the same way
+ * osinfo_list_add_filtered() would. Returns FALSE if it cannot answer, in
+ * which case every entity of @source is matched against @filter instead.
+ */
+typedef gboolean (*OsinfoListFilterFunc)(OsinfoList *list,
+                                         OsinfoList *source,
+                                         OsinfoFilter *filter,
+                                         gpointer data);
+
+void osinfo_list_set_filter_func(OsinfoList *list,
+                                 OsinfoListFilterFunc func,
+                                 gpointer data,
+                                 GDestroyNotify destroy);
@@ -319,7 +319,7 @@ cleanup:
     return ret;
 }
 
-static gchar *
+static xmlDocPtr
 osinfo_loader_doc(const char *xpath,
                   OsinfoLoader *loader,
                   xmlXPathContextPtr ctxt,
@@ -327,8 +327,8 @@ osinfo_loader_doc(const char *xpath,
 {
     xmlXPathObjectPtr obj;
     xmlNodePtr relnode;
-    gchar *ret;
-    xmlBufferPtr buf;
+    xmlNodePtr node;
+    xmlDocPtr ret;
     xmlXPathCompExprPtr comp;
 
     g_return_val_if_fail(ctxt != NULL, NULL);
@@ -340,23 +340,27 @@ osinfo_loader_doc(const char *xpath,
     relnode = ctxt->node;
     obj = xmlXPathCompiledEval(comp, ctxt);
     ctxt->node = relnode;
-    if ((obj == NULL) || (obj->type != XPATH_NODESET)) {
+    if ((obj == NULL) || (obj->type != XPATH_NODESET) ||
+        (obj->nodesetval == NULL) || (obj->nodesetval->nodeNr <= 0)) {
         xmlXPathFreeObject(obj);
         return NULL;
     }
 
-    if (!(buf = xmlBufferCreate())) {
+    /* Copy the subtree straight into a document of its own, rather than
+     * formatting it for it to be parsed back later on */
+    if (!(ret = xmlNewDoc(BAD_CAST "1.0"))) {
         xmlXPathFreeObject(obj);
-        OSINFO_LOADER_SET_ERROR(err, "Cannot allocate buffer");
+        OSINFO_LOADER_SET_ERROR(err, "Cannot allocate document");
         return NULL;
     }
-    if (xmlNodeDump(buf, NULL, obj->nodesetval->nodeTab[0], 0, 1) < 0) {
+    if (!(node = xmlDocCopyNode(obj->nodesetval->nodeTab[0], ret, 1))) {
+        xmlFreeDoc(ret);
         xmlXPathFreeObject(obj);
-        OSINFO_LOADER_SET_ERROR(err, "Cannot format stylesheet");
+        OSINFO_LOADER_SET_ERROR(err, "Cannot copy stylesheet");
+        return NULL;
     }
-    ret = g_strdup((char *)xmlBufferContent(buf));
+    xmlDocSetRootElement(ret, node);
 
-    xmlBufferFree(buf);
     xmlXPathFreeObject(obj);
     return ret;
 }
@@ -1004,6 +1008,7 @@ static void osinfo_loader_install_script(OsinfoLoader *loader,
         { NULL, G_TYPE_INVALID }
     };
     gchar *value = NULL;
+    xmlDocPtr template = NULL;
     xmlNodePtr *nodes = NULL;
     int i, nnodes;
     unsigned int injection_methods = 0;
@@ -1027,14 +1032,11 @@ static void osinfo_loader_install_script(OsinfoLoader *loader,
     if (error_is_set(err))
         goto error;
 
-    value = osinfo_loader_doc("./template/*[1]", loader, ctxt, err);
+    template = osinfo_loader_doc("./template/*[1]", loader, ctxt, err);
     if (error_is_set(err))
         goto error;
-    if (value)
-        osinfo_entity_set_param(OSINFO_ENTITY(installScript),
-                                OSINFO_INSTALL_SCRIPT_PROP_TEMPLATE_DATA,
-                                value);
-    g_free(value);
+    if (template)
+        osinfo_install_script_set_template_doc(installScript, template);
 
     value = osinfo_loader_string("./template/@uri", loader, ctxt, err);
     if (error_is_set(err))
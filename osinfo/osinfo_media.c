@@ -26,6 +26,9 @@
 #include <glib/gi18n-lib.h>
 #include <libsoup/soup.h>
 #include "osinfo_util_private.h"
+#include "osinfo_entity_private.h"
+#include "osinfo_install_script_private.h"
+#include "osinfo_os_private.h"
 
 #define MAX_VOLUME 32
 #define MAX_SYSTEM 32
@@ -203,6 +206,9 @@ struct _OsinfoMediaPrivate
 {
     GWeakRef os;
     OsinfoInstallScriptList *scripts;
+    /* Install scripts by profile and injection method */
+    GHashTable *scriptsIndex;
+    guint scriptsGeneration;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE(OsinfoMedia, osinfo_media, OSINFO_TYPE_ENTITY);
@@ -231,6 +237,9 @@ enum {
 };
 static GParamSpec *properties[LAST_PROP];
 
+/* Protects the install script indexes of all media */
+static GMutex osinfo_media_scripts_lock;
+
 static void
 osinfo_media_get_property(GObject    *object,
                                guint       property_id,
@@ -439,6 +448,7 @@ osinfo_media_finalize(GObject *object)
     OsinfoMedia *media = OSINFO_MEDIA(object);
 
     g_object_unref(media->priv->scripts);
+    g_clear_pointer(&media->priv->scriptsIndex, g_hash_table_unref);
 
     /* Chain up to the parent class */
     G_OBJECT_CLASS(osinfo_media_parent_class)->finalize(object);
@@ -1788,28 +1798,20 @@ gboolean osinfo_media_get_eject_after_install(OsinfoMedia *media)
 gboolean osinfo_media_supports_installer_script(OsinfoMedia *media)
 {
     OsinfoOs *os;
-    OsinfoInstallScriptList *list;
-    gboolean ret;
+    gboolean has_scripts;
 
     g_return_val_if_fail(OSINFO_IS_MEDIA(media), FALSE);
 
     os = osinfo_media_get_os(media);
-    list = osinfo_os_get_install_script_list(os);
+    has_scripts = osinfo_list_get_length(OSINFO_LIST(media->priv->scripts)) > 0 ||
+        (os != NULL && osinfo_os_has_install_scripts(os));
+    g_clear_object(&os);
 
-    if (osinfo_list_get_length(OSINFO_LIST(list)) == 0 &&
-        osinfo_list_get_length(OSINFO_LIST(media->priv->scripts)) == 0) {
-        ret = FALSE;
-        goto cleanup;
-    }
+    if (!has_scripts)
+        return FALSE;
 
-    ret = osinfo_entity_get_param_value_boolean_with_default
+    return osinfo_entity_get_param_value_boolean_with_default
             (OSINFO_ENTITY(media), OSINFO_MEDIA_PROP_INSTALLER_SCRIPT, TRUE);
-
- cleanup:
-    g_object_unref(list);
-    g_object_unref(os);
-
-    return ret;
 }
 
 /**
@@ -1826,6 +1828,8 @@ void osinfo_media_add_install_script(OsinfoMedia *media, OsinfoInstallScript *sc
     g_return_if_fail(OSINFO_IS_MEDIA(media));
 
     osinfo_list_add(OSINFO_LIST(media->priv->scripts), OSINFO_ENTITY(script));
+    osinfo_entity_join(OSINFO_ENTITY(media), OSINFO_ENTITY(script));
+    osinfo_entity_changed(OSINFO_ENTITY(media));
 }
 
 /**
@@ -1846,6 +1850,62 @@ OsinfoInstallScriptList *osinfo_media_get_install_script_list(OsinfoMedia *media
     return OSINFO_INSTALL_SCRIPTLIST(new_list);
 }
 
+/**
+ * osinfo_media_find_install_script:
+ * @media:   an #OsinfoMedia instance
+ * @profile: the install script profile
+ * @method:  the #OsinfoInstallScriptInjectionMethod flags the script must all
+ * support, or 0 to accept any method
+ *
+ * Finds an install script for @profile supporting @method. Only the scripts
+ * of @media are considered if it has any, otherwise the lookup falls back to
+ * osinfo_os_find_install_script_by_injection_method() on the operating
+ * system of @media.
+ *
+ * Returns: (transfer none): the install script, or NULL if none is found
+ *
+ * Since: 1.13.0
+ */
+OsinfoInstallScript *osinfo_media_find_install_script(OsinfoMedia *media,
+                                                      const gchar *profile,
+                                                      OsinfoInstallScriptInjectionMethod method)
+{
+    OsinfoInstallScript *script;
+    OsinfoOs *os;
+
+    g_return_val_if_fail(OSINFO_IS_MEDIA(media), NULL);
+    g_return_val_if_fail(profile != NULL, NULL);
+
+    if (osinfo_list_get_length(OSINFO_LIST(media->priv->scripts)) > 0) {
+        guint generation = osinfo_entity_get_generation(OSINFO_ENTITY(media));
+
+        g_mutex_lock(&osinfo_media_scripts_lock);
+        if (media->priv->scriptsIndex == NULL ||
+            media->priv->scriptsGeneration != generation) {
+            g_clear_pointer(&media->priv->scriptsIndex, g_hash_table_unref);
+            media->priv->scriptsIndex = osinfo_install_script_index_new();
+            media->priv->scriptsGeneration = generation;
+            osinfo_install_script_index_add(media->priv->scriptsIndex,
+                                            media->priv->scripts);
+        }
+        script = osinfo_install_script_index_lookup(media->priv->scriptsIndex,
+                                                    profile, method);
+        g_mutex_unlock(&osinfo_media_scripts_lock);
+
+        return script;
+    }
+
+    os = osinfo_media_get_os(media);
+    if (os == NULL)
+        return NULL;
+
+    /* The OS keeps its scripts alive after our reference is dropped */
+    script = osinfo_os_find_install_script_by_injection_method(os, profile, method);
+    g_object_unref(os);
+
+    return script;
+}
+
 /**
  * osinfo_media_is_bootable:
  * @media: and #OsinfoMedia instance
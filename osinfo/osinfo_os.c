@@ -21,7 +21,10 @@
 #include <osinfo/osinfo.h>
 #include "osinfo_media_private.h"
 #include "osinfo/osinfo_product_private.h"
+#include "osinfo_entity_private.h"
 #include "osinfo/osinfo_resources_private.h"
+#include "osinfo_install_script_private.h"
+#include "osinfo_os_private.h"
 #include <glib/gi18n-lib.h>
 
 /**
@@ -36,6 +39,14 @@
  * and which are derived from a common ancestry.
  */
 
+enum {
+    OSINFO_OS_RESOURCES_MINIMUM,
+    OSINFO_OS_RESOURCES_RECOMMENDED,
+    OSINFO_OS_RESOURCES_MAXIMUM,
+    OSINFO_OS_RESOURCES_NETWORK_INSTALL,
+    OSINFO_OS_RESOURCES_LAST
+};
+
 struct _OsinfoOsPrivate
 {
     // Value: List of device_link structs
@@ -51,9 +62,35 @@ struct _OsinfoOsPrivate
     OsinfoResourcesList *recommended;
     OsinfoResourcesList *maximum;
 
+    /* Generation of the OS the inherited values of each list of resources
+     * were last resolved at */
+    gboolean resourcesResolved[OSINFO_OS_RESOURCES_LAST];
+    guint resourcesGeneration[OSINFO_OS_RESOURCES_LAST];
+
+    /* Device links of the OS and its ancestors, see
+     * osinfo_os_get_all_device_links_flattened() */
+    GPtrArray *allDeviceLinks;
+    guint allDeviceLinksGeneration;
+
+    /* "arch\ntype" -> whether the firmware is supported, with inheritance */
+    GHashTable *firmwareSupport;
+    guint firmwareSupportGeneration;
+
     OsinfoInstallScriptList *scripts;
+    /* Install scripts by profile and injection method, of the OS alone and
+     * including the OSes it derives from or clones, see
+     * osinfo_os_ensure_install_scripts() */
+    GHashTable *ownScripts;
+    GHashTable *allScripts;
+    guint scriptsGeneration;
 
     OsinfoDeviceDriverList *device_drivers;
+    /* Highest priority device drivers and "arch\npre-installable\ndevice-id"
+     * -> best device driver, see osinfo_os_ensure_device_drivers() */
+    GPtrArray *prioritizedDrivers;
+    GHashTable *driversByDevice;
+    guint driversGeneration;
+    gint driversLength;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE(OsinfoOs, osinfo_os, OSINFO_TYPE_PRODUCT);
@@ -74,6 +111,17 @@ enum {
 };
 static GParamSpec *properties[LAST_PROP];
 
+/* Protects the resolution of inherited resources of all OSes */
+static GMutex osinfo_os_resources_lock;
+/* Protects the flattened device links of all OSes */
+static GMutex osinfo_os_devices_lock;
+/* Protects the firmware support of all OSes */
+static GMutex osinfo_os_firmwares_lock;
+/* Protects the device driver indexes of all OSes */
+static GMutex osinfo_os_drivers_lock;
+/* Protects the install script indexes of all OSes */
+static GMutex osinfo_os_scripts_lock;
+
 static void osinfo_os_finalize(GObject *object);
 
 static void
@@ -119,6 +167,8 @@ osinfo_os_finalize(GObject *object)
     OsinfoOs *os = OSINFO_OS(object);
 
     g_list_free_full(os->priv->deviceLinks, g_object_unref);
+    g_clear_pointer(&os->priv->allDeviceLinks, g_ptr_array_unref);
+    g_clear_pointer(&os->priv->firmwareSupport, g_hash_table_unref);
     g_object_unref(os->priv->firmwares);
     g_object_unref(os->priv->medias);
     g_object_unref(os->priv->trees);
@@ -130,8 +180,12 @@ osinfo_os_finalize(GObject *object)
     g_object_unref(os->priv->maximum);
 
     g_object_unref(os->priv->scripts);
+    g_clear_pointer(&os->priv->ownScripts, g_hash_table_unref);
+    g_clear_pointer(&os->priv->allScripts, g_hash_table_unref);
 
     g_object_unref(os->priv->device_drivers);
+    g_clear_pointer(&os->priv->prioritizedDrivers, g_ptr_array_unref);
+    g_clear_pointer(&os->priv->driversByDevice, g_hash_table_unref);
 
     /* Chain up to the parent class */
     G_OBJECT_CLASS(osinfo_os_parent_class)->finalize(object);
@@ -304,34 +358,72 @@ OsinfoDeviceList *osinfo_os_get_devices(OsinfoOs *os, OsinfoFilter *filter)
     return osinfo_os_get_devices_internal(os, filter, FALSE);
 }
 
-struct GetAllDevicesData {
-    OsinfoFilter *filter;
-    OsinfoDeviceList *devices;
-};
-
-static void get_all_devices_cb(OsinfoProduct *product, gpointer user_data)
+static void get_all_device_links_cb(OsinfoProduct *product, gpointer user_data)
 {
-    OsinfoDeviceList *devices;
-    OsinfoList *tmp_list;
-    struct GetAllDevicesData *foreach_data = (struct GetAllDevicesData *)user_data;
+    GPtrArray *device_links = user_data;
+    GHashTable *last_links;
+    GList *tmp;
 
     g_return_if_fail(OSINFO_IS_OS(product));
 
-    devices = osinfo_os_get_devices_internal(OSINFO_OS(product),
-                                             foreach_data->filter,
-                                             TRUE);
-    tmp_list = osinfo_list_new_union(OSINFO_LIST(foreach_data->devices),
-                                     OSINFO_LIST(devices));
-    g_object_unref(foreach_data->devices);
-    g_object_unref(devices);
-    foreach_data->devices = OSINFO_DEVICELIST(tmp_list);
+    /* As with osinfo_list_add(), the last link to a device takes
+     * precedence over the earlier ones */
+    last_links = g_hash_table_new(g_str_hash, g_str_equal);
+    for (tmp = OSINFO_OS(product)->priv->deviceLinks; tmp; tmp = tmp->next)
+        g_hash_table_insert(last_links,
+                            (gpointer)osinfo_entity_get_id(OSINFO_ENTITY(tmp->data)),
+                            tmp->data);
+
+    for (tmp = OSINFO_OS(product)->priv->deviceLinks; tmp; tmp = tmp->next) {
+        if (g_hash_table_lookup(last_links,
+                                osinfo_entity_get_id(OSINFO_ENTITY(tmp->data))) == tmp->data)
+            g_ptr_array_add(device_links, tmp->data);
+    }
+
+    g_hash_table_unref(last_links);
 }
 
+/*
+ * Returns the device links of @os and of the operating systems it derives
+ * from or clones, in that order, which the lookups of inherited devices
+ * work from. Each operating system's links are deduplicated, but not the
+ * whole array. The array is kept until any entity changes, and holds no
+ * references since device links are never removed from an OS.
+ */
+static GPtrArray *osinfo_os_get_all_device_links_flattened(OsinfoOs *os)
+{
+    guint generation = osinfo_entity_get_generation(OSINFO_ENTITY(os));
+    GPtrArray *device_links;
+
+    g_mutex_lock(&osinfo_os_devices_lock);
+
+    if (os->priv->allDeviceLinks == NULL ||
+        os->priv->allDeviceLinksGeneration != generation) {
+        g_clear_pointer(&os->priv->allDeviceLinks, g_ptr_array_unref);
+
+        os->priv->allDeviceLinks = g_ptr_array_new();
+        os->priv->allDeviceLinksGeneration = generation;
+        osinfo_product_foreach_related(OSINFO_PRODUCT(os),
+                                       OSINFO_PRODUCT_FOREACH_FLAG_DERIVES_FROM |
+                                       OSINFO_PRODUCT_FOREACH_FLAG_CLONES,
+                                       get_all_device_links_cb,
+                                       os->priv->allDeviceLinks);
+    }
 
-static OsinfoDeviceLinkList *
-osinfo_os_get_all_device_links_internal(OsinfoOs *os,
-                                        OsinfoFilter *filter,
-                                        gboolean include_unsupported);
+    device_links = g_ptr_array_ref(os->priv->allDeviceLinks);
+
+    g_mutex_unlock(&osinfo_os_devices_lock);
+
+    return device_links;
+}
+
+static gboolean
+osinfo_os_device_link_is_supported(OsinfoDeviceLink *devlink)
+{
+    return osinfo_entity_get_param_value_boolean_with_default(OSINFO_ENTITY(devlink),
+                                                              OSINFO_DEVICELINK_PROP_SUPPORTED,
+                                                              TRUE);
+}
 
 
 /**
@@ -349,55 +441,76 @@ osinfo_os_get_all_device_links_internal(OsinfoOs *os,
  */
 OsinfoDeviceList *osinfo_os_get_all_devices(OsinfoOs *os, OsinfoFilter *filter)
 {
-    struct GetAllDevicesData foreach_data = {
-        .filter = filter,
-        .devices = osinfo_devicelist_new()
-    };
-    OsinfoDeviceLinkList *devlinks;
-    OsinfoDeviceLinkList *unsupported_devlinks;
-    OsinfoDeviceList *unsupported_devs;
-    OsinfoDeviceList *new_list;
-    OsinfoFilter *unsupported_filter;
-    GList *list, *unsupported_list;
-    GList *it;
+    return osinfo_os_get_all_devices_internal(os, filter, NULL);
+}
 
-    osinfo_product_foreach_related(OSINFO_PRODUCT(os),
-                                   OSINFO_PRODUCT_FOREACH_FLAG_DERIVES_FROM |
-                                   OSINFO_PRODUCT_FOREACH_FLAG_CLONES,
-                                   get_all_devices_cb,
-                                   &foreach_data);
 
-    devlinks = osinfo_os_get_all_device_links_internal(os, filter, TRUE);
+/*
+ * Like osinfo_os_get_all_devices(), additionally appending the devices
+ * which @os explicitly marks as unsupported to @unsupported, if not NULL.
+ */
+OsinfoDeviceList *osinfo_os_get_all_devices_internal(OsinfoOs *os,
+                                                     OsinfoFilter *filter,
+                                                     OsinfoDeviceList *unsupported)
+{
+    OsinfoDeviceList *new_list;
+    GPtrArray *device_links;
+    GPtrArray *devices;
+    GHashTable *seen_devices;
+    GHashTable *seen_links;
+    GHashTable *unsupported_devs;
+    guint i;
+
+    g_return_val_if_fail(OSINFO_IS_OS(os), NULL);
+    g_return_val_if_fail(!filter || OSINFO_IS_FILTER(filter), NULL);
 
-    unsupported_filter = osinfo_filter_new();
-    osinfo_filter_add_constraint(unsupported_filter,
-                                 OSINFO_DEVICELINK_PROP_SUPPORTED,
-                                 "false");
+    device_links = osinfo_os_get_all_device_links_flattened(os);
 
-    unsupported_devlinks = OSINFO_DEVICELINKLIST
-        (osinfo_list_new_filtered(OSINFO_LIST(devlinks), unsupported_filter));
+    devices = g_ptr_array_new();
+    seen_devices = g_hash_table_new(g_str_hash, g_str_equal);
+    seen_links = g_hash_table_new(g_str_hash, g_str_equal);
+    unsupported_devs = g_hash_table_new(g_direct_hash, g_direct_equal);
 
-    unsupported_devs = osinfo_devicelinklist_get_devices(unsupported_devlinks, NULL);
+    for (i = 0; i < device_links->len; i++) {
+        OsinfoDeviceLink *devlink = device_links->pdata[i];
+        OsinfoDevice *dev = osinfo_devicelink_get_target(devlink);
+        const gchar *dev_id = osinfo_entity_get_id(OSINFO_ENTITY(dev));
+        const gchar *devlink_id = osinfo_entity_get_id(OSINFO_ENTITY(devlink));
+
+        /* The first operating system listing a device provides it... */
+        if ((!filter || osinfo_filter_matches(filter, OSINFO_ENTITY(dev))) &&
+            !g_hash_table_contains(seen_devices, dev_id)) {
+            g_hash_table_add(seen_devices, (gpointer)dev_id);
+            g_ptr_array_add(devices, dev);
+        }
 
-    list = osinfo_list_get_elements(OSINFO_LIST(foreach_data.devices));
-    unsupported_list = osinfo_list_get_elements(OSINFO_LIST(unsupported_devs));
+        /* ...and the first link to it matching the filter decides
+         * whether it is supported */
+        if ((!filter || osinfo_filter_matches(filter, OSINFO_ENTITY(devlink))) &&
+            !g_hash_table_contains(seen_links, devlink_id)) {
+            g_hash_table_add(seen_links, (gpointer)devlink_id);
+            if (!osinfo_os_device_link_is_supported(devlink))
+                g_hash_table_add(unsupported_devs, dev);
+        }
+    }
 
     new_list = osinfo_devicelist_new();
-    for (it = list; it != NULL; it = it->next) {
-        OsinfoDevice *dev = OSINFO_DEVICE(it->data);
-        if (g_list_find(unsupported_list, dev))
+    for (i = 0; i < devices->len; i++) {
+        if (g_hash_table_contains(unsupported_devs, devices->pdata[i])) {
+            if (unsupported)
+                osinfo_list_add(OSINFO_LIST(unsupported),
+                                OSINFO_ENTITY(devices->pdata[i]));
             continue;
+        }
 
-        osinfo_list_add(OSINFO_LIST(new_list), OSINFO_ENTITY(dev));
+        osinfo_list_add(OSINFO_LIST(new_list), OSINFO_ENTITY(devices->pdata[i]));
     }
 
-    g_list_free(list);
-    g_list_free(unsupported_list);
-    g_object_unref(devlinks);
-    g_object_unref(unsupported_devlinks);
-    g_object_unref(unsupported_devs);
-    g_object_unref(unsupported_filter);
-    g_object_unref(foreach_data.devices);
+    g_hash_table_unref(unsupported_devs);
+    g_hash_table_unref(seen_links);
+    g_hash_table_unref(seen_devices);
+    g_ptr_array_unref(devices);
+    g_ptr_array_unref(device_links);
 
     return new_list;
 }
@@ -484,71 +597,6 @@ OsinfoDeviceLinkList *osinfo_os_get_device_links(OsinfoOs *os, OsinfoFilter *fil
 }
 
 
-struct GetAllDeviceLinksData {
-    OsinfoFilter *filter;
-    OsinfoDeviceLinkList *device_links;
-};
-
-static void get_all_device_links_cb(OsinfoProduct *product, gpointer user_data)
-{
-    OsinfoDeviceLinkList *device_links;
-    OsinfoList *tmp_list;
-    struct GetAllDeviceLinksData *foreach_data;
-
-    g_return_if_fail(OSINFO_IS_OS(product));
-
-    foreach_data = (struct GetAllDeviceLinksData *)user_data;
-    device_links = osinfo_os_get_device_links_internal(OSINFO_OS(product),
-                                                       foreach_data->filter,
-                                                       TRUE);
-    tmp_list = osinfo_list_new_union(OSINFO_LIST(foreach_data->device_links),
-                                     OSINFO_LIST(device_links));
-    g_object_unref(foreach_data->device_links);
-    g_object_unref(device_links);
-    foreach_data->device_links = OSINFO_DEVICELINKLIST(tmp_list);
-}
-
-static OsinfoDeviceLinkList *
-osinfo_os_get_all_device_links_internal(OsinfoOs *os,
-                                        OsinfoFilter *filter,
-                                        gboolean include_unsupported)
-{
-    struct GetAllDeviceLinksData foreach_data = {
-        .filter = filter,
-        .device_links = osinfo_devicelinklist_new()
-    };
-    OsinfoDeviceLinkList *devlinks;
-    GList *list, *it;
-
-    osinfo_product_foreach_related(OSINFO_PRODUCT(os),
-                                   OSINFO_PRODUCT_FOREACH_FLAG_DERIVES_FROM |
-                                   OSINFO_PRODUCT_FOREACH_FLAG_CLONES,
-                                   get_all_device_links_cb,
-                                   &foreach_data);
-
-    if (include_unsupported)
-        return foreach_data.device_links;
-
-    devlinks = osinfo_devicelinklist_new();
-
-    list = osinfo_list_get_elements(OSINFO_LIST(foreach_data.device_links));
-    for (it = list; it != NULL; it = it->next) {
-        OsinfoDeviceLink *devlink = OSINFO_DEVICELINK(it->data);
-
-        if (!osinfo_entity_get_param_value_boolean_with_default(OSINFO_ENTITY(devlink),
-                                                                OSINFO_DEVICELINK_PROP_SUPPORTED,
-                                                                TRUE))
-            continue;
-
-        osinfo_list_add(OSINFO_LIST(devlinks), OSINFO_ENTITY(devlink));
-    }
-
-    g_object_unref(foreach_data.device_links);
-    g_list_free(list);
-
-    return devlinks;
-}
-
 /**
  * osinfo_os_get_all_device_links:
  * @os: an operating system
@@ -564,7 +612,41 @@ osinfo_os_get_all_device_links_internal(OsinfoOs *os,
  */
 OsinfoDeviceLinkList *osinfo_os_get_all_device_links(OsinfoOs *os, OsinfoFilter *filter)
 {
-    return osinfo_os_get_all_device_links_internal(os, filter, FALSE);
+    OsinfoDeviceLinkList *devlinks;
+    GPtrArray *device_links;
+    GHashTable *seen_links;
+    guint i;
+
+    g_return_val_if_fail(OSINFO_IS_OS(os), NULL);
+    g_return_val_if_fail(!filter || OSINFO_IS_FILTER(filter), NULL);
+
+    device_links = osinfo_os_get_all_device_links_flattened(os);
+
+    devlinks = osinfo_devicelinklist_new();
+    seen_links = g_hash_table_new(g_str_hash, g_str_equal);
+
+    for (i = 0; i < device_links->len; i++) {
+        OsinfoDeviceLink *devlink = device_links->pdata[i];
+        const gchar *devlink_id = osinfo_entity_get_id(OSINFO_ENTITY(devlink));
+
+        if (filter && !osinfo_filter_matches(filter, OSINFO_ENTITY(devlink)))
+            continue;
+
+        /* The first operating system linking a device takes precedence */
+        if (g_hash_table_contains(seen_links, devlink_id))
+            continue;
+        g_hash_table_add(seen_links, (gpointer)devlink_id);
+
+        if (!osinfo_os_device_link_is_supported(devlink))
+            continue;
+
+        osinfo_list_add(OSINFO_LIST(devlinks), OSINFO_ENTITY(devlink));
+    }
+
+    g_hash_table_unref(seen_links);
+    g_ptr_array_unref(device_links);
+
+    return devlinks;
 }
 
 /**
@@ -587,6 +669,9 @@ OsinfoDeviceLink *osinfo_os_add_device(OsinfoOs *os, OsinfoDevice *dev)
 
     devlink = osinfo_devicelink_new(dev);
     os->priv->deviceLinks = g_list_append(os->priv->deviceLinks, devlink);
+    osinfo_entity_join(OSINFO_ENTITY(os), OSINFO_ENTITY(devlink));
+    osinfo_entity_join(OSINFO_ENTITY(os), OSINFO_ENTITY(dev));
+    osinfo_entity_changed(OSINFO_ENTITY(os));
 
     return devlink;
 }
@@ -804,10 +889,26 @@ struct GetAllResourcesData {
     OsinfoResourcesList *(*get_resourceslist)(OsinfoOs *);
 };
 
+/*
+ * Fills in an inherited value. This records no change, as other OSes
+ * inheriting from the resources would inherit the same value from the
+ * ancestor anyway, so that resolving an OS invalidates no cached data.
+ */
+static void inherit_resources_value(OsinfoResources *resources,
+                                    const gchar *key,
+                                    gint64 value)
+{
+    gchar *str = g_strdup_printf("%"G_GINT64_FORMAT, value);
+
+    osinfo_entity_fill_param(OSINFO_ENTITY(resources), key, str);
+    g_free(str);
+}
+
 static void get_all_resources_cb(OsinfoProduct *product, gpointer user_data)
 {
     OsinfoResourcesList *resourceslist;
     struct GetAllResourcesData *foreach_data = (struct GetAllResourcesData *)user_data;
+    GHashTable *resources_by_arch;
     gint original_resourceslist_len;
     gint resourceslist_len;
     gint i;
@@ -822,64 +923,73 @@ static void get_all_resources_cb(OsinfoProduct *product, gpointer user_data)
     resourceslist = foreach_data->get_resourceslist(OSINFO_OS(product));
     resourceslist_len = osinfo_list_get_length(OSINFO_LIST(resourceslist));
 
+    /* The last resources listed for an architecture take precedence */
+    resources_by_arch = g_hash_table_new(g_str_hash, g_str_equal);
+    for (i = 0; i < resourceslist_len; i++) {
+        OsinfoResources *resources;
+
+        resources = OSINFO_RESOURCES(osinfo_list_get_nth(OSINFO_LIST(resourceslist), i));
+        g_hash_table_insert(resources_by_arch,
+                            (gpointer)osinfo_resources_get_architecture(resources),
+                            resources);
+    }
+
     for (i = 0; i < original_resourceslist_len; i++) {
         OsinfoResources *original_resources;
-        const gchar *original_arch;
-        gint original_n_cpus;
-        gint64 original_cpu;
-        gint64 original_ram;
-        gint64 original_storage;
-        gint j;
+        OsinfoResources *resources;
+        gint n_cpus;
+        gint64 cpu;
+        gint64 ram;
+        gint64 storage;
 
         original_resources = OSINFO_RESOURCES(osinfo_list_get_nth(OSINFO_LIST(foreach_data->resourceslist), i));
 
         if (!osinfo_resources_get_inherit(original_resources))
             continue;
 
-        original_arch = osinfo_resources_get_architecture(original_resources);
-        original_n_cpus = osinfo_resources_get_n_cpus(original_resources);
-        original_cpu = osinfo_resources_get_cpu(original_resources);
-        original_ram = osinfo_resources_get_ram(original_resources);
-        original_storage = osinfo_resources_get_storage(original_resources);
-
-        for (j = 0; j < resourceslist_len; j++) {
-            OsinfoResources *resources;
-            const gchar *arch;
-            gint n_cpus;
-            gint64 cpu;
-            gint64 ram;
-            gint64 storage;
-
-            resources = OSINFO_RESOURCES(osinfo_list_get_nth(OSINFO_LIST(resourceslist), j));
-            arch = osinfo_resources_get_architecture(resources);
-            n_cpus = osinfo_resources_get_n_cpus(resources);
-            cpu = osinfo_resources_get_cpu(resources);
-            ram = osinfo_resources_get_ram(resources);
-            storage = osinfo_resources_get_storage(resources);
-
-            if (!g_str_equal(original_arch, arch))
-                continue;
+        resources = g_hash_table_lookup(resources_by_arch,
+                                        osinfo_resources_get_architecture(original_resources));
+        if (resources == NULL)
+            continue;
 
-            if (original_n_cpus == -1)
-                osinfo_resources_set_n_cpus(original_resources, n_cpus);
+        n_cpus = osinfo_resources_get_n_cpus(resources);
+        cpu = osinfo_resources_get_cpu(resources);
+        ram = osinfo_resources_get_ram(resources);
+        storage = osinfo_resources_get_storage(resources);
 
-            if (original_cpu == -1)
-                osinfo_resources_set_cpu(original_resources, cpu);
+        /* Unset values are not copied, so resolving the inherited values
+         * again leaves the resources unchanged */
+        if (osinfo_resources_get_n_cpus(original_resources) == -1 && n_cpus != -1)
+            inherit_resources_value(original_resources,
+                                    OSINFO_RESOURCES_PROP_N_CPUS, n_cpus);
 
-            if (original_ram == -1)
-                osinfo_resources_set_ram(original_resources, ram);
+        if (osinfo_resources_get_cpu(original_resources) == -1 && cpu != -1)
+            inherit_resources_value(original_resources,
+                                    OSINFO_RESOURCES_PROP_CPU, cpu);
 
-            if (original_storage == -1)
-                osinfo_resources_set_storage(original_resources, storage);
-        }
+        if (osinfo_resources_get_ram(original_resources) == -1 && ram != -1)
+            inherit_resources_value(original_resources,
+                                    OSINFO_RESOURCES_PROP_RAM, ram);
+
+        if (osinfo_resources_get_storage(original_resources) == -1 && storage != -1)
+            inherit_resources_value(original_resources,
+                                    OSINFO_RESOURCES_PROP_STORAGE, storage);
     }
 
+    g_hash_table_unref(resources_by_arch);
     g_object_unref(resourceslist);
 }
 
 
+/*
+ * The inherited values are resolved by filling in the unset values of the
+ * resources of @os from its ancestors. This is only done again once an
+ * entity joined with @os changed, which covers new resources and new
+ * relationships, but not the resolution of other OSes.
+ */
 static OsinfoResourcesList *
 osinfo_os_get_resources_internal(OsinfoOs *os,
+                                 guint kind,
                                  OsinfoResourcesList *(*get_resourceslist)(OsinfoOs *))
 {
     struct GetAllResourcesData foreach_data = {
@@ -887,12 +997,23 @@ osinfo_os_get_resources_internal(OsinfoOs *os,
         .resourceslist = get_resourceslist(os),
         .get_resourceslist = get_resourceslist
     };
+    guint generation = osinfo_entity_get_generation(OSINFO_ENTITY(os));
 
-    osinfo_product_foreach_related(OSINFO_PRODUCT(os),
-                                   OSINFO_PRODUCT_FOREACH_FLAG_DERIVES_FROM |
-                                   OSINFO_PRODUCT_FOREACH_FLAG_CLONES,
-                                   get_all_resources_cb,
-                                   &foreach_data);
+    g_mutex_lock(&osinfo_os_resources_lock);
+
+    if (!os->priv->resourcesResolved[kind] ||
+        os->priv->resourcesGeneration[kind] != generation) {
+        osinfo_product_foreach_related(OSINFO_PRODUCT(os),
+                                       OSINFO_PRODUCT_FOREACH_FLAG_DERIVES_FROM |
+                                       OSINFO_PRODUCT_FOREACH_FLAG_CLONES,
+                                       get_all_resources_cb,
+                                       &foreach_data);
+
+        os->priv->resourcesResolved[kind] = TRUE;
+        os->priv->resourcesGeneration[kind] = generation;
+    }
+
+    g_mutex_unlock(&osinfo_os_resources_lock);
 
     return foreach_data.resourceslist;
 }
@@ -932,7 +1053,8 @@ osinfo_os_get_minimum_resources_without_inheritance(OsinfoOs *os)
 OsinfoResourcesList *osinfo_os_get_minimum_resources(OsinfoOs *os)
 {
     return osinfo_os_get_resources_internal
-            (os, osinfo_os_get_minimum_resources_without_inheritance);
+            (os, OSINFO_OS_RESOURCES_MINIMUM,
+             osinfo_os_get_minimum_resources_without_inheritance);
 }
 
 /**
@@ -973,7 +1095,8 @@ osinfo_os_get_maximum_resources_without_inheritance(OsinfoOs *os)
 OsinfoResourcesList *osinfo_os_get_maximum_resources(OsinfoOs *os)
 {
     return osinfo_os_get_resources_internal
-            (os, osinfo_os_get_maximum_resources_without_inheritance);
+            (os, OSINFO_OS_RESOURCES_MAXIMUM,
+             osinfo_os_get_maximum_resources_without_inheritance);
 }
 
 /**
@@ -1012,7 +1135,8 @@ osinfo_os_get_recommended_resources_without_inheritance(OsinfoOs *os)
 OsinfoResourcesList *osinfo_os_get_recommended_resources(OsinfoOs *os)
 {
     return osinfo_os_get_resources_internal
-            (os, osinfo_os_get_recommended_resources_without_inheritance);
+            (os, OSINFO_OS_RESOURCES_RECOMMENDED,
+             osinfo_os_get_recommended_resources_without_inheritance);
 }
 
 /**
@@ -1055,7 +1179,8 @@ osinfo_os_get_network_install_resources_without_inheritance(OsinfoOs *os)
 OsinfoResourcesList *osinfo_os_get_network_install_resources(OsinfoOs *os)
 {
     return osinfo_os_get_resources_internal
-            (os, osinfo_os_get_network_install_resources_without_inheritance);
+            (os, OSINFO_OS_RESOURCES_NETWORK_INSTALL,
+             osinfo_os_get_network_install_resources_without_inheritance);
 }
 
 /**
@@ -1071,6 +1196,8 @@ void osinfo_os_add_minimum_resources(OsinfoOs *os, OsinfoResources *resources)
     g_return_if_fail(OSINFO_IS_RESOURCES(resources));
 
     osinfo_list_add(OSINFO_LIST(os->priv->minimum), OSINFO_ENTITY(resources));
+    osinfo_entity_join(OSINFO_ENTITY(os), OSINFO_ENTITY(resources));
+    osinfo_entity_changed(OSINFO_ENTITY(os));
 }
 
 /**
@@ -1088,6 +1215,8 @@ void osinfo_os_add_recommended_resources(OsinfoOs *os,
 
     osinfo_list_add(OSINFO_LIST(os->priv->recommended),
                     OSINFO_ENTITY(resources));
+    osinfo_entity_join(OSINFO_ENTITY(os), OSINFO_ENTITY(resources));
+    osinfo_entity_changed(OSINFO_ENTITY(os));
 }
 
 /**
@@ -1107,6 +1236,8 @@ void osinfo_os_add_maximum_resources(OsinfoOs *os,
 
     osinfo_list_add(OSINFO_LIST(os->priv->maximum),
                     OSINFO_ENTITY(resources));
+    osinfo_entity_join(OSINFO_ENTITY(os), OSINFO_ENTITY(resources));
+    osinfo_entity_changed(OSINFO_ENTITY(os));
 }
 
 /**
@@ -1127,6 +1258,63 @@ void osinfo_os_add_network_install_resources(OsinfoOs *os,
 
     osinfo_list_add(OSINFO_LIST(os->priv->network_install),
                     OSINFO_ENTITY(resources));
+    osinfo_entity_join(OSINFO_ENTITY(os), OSINFO_ENTITY(resources));
+    osinfo_entity_changed(OSINFO_ENTITY(os));
+}
+
+static void index_install_scripts_cb(OsinfoProduct *product, gpointer user_data)
+{
+    GHashTable *index = user_data;
+
+    osinfo_install_script_index_add(index, OSINFO_OS(product)->priv->scripts);
+}
+
+/*
+ * Indexes the install scripts of @os by profile and injection method, once
+ * until any entity changes.
+ *
+ * Must be called with osinfo_os_scripts_lock held.
+ */
+static void osinfo_os_ensure_install_scripts(OsinfoOs *os)
+{
+    guint generation = osinfo_entity_get_generation(OSINFO_ENTITY(os));
+
+    if (os->priv->ownScripts != NULL &&
+        os->priv->scriptsGeneration == generation)
+        return;
+
+    g_clear_pointer(&os->priv->ownScripts, g_hash_table_unref);
+    g_clear_pointer(&os->priv->allScripts, g_hash_table_unref);
+
+    os->priv->ownScripts = osinfo_install_script_index_new();
+    os->priv->allScripts = osinfo_install_script_index_new();
+    os->priv->scriptsGeneration = generation;
+
+    osinfo_install_script_index_add(os->priv->ownScripts, os->priv->scripts);
+    osinfo_product_foreach_related(OSINFO_PRODUCT(os),
+                                   OSINFO_PRODUCT_FOREACH_FLAG_DERIVES_FROM |
+                                   OSINFO_PRODUCT_FOREACH_FLAG_CLONES,
+                                   index_install_scripts_cb,
+                                   os->priv->allScripts);
+}
+
+static OsinfoInstallScript *
+osinfo_os_lookup_install_script(OsinfoOs *os,
+                                gboolean inherited,
+                                const gchar *profile,
+                                OsinfoInstallScriptInjectionMethod method)
+{
+    OsinfoInstallScript *script;
+
+    g_mutex_lock(&osinfo_os_scripts_lock);
+    osinfo_os_ensure_install_scripts(os);
+    script = osinfo_install_script_index_lookup(inherited ?
+                                                os->priv->allScripts :
+                                                os->priv->ownScripts,
+                                                profile, method);
+    g_mutex_unlock(&osinfo_os_scripts_lock);
+
+    return script;
 }
 
 /**
@@ -1141,28 +1329,48 @@ void osinfo_os_add_network_install_resources(OsinfoOs *os,
  */
 OsinfoInstallScript *osinfo_os_find_install_script(OsinfoOs *os, const gchar *profile)
 {
-    GList *scripts;
-    GList *tmp;
-    OsinfoInstallScript *script = NULL;
-
     g_return_val_if_fail(OSINFO_IS_OS(os), NULL);
     g_return_val_if_fail(profile != NULL, NULL);
 
-    scripts = osinfo_list_get_elements(OSINFO_LIST(os->priv->scripts));
-    tmp = scripts;
+    return osinfo_os_lookup_install_script(os, FALSE, profile, 0);
+}
 
-    while (tmp) {
-        script = tmp->data;
-        if (g_str_equal(profile, osinfo_install_script_get_profile(script)))
-            break;
 
-        tmp = tmp->next;
-        script = NULL;
-    }
+/**
+ * osinfo_os_find_install_script_by_injection_method:
+ * @os:      an operating system
+ * @profile: the install script profile
+ * @method:  the #OsinfoInstallScriptInjectionMethod flags the script must all
+ * support, or 0 to accept any method
+ *
+ * Finds an install script for @profile supporting @method. The scripts of
+ * @os itself are preferred, then the scripts of the operating systems @os
+ * derives from or clones.
+ *
+ * Returns: (transfer none): the install script, or NULL if none is found
+ *
+ * Since: 1.13.0
+ */
+OsinfoInstallScript *
+osinfo_os_find_install_script_by_injection_method(OsinfoOs *os,
+                                                  const gchar *profile,
+                                                  OsinfoInstallScriptInjectionMethod method)
+{
+    g_return_val_if_fail(OSINFO_IS_OS(os), NULL);
+    g_return_val_if_fail(profile != NULL, NULL);
 
-    g_list_free(scripts);
+    return osinfo_os_lookup_install_script(os, TRUE, profile, method);
+}
 
-    return script;
+
+/*
+ * Whether @os itself has any install script, without copying its list.
+ */
+gboolean osinfo_os_has_install_scripts(OsinfoOs *os)
+{
+    g_return_val_if_fail(OSINFO_IS_OS(os), FALSE);
+
+    return osinfo_list_get_length(OSINFO_LIST(os->priv->scripts)) > 0;
 }
 
 
@@ -1199,6 +1407,8 @@ void osinfo_os_add_install_script(OsinfoOs *os, OsinfoInstallScript *script)
     g_return_if_fail(OSINFO_IS_OS(os));
 
     osinfo_list_add(OSINFO_LIST(os->priv->scripts), OSINFO_ENTITY(script));
+    osinfo_entity_join(OSINFO_ENTITY(os), OSINFO_ENTITY(script));
+    osinfo_entity_changed(OSINFO_ENTITY(os));
 }
 
 /**
@@ -1227,6 +1437,75 @@ static gint osinfo_device_drivers_sort_by_priority(gconstpointer a,
     return osinfo_device_driver_get_priority(bdriver) - osinfo_device_driver_get_priority(adriver);
 }
 
+static gchar *osinfo_os_device_driver_key(const gchar *arch,
+                                          gboolean pre_installable,
+                                          const gchar *device_id)
+{
+    return g_strdup_printf("%s\n%d\n%s", arch, pre_installable ? 1 : 0, device_id);
+}
+
+/*
+ * Sorts the device drivers of @os by priority, once until any entity
+ * changes or drivers are added, and indexes the best driver for each
+ * device, architecture and installation method.
+ *
+ * Must be called with osinfo_os_drivers_lock held.
+ */
+static void osinfo_os_ensure_device_drivers(OsinfoOs *os)
+{
+    OsinfoList *drivers = OSINFO_LIST(os->priv->device_drivers);
+    GList *sorted, *l;
+    guint generation = osinfo_entity_get_generation(OSINFO_ENTITY(os));
+
+    if (os->priv->prioritizedDrivers != NULL &&
+        os->priv->driversGeneration == generation &&
+        os->priv->driversLength == osinfo_list_get_length(drivers))
+        return;
+
+    g_clear_pointer(&os->priv->prioritizedDrivers, g_ptr_array_unref);
+    g_clear_pointer(&os->priv->driversByDevice, g_hash_table_unref);
+
+    os->priv->prioritizedDrivers = g_ptr_array_new_with_free_func(g_object_unref);
+    os->priv->driversByDevice = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                      g_free, g_object_unref);
+    os->priv->driversGeneration = generation;
+    os->priv->driversLength = osinfo_list_get_length(drivers);
+
+    /* g_list_sort() is stable, so drivers of the same priority keep the
+     * order they were added in */
+    sorted = g_list_sort(osinfo_list_get_elements(drivers),
+                         osinfo_device_drivers_sort_by_priority);
+
+    for (l = sorted; l != NULL; l = l->next) {
+        OsinfoDeviceDriver *driver = OSINFO_DEVICE_DRIVER(l->data);
+        OsinfoList *devices = OSINFO_LIST(osinfo_device_driver_get_devices(driver));
+        const gchar *arch = osinfo_device_driver_get_architecture(driver);
+        gboolean pre_installable = osinfo_device_driver_get_pre_installable(driver);
+        gint i;
+
+        if (osinfo_device_driver_get_priority(driver) ==
+            osinfo_device_driver_get_priority(OSINFO_DEVICE_DRIVER(sorted->data)))
+            g_ptr_array_add(os->priv->prioritizedDrivers, g_object_ref(driver));
+
+        for (i = 0; i < osinfo_list_get_length(devices); i++) {
+            OsinfoEntity *device = osinfo_list_get_nth(devices, i);
+            gchar *key = osinfo_os_device_driver_key(arch, pre_installable,
+                                                     osinfo_entity_get_id(device));
+
+            /* Drivers are sorted, so the first one is the best one */
+            if (g_hash_table_contains(os->priv->driversByDevice, key)) {
+                g_free(key);
+                continue;
+            }
+
+            g_hash_table_insert(os->priv->driversByDevice, key,
+                                g_object_ref(driver));
+        }
+    }
+
+    g_list_free(sorted);
+}
+
 /**
  * osinfo_os_get_device_drivers_prioritized:
  * @os: an operating system
@@ -1240,29 +1519,67 @@ static gint osinfo_device_drivers_sort_by_priority(gconstpointer a,
 OsinfoDeviceDriverList *osinfo_os_get_device_drivers_prioritized(OsinfoOs *os)
 {
     OsinfoDeviceDriverList *device_drivers;
-    GList *list, *sorted, *l;
-    gint priority = -1;
+    guint i;
 
     g_return_val_if_fail(OSINFO_IS_OS(os), NULL);
 
-    list = osinfo_list_get_elements(OSINFO_LIST(os->priv->device_drivers));
-    sorted = g_list_sort(list, osinfo_device_drivers_sort_by_priority);
-
     device_drivers = osinfo_device_driverlist_new();
-    for (l = sorted; l != NULL; l = l->next) {
-        if (priority == -1)
-            priority = osinfo_device_driver_get_priority(OSINFO_DEVICE_DRIVER(l->data));
-
-        if (priority != osinfo_device_driver_get_priority(OSINFO_DEVICE_DRIVER(l->data)))
-            break;
 
-        osinfo_list_add(OSINFO_LIST(device_drivers), OSINFO_ENTITY(l->data));
-    }
-    g_list_free(sorted);
+    g_mutex_lock(&osinfo_os_drivers_lock);
+    osinfo_os_ensure_device_drivers(os);
+    for (i = 0; i < os->priv->prioritizedDrivers->len; i++)
+        osinfo_list_add(OSINFO_LIST(device_drivers),
+                        OSINFO_ENTITY(os->priv->prioritizedDrivers->pdata[i]));
+    g_mutex_unlock(&osinfo_os_drivers_lock);
 
     return device_drivers;
 }
 
+/**
+ * osinfo_os_find_device_driver:
+ * @os: an operating system
+ * @device: (transfer none): a device
+ * @arch: the architecture of the driver
+ * @pre_installable: whether the driver must be pre-installable or
+ * post-installable
+ *
+ * Find the device driver of @os with the highest priority supporting
+ * @device on the architecture @arch, which is pre-installable if
+ * @pre_installable is TRUE or post-installable otherwise. Among drivers of
+ * the same priority, the one added first to @os is returned.
+ *
+ * The drivers of @os are indexed by device once, rather than walking the
+ * devices of each driver on each call.
+ *
+ * Returns: (transfer none): the device driver, or NULL if none is found
+ *
+ * Since: 1.13.0
+ */
+OsinfoDeviceDriver *osinfo_os_find_device_driver(OsinfoOs *os,
+                                                 OsinfoDevice *device,
+                                                 const gchar *arch,
+                                                 gboolean pre_installable)
+{
+    OsinfoDeviceDriver *driver;
+    gchar *key;
+
+    g_return_val_if_fail(OSINFO_IS_OS(os), NULL);
+    g_return_val_if_fail(OSINFO_IS_DEVICE(device), NULL);
+    g_return_val_if_fail(arch != NULL, NULL);
+
+    key = osinfo_os_device_driver_key(arch, pre_installable,
+                                      osinfo_entity_get_id(OSINFO_ENTITY(device)));
+
+    g_mutex_lock(&osinfo_os_drivers_lock);
+    osinfo_os_ensure_device_drivers(os);
+    driver = g_hash_table_lookup(os->priv->driversByDevice, key);
+    g_mutex_unlock(&osinfo_os_drivers_lock);
+
+    g_free(key);
+
+    return driver;
+}
+
 /**
  * osinfo_os_add_device_driver:
  * @os: an operating system
@@ -1279,6 +1596,8 @@ void osinfo_os_add_device_driver(OsinfoOs *os, OsinfoDeviceDriver *driver)
 
     osinfo_list_add(OSINFO_LIST(os->priv->device_drivers),
                     OSINFO_ENTITY(driver));
+    osinfo_entity_join(OSINFO_ENTITY(os), OSINFO_ENTITY(driver));
+    osinfo_entity_changed(OSINFO_ENTITY(os));
 }
 
 struct GetKernelURLArgumentData {
@@ -1630,6 +1949,117 @@ OsinfoFirmwareList *osinfo_os_get_complete_firmware_list(OsinfoOs *os, OsinfoFil
     return foreach_data.firmwares;
 }
 
+static gchar *osinfo_os_firmware_key(const gchar *arch, const gchar *type)
+{
+    return g_strdup_printf("%s\n%s", arch, type);
+}
+
+static void get_firmware_support_cb(OsinfoProduct *product, gpointer user_data)
+{
+    GHashTable *support = user_data;
+    OsinfoList *firmwares = OSINFO_LIST(OSINFO_OS(product)->priv->firmwares);
+    GHashTable *unsupported;
+    gint len, i;
+
+    g_return_if_fail(OSINFO_IS_OS(product));
+
+    len = osinfo_list_get_length(firmwares);
+    unsupported = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    for (i = 0; i < len; i++) {
+        OsinfoFirmware *firmware = OSINFO_FIRMWARE(osinfo_list_get_nth(firmwares, i));
+
+        /* Only firmwares explicitly marked as unsupported are, as with
+         * the filter used by osinfo_os_get_firmware_list() */
+        if (!osinfo_entity_get_param_value_boolean_with_default(OSINFO_ENTITY(firmware),
+                                                                OSINFO_FIRMWARE_PROP_SUPPORTED,
+                                                                TRUE))
+            g_hash_table_add(unsupported,
+                             osinfo_os_firmware_key(osinfo_firmware_get_architecture(firmware),
+                                                    osinfo_firmware_get_firmware_type(firmware)));
+    }
+
+    /*
+     * The _foreach() function goes from the OS itself back to its oldest
+     * ancestor, so the first OS listing a firmware decides whether it is
+     * supported, and marking it as unsupported takes precedence within an
+     * OS, as with osinfo_os_get_firmware_list().
+     */
+    for (i = 0; i < len; i++) {
+        OsinfoFirmware *firmware = OSINFO_FIRMWARE(osinfo_list_get_nth(firmwares, i));
+        gchar *key = osinfo_os_firmware_key(osinfo_firmware_get_architecture(firmware),
+                                            osinfo_firmware_get_firmware_type(firmware));
+
+        if (g_hash_table_contains(support, key)) {
+            g_free(key);
+            continue;
+        }
+
+        g_hash_table_insert(support, key,
+                            GINT_TO_POINTER(!g_hash_table_contains(unsupported, key)));
+    }
+
+    g_hash_table_unref(unsupported);
+}
+
+/**
+ * osinfo_os_supports_firmware:
+ * @os: an operating system
+ * @arch: the architecture
+ * @type: the firmware type
+ *
+ * Check whether @os supports the firmware @type on the architecture @arch,
+ * that is whether osinfo_os_get_firmware_list() includes a firmware of
+ * @type for @arch. Firmwares inherited from the operating systems @os
+ * derives from or clones are taken into account. Firmwares @os does not
+ * know about are not considered as supported.
+ *
+ * The support of each firmware is resolved once and kept until any entity
+ * changes, rather than walking through the ancestors of @os on each call.
+ *
+ * Returns: TRUE if the firmware is supported, FALSE otherwise
+ *
+ * Since: 1.13.0
+ */
+gboolean osinfo_os_supports_firmware(OsinfoOs *os,
+                                     const gchar *arch,
+                                     const gchar *type)
+{
+    gchar *key;
+    gboolean supported;
+    guint generation;
+
+    g_return_val_if_fail(OSINFO_IS_OS(os), FALSE);
+    g_return_val_if_fail(arch != NULL, FALSE);
+    g_return_val_if_fail(type != NULL, FALSE);
+
+    key = osinfo_os_firmware_key(arch, type);
+    generation = osinfo_entity_get_generation(OSINFO_ENTITY(os));
+
+    g_mutex_lock(&osinfo_os_firmwares_lock);
+
+    if (os->priv->firmwareSupport == NULL ||
+        os->priv->firmwareSupportGeneration != generation) {
+        g_clear_pointer(&os->priv->firmwareSupport, g_hash_table_unref);
+
+        os->priv->firmwareSupport = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                          g_free, NULL);
+        os->priv->firmwareSupportGeneration = generation;
+        osinfo_product_foreach_related(OSINFO_PRODUCT(os),
+                                       OSINFO_PRODUCT_FOREACH_FLAG_DERIVES_FROM |
+                                       OSINFO_PRODUCT_FOREACH_FLAG_CLONES,
+                                       get_firmware_support_cb,
+                                       os->priv->firmwareSupport);
+    }
+
+    supported = GPOINTER_TO_INT(g_hash_table_lookup(os->priv->firmwareSupport, key));
+
+    g_mutex_unlock(&osinfo_os_firmwares_lock);
+
+    g_free(key);
+
+    return supported;
+}
+
 /**
  * osinfo_os_add_firmware:
  * @os: an operating system
@@ -1645,4 +2075,6 @@ void osinfo_os_add_firmware(OsinfoOs *os, OsinfoFirmware *firmware)
     g_return_if_fail(OSINFO_IS_FIRMWARE(firmware));
 
     osinfo_list_add(OSINFO_LIST(os->priv->firmwares), OSINFO_ENTITY(firmware));
+    osinfo_entity_join(OSINFO_ENTITY(os), OSINFO_ENTITY(firmware));
+    osinfo_entity_changed(OSINFO_ENTITY(os));
 }
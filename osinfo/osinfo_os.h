@@ -102,17 +102,27 @@ void osinfo_os_add_recommended_resources(OsinfoOs *os, OsinfoResources *resource
 void osinfo_os_add_maximum_resources(OsinfoOs *os, OsinfoResources *resources);
 
 OsinfoInstallScript *osinfo_os_find_install_script(OsinfoOs *os, const gchar *profile);
+OsinfoInstallScript *osinfo_os_find_install_script_by_injection_method(OsinfoOs *os,
+                                                                       const gchar *profile,
+                                                                       OsinfoInstallScriptInjectionMethod method);
 OsinfoInstallScriptList *osinfo_os_get_install_script_list(OsinfoOs *os);
 void osinfo_os_add_install_script(OsinfoOs *os, OsinfoInstallScript *script);
 
 OsinfoDeviceDriverList *osinfo_os_get_device_drivers(OsinfoOs *os);
 OsinfoDeviceDriverList *osinfo_os_get_device_drivers_prioritized(OsinfoOs *os);
 void osinfo_os_add_device_driver(OsinfoOs *os, OsinfoDeviceDriver *driver);
+OsinfoDeviceDriver *osinfo_os_find_device_driver(OsinfoOs *os,
+                                                 OsinfoDevice *device,
+                                                 const gchar *arch,
+                                                 gboolean pre_installable);
 
 const gchar *osinfo_os_get_kernel_url_argument(OsinfoOs *os);
 
 OsinfoFirmwareList *osinfo_os_get_firmware_list(OsinfoOs *os, OsinfoFilter *filter);
 OsinfoFirmwareList *osinfo_os_get_complete_firmware_list(OsinfoOs *os, OsinfoFilter *filter);
 void osinfo_os_add_firmware(OsinfoOs *os, OsinfoFirmware *firmware);
+gboolean osinfo_os_supports_firmware(OsinfoOs *os,
+                                     const gchar *arch,
+                                     const gchar *type);
 
 const gchar *osinfo_os_get_cloud_image_username(OsinfoOs *os);
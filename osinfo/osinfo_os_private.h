@@ -0,0 +1,28 @@
+/*
+ * libosinfo: an operating system
+ *
+ * Copyright (C) 2009-2020 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <osinfo/osinfo_os.h>
+
+gboolean osinfo_os_has_install_scripts(OsinfoOs *os);
+OsinfoDeviceList *osinfo_os_get_all_devices_internal(OsinfoOs *os,
+                                                     OsinfoFilter *filter,
+                                                     OsinfoDeviceList *unsupported);
@@ -20,6 +20,7 @@
 
 #include <osinfo/osinfo.h>
 #include "osinfo/osinfo_product_private.h"
+#include "osinfo_entity_private.h"
 #include <glib/gi18n-lib.h>
 
 /**
@@ -35,6 +36,11 @@ struct _OsinfoPlatformPrivate
 {
     // Value: List of device_link structs
     GList *deviceLinks;
+
+    /* Devices of the platform and its ancestors, see
+     * osinfo_platform_get_all_devices_flattened() */
+    GPtrArray *allDevices;
+    guint allDevicesGeneration;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE(OsinfoPlatform, osinfo_platform, OSINFO_TYPE_PRODUCT);
@@ -44,12 +50,16 @@ struct _OsinfoPlatformDeviceLink {
     gchar *driver;
 };
 
+/* Protects the flattened devices of all platforms */
+static GMutex osinfo_platform_devices_lock;
+
 static void
 osinfo_platform_finalize(GObject *object)
 {
     OsinfoPlatform *platform = OSINFO_PLATFORM(object);
 
     g_list_free_full(platform->priv->deviceLinks, g_object_unref);
+    g_clear_pointer(&platform->priv->allDevices, g_ptr_array_unref);
 
     /* Chain up to the parent class */
     G_OBJECT_CLASS(osinfo_platform_parent_class)->finalize(object);
@@ -87,26 +97,68 @@ OsinfoPlatform *osinfo_platform_new(const gchar *id)
                         NULL);
 }
 
-struct GetAllDevicesData {
-    OsinfoFilter *filter;
-    OsinfoDeviceList *devices;
-};
-
 static void get_all_devices_cb(OsinfoProduct *product, gpointer user_data)
 {
-    OsinfoDeviceList *devices;
-    OsinfoList *tmp_list;
-    struct GetAllDevicesData *foreach_data = (struct GetAllDevicesData *)user_data;
+    GPtrArray *devices = user_data;
+    GHashTable *last_devices;
+    GList *tmp;
 
     g_return_if_fail(OSINFO_IS_PLATFORM(product));
 
-    devices = osinfo_platform_get_devices(OSINFO_PLATFORM(product),
-                                          foreach_data->filter);
-    tmp_list = osinfo_list_new_union(OSINFO_LIST(foreach_data->devices),
-                                     OSINFO_LIST(devices));
-    g_object_unref(foreach_data->devices);
-    g_object_unref(devices);
-    foreach_data->devices = OSINFO_DEVICELIST(tmp_list);
+    /* As with osinfo_list_add(), the last link to a device takes
+     * precedence over the earlier ones */
+    last_devices = g_hash_table_new(g_str_hash, g_str_equal);
+    for (tmp = OSINFO_PLATFORM(product)->priv->deviceLinks; tmp; tmp = tmp->next) {
+        OsinfoDevice *dev = osinfo_devicelink_get_target(OSINFO_DEVICELINK(tmp->data));
+
+        g_hash_table_insert(last_devices,
+                            (gpointer)osinfo_entity_get_id(OSINFO_ENTITY(dev)),
+                            tmp->data);
+    }
+
+    for (tmp = OSINFO_PLATFORM(product)->priv->deviceLinks; tmp; tmp = tmp->next) {
+        OsinfoDevice *dev = osinfo_devicelink_get_target(OSINFO_DEVICELINK(tmp->data));
+
+        if (g_hash_table_lookup(last_devices,
+                                osinfo_entity_get_id(OSINFO_ENTITY(dev))) == tmp->data)
+            g_ptr_array_add(devices, dev);
+    }
+
+    g_hash_table_unref(last_devices);
+}
+
+/*
+ * Returns the devices of @platform and of the platforms it upgrades or
+ * derives from, in that order. Each platform's devices are deduplicated,
+ * but not the whole array. The array is kept until any entity changes,
+ * and holds no references since devices are never removed from a
+ * platform.
+ */
+static GPtrArray *osinfo_platform_get_all_devices_flattened(OsinfoPlatform *platform)
+{
+    guint generation = osinfo_entity_get_generation(OSINFO_ENTITY(platform));
+    GPtrArray *devices;
+
+    g_mutex_lock(&osinfo_platform_devices_lock);
+
+    if (platform->priv->allDevices == NULL ||
+        platform->priv->allDevicesGeneration != generation) {
+        g_clear_pointer(&platform->priv->allDevices, g_ptr_array_unref);
+
+        platform->priv->allDevices = g_ptr_array_new();
+        platform->priv->allDevicesGeneration = generation;
+        osinfo_product_foreach_related(OSINFO_PRODUCT(platform),
+                                       OSINFO_PRODUCT_FOREACH_FLAG_UPGRADES |
+                                       OSINFO_PRODUCT_FOREACH_FLAG_DERIVES_FROM,
+                                       get_all_devices_cb,
+                                       platform->priv->allDevices);
+    }
+
+    devices = g_ptr_array_ref(platform->priv->allDevices);
+
+    g_mutex_unlock(&osinfo_platform_devices_lock);
+
+    return devices;
 }
 
 
@@ -126,18 +178,38 @@ static void get_all_devices_cb(OsinfoProduct *product, gpointer user_data)
 OsinfoDeviceList *osinfo_platform_get_all_devices(OsinfoPlatform *platform,
                                                   OsinfoFilter *filter)
 {
-    struct GetAllDevicesData foreach_data = {
-        .filter = filter,
-        .devices = osinfo_devicelist_new()
-    };
-
-    osinfo_product_foreach_related(OSINFO_PRODUCT(platform),
-                                   OSINFO_PRODUCT_FOREACH_FLAG_UPGRADES |
-                                   OSINFO_PRODUCT_FOREACH_FLAG_DERIVES_FROM,
-                                   get_all_devices_cb,
-                                   &foreach_data);
-
-    return foreach_data.devices;
+    OsinfoDeviceList *newList;
+    GPtrArray *devices;
+    GHashTable *seen_devices;
+    guint i;
+
+    g_return_val_if_fail(OSINFO_IS_PLATFORM(platform), NULL);
+    g_return_val_if_fail(!filter || OSINFO_IS_FILTER(filter), NULL);
+
+    devices = osinfo_platform_get_all_devices_flattened(platform);
+
+    newList = osinfo_devicelist_new();
+    seen_devices = g_hash_table_new(g_str_hash, g_str_equal);
+
+    for (i = 0; i < devices->len; i++) {
+        OsinfoEntity *dev = devices->pdata[i];
+        const gchar *dev_id = osinfo_entity_get_id(dev);
+
+        if (filter && !osinfo_filter_matches(filter, dev))
+            continue;
+
+        /* The first platform listing a device takes precedence */
+        if (g_hash_table_contains(seen_devices, dev_id))
+            continue;
+        g_hash_table_add(seen_devices, (gpointer)dev_id);
+
+        osinfo_list_add(OSINFO_LIST(newList), dev);
+    }
+
+    g_hash_table_unref(seen_devices);
+    g_ptr_array_unref(devices);
+
+    return newList;
 }
 
 /**
@@ -229,6 +301,9 @@ OsinfoDeviceLink *osinfo_platform_add_device(OsinfoPlatform *platform, OsinfoDev
 
     platform->priv->deviceLinks = g_list_prepend(platform->priv->deviceLinks,
                                                  devlink);
+    osinfo_entity_join(OSINFO_ENTITY(platform), OSINFO_ENTITY(devlink));
+    osinfo_entity_join(OSINFO_ENTITY(platform), OSINFO_ENTITY(dev));
+    osinfo_entity_changed(OSINFO_ENTITY(platform));
 
     return devlink;
 }
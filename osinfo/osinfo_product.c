@@ -25,6 +25,7 @@
 #include <glib/gi18n-lib.h>
 
 #include "osinfo/osinfo_product_private.h"
+#include "osinfo_entity_private.h"
 
 /**
  * SECTION:osinfo_product
@@ -49,6 +50,18 @@ struct _OsinfoProductPrivate
 {
     // Value: Array of product_link structs
     GList *productLinks;
+
+    /* Release and EOL dates as julian day numbers, 0 if unset, parsed
+     * when the entity serial was datesSerial */
+    gboolean datesParsed;
+    guint datesSerial;
+    guint32 releaseDay;
+    guint32 eolDay;
+
+    /* Products related to this one, for each combination of
+     * OsinfoProductForeachFlag, valid while relatedGeneration is current */
+    GPtrArray *relatedClosure[OSINFO_PRODUCT_FOREACH_FLAG_CLONES << 1];
+    guint relatedGeneration;
 };
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE(OsinfoProduct, osinfo_product, OSINFO_TYPE_ENTITY);
@@ -77,6 +90,13 @@ enum {
 };
 static GParamSpec *properties[LAST_PROP];
 
+/* Protects the related product closures of all products */
+static GMutex osinfo_product_related_lock;
+/* Bumped whenever a relationship is added to any product */
+static guint osinfo_product_related_generation;
+/* Protects the parsed support dates of all products */
+static GMutex osinfo_product_dates_lock;
+
 static void osinfo_product_link_free(gpointer data)
 {
     struct _OsinfoProductProductLink *prodlink = data;
@@ -89,8 +109,11 @@ static void
 osinfo_product_finalize(GObject *object)
 {
     OsinfoProduct *product = OSINFO_PRODUCT(object);
+    gsize i;
 
     g_list_free_full(product->priv->productLinks, osinfo_product_link_free);
+    for (i = 0; i < G_N_ELEMENTS(product->priv->relatedClosure); i++)
+        g_clear_pointer(&product->priv->relatedClosure[i], g_ptr_array_unref);
 
     /* Chain up to the parent class */
     G_OBJECT_CLASS(osinfo_product_parent_class)->finalize(object);
@@ -268,6 +291,27 @@ OsinfoProductList *osinfo_product_get_related(OsinfoProduct *product, OsinfoProd
 }
 
 
+/*
+ * Whether @product has the relationship @relshp with @otherproduct,
+ * without building the list of related products.
+ */
+gboolean osinfo_product_has_related(OsinfoProduct *product,
+                                    OsinfoProductRelationship relshp,
+                                    OsinfoProduct *otherproduct)
+{
+    GList *tmp;
+
+    for (tmp = product->priv->productLinks; tmp; tmp = tmp->next) {
+        struct _OsinfoProductProductLink *prodlink = tmp->data;
+
+        if (prodlink->relshp == relshp && prodlink->otherProduct == otherproduct)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+
 /**
  * osinfo_product_add_related:
  * @product: a product
@@ -290,6 +334,12 @@ void osinfo_product_add_related(OsinfoProduct *product, OsinfoProductRelationshi
     productLink->relshp = relshp;
 
     product->priv->productLinks = g_list_prepend(product->priv->productLinks, productLink);
+    osinfo_entity_join(OSINFO_ENTITY(product), OSINFO_ENTITY(otherproduct));
+    osinfo_entity_changed(OSINFO_ENTITY(product));
+
+    g_mutex_lock(&osinfo_product_related_lock);
+    osinfo_product_related_generation++;
+    g_mutex_unlock(&osinfo_product_related_lock);
 }
 
 const gchar *osinfo_product_get_vendor(OsinfoProduct *product)
@@ -397,19 +447,152 @@ GDate *osinfo_product_get_eol_date(OsinfoProduct *product)
     return date_from_string(str);
 }
 
+static guint32 julian_from_string(const gchar *str)
+{
+    GDate *date;
+    guint32 julian = 0;
+
+    if (!str)
+        return 0;
+
+    date = date_from_string(str);
+    if (date == NULL)
+        return 0;
+
+    if (g_date_valid(date))
+        julian = g_date_get_julian(date);
+    g_date_free(date);
+
+    return julian;
+}
+
+/*
+ * osinfo_product_get_support_days:
+ * @product: a product
+ * @release: (out) (optional): the release day number, or 0
+ * @eol: (out) (optional): the EOL day number, or 0
+ *
+ * Get the release and EOL dates of @product as julian day numbers, as
+ * returned by g_date_get_julian(), with 0 standing for an unset date.
+ * The dates are parsed once and kept until the product changes, and
+ * may be queried from multiple threads, as product filters do.
+ */
+void osinfo_product_get_support_days(OsinfoProduct *product,
+                                     guint32 *release,
+                                     guint32 *eol)
+{
+    OsinfoProductPrivate *priv = product->priv;
+    guint serial = osinfo_entity_get_serial(OSINFO_ENTITY(product));
+
+    g_mutex_lock(&osinfo_product_dates_lock);
+
+    if (!priv->datesParsed || priv->datesSerial != serial) {
+        priv->releaseDay =
+            julian_from_string(osinfo_product_get_release_date_string(product));
+        priv->eolDay =
+            julian_from_string(osinfo_product_get_eol_date_string(product));
+        priv->datesSerial = serial;
+        priv->datesParsed = TRUE;
+    }
+
+    if (release)
+        *release = priv->releaseDay;
+    if (eol)
+        *eol = priv->eolDay;
+
+    g_mutex_unlock(&osinfo_product_dates_lock);
+}
+
 const gchar *osinfo_product_get_logo(OsinfoProduct *product)
 {
     return osinfo_entity_get_param_value(OSINFO_ENTITY(product), OSINFO_PRODUCT_PROP_LOGO);
 }
 
-static OsinfoList *osinfo_list_append(OsinfoList *appendee,
-                                      OsinfoList *appended)
+static void osinfo_product_collect_related(OsinfoProduct *product,
+                                          unsigned int flags,
+                                          GHashTable *visited,
+                                          GPtrArray *closure)
+{
+    static const struct {
+        OsinfoProductForeachFlag flag;
+        OsinfoProductRelationship relshp;
+    } relationships[] = {
+        { OSINFO_PRODUCT_FOREACH_FLAG_DERIVES_FROM, OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM },
+        { OSINFO_PRODUCT_FOREACH_FLAG_UPGRADES, OSINFO_PRODUCT_RELATIONSHIP_UPGRADES },
+        { OSINFO_PRODUCT_FOREACH_FLAG_CLONES, OSINFO_PRODUCT_RELATIONSHIP_CLONES },
+    };
+    GPtrArray *related = g_ptr_array_new();
+    gsize i;
+    guint j;
+
+    for (i = 0; i < G_N_ELEMENTS(relationships); i++) {
+        GList *tmp;
+
+        if (!(flags & relationships[i].flag))
+            continue;
+
+        for (tmp = product->priv->productLinks; tmp; tmp = tmp->next) {
+            struct _OsinfoProductProductLink *prodlink = tmp->data;
+
+            if (prodlink->relshp == relationships[i].relshp)
+                g_ptr_array_add(related, prodlink->otherProduct);
+        }
+    }
+
+    /* Depth first, each product visited once, where it is first reached */
+    for (j = 0; j < related->len; j++) {
+        OsinfoProduct *other = related->pdata[j];
+
+        if (g_hash_table_contains(visited, other))
+            continue;
+
+        g_hash_table_add(visited, other);
+        g_ptr_array_add(closure, other);
+        osinfo_product_collect_related(other, flags, visited, closure);
+    }
+
+    g_ptr_array_unref(related);
+}
+
+/*
+ * Returns the products related to @product according to @flags, in the
+ * order they are visited. The products are kept alive by the links of
+ * @product, which are never removed, so the closure holds no references.
+ */
+static GPtrArray *osinfo_product_get_related_closure(OsinfoProduct *product,
+                                                    unsigned int flags)
 {
-    OsinfoList *result;
-    result = osinfo_list_new_union(appendee, appended);
-    g_object_unref(G_OBJECT(appendee));
+    OsinfoProductPrivate *priv = product->priv;
+    GPtrArray *closure;
+
+    flags &= G_N_ELEMENTS(priv->relatedClosure) - 1;
+
+    g_mutex_lock(&osinfo_product_related_lock);
+
+    if (priv->relatedGeneration != osinfo_product_related_generation) {
+        gsize i;
+
+        for (i = 0; i < G_N_ELEMENTS(priv->relatedClosure); i++)
+            g_clear_pointer(&priv->relatedClosure[i], g_ptr_array_unref);
+        priv->relatedGeneration = osinfo_product_related_generation;
+    }
+
+    if (priv->relatedClosure[flags] == NULL) {
+        GHashTable *visited = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+        closure = g_ptr_array_new();
+        g_hash_table_add(visited, product);
+        osinfo_product_collect_related(product, flags, visited, closure);
+        g_hash_table_unref(visited);
+
+        priv->relatedClosure[flags] = closure;
+    }
+
+    closure = g_ptr_array_ref(priv->relatedClosure[flags]);
 
-    return result;
+    g_mutex_unlock(&osinfo_product_related_lock);
+
+    return closure;
 }
 
 /**
@@ -423,53 +606,25 @@ static OsinfoList *osinfo_list_append(OsinfoList *appendee,
  * to @product. The meaning of 'related' is defined by the @flag parameter,
  * and can be products @product derives from or products which @product
  * upgrades or clones, or a combination of these, or none.
+ *
+ * Related products are visited depth first, each of them exactly once,
+ * even when reachable through several relationships. The traversal is
+ * cached until a relationship is added to any product.
  */
 void osinfo_product_foreach_related(OsinfoProduct *product,
                                     unsigned int flags,
                                     OsinfoProductForeach foreach_func,
                                     gpointer user_data)
 {
-    OsinfoList *related_list;
-    OsinfoProductList *tmp_related;
+    GPtrArray *closure;
     guint i;
 
     foreach_func(product, user_data);
 
-    related_list = OSINFO_LIST(osinfo_productlist_new());
-    if (flags & OSINFO_PRODUCT_FOREACH_FLAG_DERIVES_FROM) {
-        tmp_related = osinfo_product_get_related
-                      (product, OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM);
-        related_list = osinfo_list_append(related_list,
-                                          OSINFO_LIST(tmp_related));
-        g_object_unref(G_OBJECT(tmp_related));
-    }
-
-    if (flags & OSINFO_PRODUCT_FOREACH_FLAG_UPGRADES) {
-        tmp_related = osinfo_product_get_related
-                      (product, OSINFO_PRODUCT_RELATIONSHIP_UPGRADES);
-        related_list = osinfo_list_append(related_list,
-                                          OSINFO_LIST(tmp_related));
-        g_object_unref(G_OBJECT(tmp_related));
-    }
-
-    if (flags & OSINFO_PRODUCT_FOREACH_FLAG_CLONES) {
-        tmp_related = osinfo_product_get_related
-                      (product, OSINFO_PRODUCT_RELATIONSHIP_CLONES);
-        related_list = osinfo_list_append(related_list,
-                                          OSINFO_LIST(tmp_related));
-        g_object_unref(G_OBJECT(tmp_related));
-    }
-
-    for (i = 0; i < osinfo_list_get_length(related_list); i++) {
-        OsinfoEntity *related;
-
-        related = osinfo_list_get_nth(related_list, i);
-        osinfo_product_foreach_related(OSINFO_PRODUCT(related),
-                                       flags,
-                                       foreach_func,
-                                       user_data);
-    }
-    g_object_unref(related_list);
+    closure = osinfo_product_get_related_closure(product, flags);
+    for (i = 0; i < closure->len; i++)
+        foreach_func(OSINFO_PRODUCT(closure->pdata[i]), user_data);
+    g_ptr_array_unref(closure);
 }
 
 /**
@@ -35,3 +35,11 @@ void osinfo_product_foreach_related(OsinfoProduct *product,
                                     unsigned int flags,
                                     OsinfoProductForeach foreach_func,
                                     gpointer user_data);
+
+void osinfo_product_get_support_days(OsinfoProduct *product,
+                                     guint32 *release,
+                                     guint32 *eol);
+
+gboolean osinfo_product_has_related(OsinfoProduct *product,
+                                    OsinfoProductRelationship relshp,
+                                    OsinfoProduct *otherproduct);
@@ -20,6 +20,8 @@
 
 #include <osinfo/osinfo.h>
 #include <glib/gi18n-lib.h>
+#include "osinfo/osinfo_product_private.h"
+#include "osinfo_filter_private.h"
 
 /**
  * SECTION:osinfo_productfilter
@@ -39,19 +41,37 @@ struct _OsinfoProductFilterPrivate
     // Note: Only used when productfiltering OsinfoProduct objects
     GHashTable *productConstraints;
 
+    /* Flat form of productConstraints, see osinfo_productfilter_ensure_compiled() */
+    GArray *program;
+    gint compiled;
+
     GDate *supportDate;
+    /* supportDate as a julian day number */
+    guint32 supportDay;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE(OsinfoProductFilter, osinfo_productfilter, OSINFO_TYPE_FILTER);
 
 static void osinfo_productfilter_finalize(GObject *object);
 static gboolean osinfo_productfilter_matches_default(OsinfoFilter *productfilter, OsinfoEntity *entity);
+static void osinfo_productfilter_compile_default(OsinfoFilter *filter);
+static void osinfo_productfilter_program_free(OsinfoProductFilter *productfilter);
+
+typedef struct _OsinfoProductFilterConstraint OsinfoProductFilterConstraint;
+struct _OsinfoProductFilterConstraint {
+    OsinfoProductRelationship relshp;
+    OsinfoProduct *product;
+};
+
+/* Protects the compilation of all product filters */
+static GMutex osinfo_productfilter_compile_lock;
 
 static void
 osinfo_productfilter_finalize(GObject *object)
 {
     OsinfoProductFilter *productfilter = OSINFO_PRODUCTFILTER(object);
 
+    osinfo_productfilter_program_free(productfilter);
     g_hash_table_unref(productfilter->priv->productConstraints);
 
     if (productfilter->priv->supportDate)
@@ -71,6 +91,8 @@ osinfo_productfilter_class_init(OsinfoProductFilterClass *klass)
     g_klass->finalize = osinfo_productfilter_finalize;
 
     filter_klass->matches = osinfo_productfilter_matches_default;
+    osinfo_filter_class_set_compile_func(filter_klass,
+                                         osinfo_productfilter_compile_default);
 }
 
 
@@ -136,6 +158,7 @@ gint osinfo_productfilter_add_product_constraint(OsinfoProductFilter *productfil
     g_object_ref(product);
     values = g_list_prepend(values, product);
     g_hash_table_insert(productfilter->priv->productConstraints, GINT_TO_POINTER(relshp), values);
+    osinfo_productfilter_program_free(productfilter);
 
     return 0;
 }
@@ -152,6 +175,7 @@ void osinfo_productfilter_clear_product_constraint(OsinfoProductFilter *productf
     g_return_if_fail(OSINFO_IS_PRODUCTFILTER(productfilter));
 
     g_hash_table_remove(productfilter->priv->productConstraints, (gpointer) relshp);
+    osinfo_productfilter_program_free(productfilter);
 }
 
 
@@ -166,6 +190,7 @@ void osinfo_productfilter_clear_product_constraints(OsinfoProductFilter *product
     g_return_if_fail(OSINFO_IS_PRODUCTFILTER(productfilter));
 
     g_hash_table_remove_all(productfilter->priv->productConstraints);
+    osinfo_productfilter_program_free(productfilter);
 }
 
 
@@ -203,60 +228,80 @@ void osinfo_productfilter_add_support_date_constraint(OsinfoProductFilter *produ
         productfilter->priv->supportDate = g_date_new_dmy(g_date_get_day(when),
                                                           g_date_get_month(when),
                                                           g_date_get_year(when));
+        productfilter->priv->supportDay = g_date_get_julian(productfilter->priv->supportDate);
     }
 }
 
 
 
-struct osinfo_productfilter_match_args {
-    OsinfoProductFilter *productfilter;
-    OsinfoEntity *entity;
-    gboolean matched;
-};
+static void osinfo_productfilter_program_free(OsinfoProductFilter *productfilter)
+{
+    g_clear_pointer(&productfilter->priv->program, g_array_unref);
+    g_atomic_int_set(&productfilter->priv->compiled, FALSE);
+}
 
 
-static void osinfo_productfilter_match_product_iterator(gpointer key, gpointer value, gpointer data)
+/*
+ * Flattens the relationship constraints of @productfilter, once until
+ * they change. The property constraints are compiled by #OsinfoFilter.
+ */
+static void osinfo_productfilter_ensure_compiled(OsinfoProductFilter *productfilter)
 {
-    struct osinfo_productfilter_match_args *args = data;
-    OsinfoProduct *product = OSINFO_PRODUCT(args->entity);
-    OsinfoProductRelationship relshp = GPOINTER_TO_INT(key);
-    GList *relProducts = value;
-    OsinfoProductList *productlist = osinfo_product_get_related(product, relshp);
-    gboolean ret = TRUE;
-
-    if (relProducts && osinfo_list_get_length(OSINFO_LIST(productlist)) == 0) {
-        ret = FALSE;
+    GHashTableIter iter;
+    gpointer key, value;
+
+    if (g_atomic_int_get(&productfilter->priv->compiled))
+        return;
+
+    g_mutex_lock(&osinfo_productfilter_compile_lock);
+    if (productfilter->priv->compiled)
         goto cleanup;
-    }
 
-    while (relProducts) {
-        OsinfoProduct *currProduct = relProducts->data;
-        int i;
-        gboolean found = FALSE;
-        for (i = 0; i < osinfo_list_get_length(OSINFO_LIST(productlist)); i++) {
-            OsinfoProduct *testProduct = OSINFO_PRODUCT(osinfo_list_get_nth(OSINFO_LIST(productlist), i));
-            if (testProduct == currProduct) {
-                found = TRUE;
-                break;
+    productfilter->priv->program =
+        g_array_new(FALSE, FALSE, sizeof(OsinfoProductFilterConstraint));
+
+    g_hash_table_iter_init(&iter, productfilter->priv->productConstraints);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        GList *tmp;
+
+        for (tmp = value; tmp; tmp = tmp->next) {
+            OsinfoProductFilterConstraint constraint = {
+                .relshp = GPOINTER_TO_INT(key),
+                .product = tmp->data,
+            };
+            guint i;
+
+            for (i = 0; i < productfilter->priv->program->len; i++) {
+                OsinfoProductFilterConstraint *other =
+                    &g_array_index(productfilter->priv->program,
+                                   OsinfoProductFilterConstraint, i);
+
+                if (other->relshp == constraint.relshp &&
+                    other->product == constraint.product)
+                    break;
             }
+            if (i == productfilter->priv->program->len)
+                g_array_append_val(productfilter->priv->program, constraint);
         }
-        if (!found) {
-            ret = FALSE;
-            goto cleanup;
-        }
-
-        relProducts = relProducts->next;
     }
 
+    g_atomic_int_set(&productfilter->priv->compiled, TRUE);
+
  cleanup:
-    g_object_unref(productlist);
-    args->matched = ret;
+    g_mutex_unlock(&osinfo_productfilter_compile_lock);
 }
 
+
+static void osinfo_productfilter_compile_default(OsinfoFilter *filter)
+{
+    osinfo_productfilter_ensure_compiled(OSINFO_PRODUCTFILTER(filter));
+}
+
+
 static gboolean osinfo_productfilter_matches_default(OsinfoFilter *filter, OsinfoEntity *entity)
 {
     OsinfoProductFilter *productfilter;
-    struct osinfo_productfilter_match_args args;
+    guint i;
 
     g_return_val_if_fail(OSINFO_IS_PRODUCTFILTER(filter), FALSE);
     g_return_val_if_fail(OSINFO_IS_PRODUCT(entity), FALSE);
@@ -266,37 +311,30 @@ static gboolean osinfo_productfilter_matches_default(OsinfoFilter *filter, Osinf
 
     productfilter = OSINFO_PRODUCTFILTER(filter);
 
-    args.productfilter = productfilter;
-    args.entity = entity;
-    args.matched = TRUE;
+    osinfo_productfilter_ensure_compiled(productfilter);
 
-    g_hash_table_foreach(productfilter->priv->productConstraints,
-                         osinfo_productfilter_match_product_iterator,
-                         &args);
+    for (i = 0; i < productfilter->priv->program->len; i++) {
+        OsinfoProductFilterConstraint *constraint =
+            &g_array_index(productfilter->priv->program,
+                           OsinfoProductFilterConstraint, i);
 
-    if (productfilter->priv->supportDate) {
-        GDate *when = productfilter->priv->supportDate;
-        GDate *release;
-        GDate *eol;
-
-        release = osinfo_product_get_release_date(OSINFO_PRODUCT(entity));
-        if (release != NULL) {
-            gboolean newer;
-            newer = (g_date_compare(release, when) > 0);
-            g_date_free(release);
-            if (newer)
-                return FALSE;
-        }
+        if (!osinfo_product_has_related(OSINFO_PRODUCT(entity),
+                                        constraint->relshp,
+                                        constraint->product))
+            return FALSE;
+    }
 
-        eol = osinfo_product_get_eol_date(OSINFO_PRODUCT(entity));
-        if (eol != NULL) {
-            gboolean older;
-            older = (g_date_compare(eol, when) < 0);
-            g_date_free(eol);
-            if (older)
-                return FALSE;
-        }
+    if (productfilter->priv->supportDate) {
+        guint32 when = productfilter->priv->supportDay;
+        guint32 release;
+        guint32 eol;
+
+        osinfo_product_get_support_days(OSINFO_PRODUCT(entity), &release, &eol);
+        if (release != 0 && release > when)
+            return FALSE;
+        if (eol != 0 && eol < when)
+            return FALSE;
     }
 
-    return args.matched;
+    return TRUE;
 }
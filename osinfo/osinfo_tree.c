@@ -35,6 +35,9 @@ struct _CreateFromLocationAsyncData {
     gchar *content;
     gchar *location;
     gchar *treeinfo;
+    gchar *url;
+
+    guint flags;
 
     GTask *res;
 };
@@ -45,6 +48,7 @@ static void create_from_location_async_data_free(CreateFromLocationAsyncData *da
     g_clear_object(&data->message);
     g_clear_object(&data->file);
     g_clear_object(&data->res);
+    g_free(data->url);
 
     g_slice_free(CreateFromLocationAsyncData, data);
 }
@@ -64,6 +68,31 @@ static void create_from_location_data_free(CreateFromLocationData *data)
     g_slice_free(CreateFromLocationData, data);
 }
 
+typedef struct _TreeCacheEntry TreeCacheEntry;
+struct _TreeCacheEntry {
+    gchar *etag;
+    gchar *last_modified;
+
+    OsinfoTree *tree;
+};
+
+static void tree_cache_entry_free(gpointer opaque)
+{
+    TreeCacheEntry *entry = opaque;
+
+    g_free(entry->etag);
+    g_free(entry->last_modified);
+    g_object_unref(entry->tree);
+
+    g_slice_free(TreeCacheEntry, entry);
+}
+
+/* Key: gchar* URL of the remote treeinfo file
+ * Value: TreeCacheEntry*
+ */
+static GHashTable *tree_cache;
+G_LOCK_DEFINE_STATIC(tree_cache);
+
 /**
  * osinfo_tree_error_quark:
  *
@@ -500,6 +529,39 @@ static void on_tree_create_from_location_ready(GObject *source_object,
 OsinfoTree *osinfo_tree_create_from_location(const gchar *location,
                                              GCancellable *cancellable,
                                              GError **error)
+{
+    return osinfo_tree_create_from_location_with_flags(location,
+                                                       cancellable,
+                                                       0,
+                                                       error);
+}
+
+/**
+ * osinfo_tree_create_from_location_with_flags:
+ * @location: the location of an installation tree
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @flags: An #OsinfoTreeDetectFlags, or 0.
+ * @error: The location where to store any error, or %NULL
+ *
+ * Creates a new #OsinfoTree for installation tree at @location. The @location
+ * could be a http:// or a https:// URI, or a local file.
+ *
+ * When %OSINFO_TREE_DETECT_USE_CACHE is set in @flags, the treeinfo of a
+ * remote tree is only downloaded again when the server reports it has
+ * changed since the last time it was fetched, otherwise the previously
+ * parsed tree is reused. Use #osinfo_tree_clear_cache to drop all the
+ * cached trees.
+ *
+ * NOTE: Currently this only works for trees with a .treeinfo file
+ *
+ * Returns: (transfer full): a new #OsinfoTree , or NULL on error
+ *
+ * Since: 1.13.0
+ */
+OsinfoTree *osinfo_tree_create_from_location_with_flags(const gchar *location,
+                                                        GCancellable *cancellable,
+                                                        guint flags,
+                                                        GError **error)
 {
     CreateFromLocationData *data;
     OsinfoTree *ret;
@@ -508,16 +570,17 @@ OsinfoTree *osinfo_tree_create_from_location(const gchar *location,
     data->main_loop = g_main_loop_new(g_main_context_get_thread_default(),
                                       FALSE);
 
-    osinfo_tree_create_from_location_async(location,
-                                           G_PRIORITY_DEFAULT,
-                                           cancellable,
-                                           on_tree_create_from_location_ready,
-                                           data);
+    osinfo_tree_create_from_location_with_flags_async(location,
+                                                      G_PRIORITY_DEFAULT,
+                                                      cancellable,
+                                                      on_tree_create_from_location_ready,
+                                                      flags,
+                                                      data);
 
     /* Loop till we get a reply (or time out) */
     g_main_loop_run(data->main_loop);
 
-    ret = osinfo_tree_create_from_location_finish(data->res, error);
+    ret = osinfo_tree_create_from_location_with_flags_finish(data->res, error);
     create_from_location_data_free(data);
 
     return ret;
@@ -663,6 +726,130 @@ static OsinfoTree *load_keyinfo(const gchar *location,
     return tree;
 }
 
+static OsinfoTree *tree_copy(OsinfoTree *tree)
+{
+    OsinfoEntity *entity = OSINFO_ENTITY(tree);
+    OsinfoTree *copy;
+    GList *keys, *key;
+
+    copy = osinfo_tree_new(osinfo_entity_get_id(entity), NULL);
+
+    keys = osinfo_entity_get_param_keys(entity);
+    for (key = keys; key != NULL; key = key->next) {
+        GList *values, *value;
+
+        if (g_str_equal(key->data, OSINFO_ENTITY_PROP_ID))
+            continue;
+
+        values = osinfo_entity_get_param_value_list(entity, key->data);
+        for (value = values; value != NULL; value = value->next)
+            osinfo_entity_add_param(OSINFO_ENTITY(copy),
+                                    key->data,
+                                    value->data);
+        g_list_free(values);
+    }
+    g_list_free(keys);
+
+    return copy;
+}
+
+static void tree_cache_add_conditional_headers(SoupMessage *message,
+                                               const gchar *url)
+{
+    SoupMessageHeaders *headers = soup_message_get_request_headers(message);
+    TreeCacheEntry *entry = NULL;
+
+    G_LOCK(tree_cache);
+
+    if (tree_cache != NULL)
+        entry = g_hash_table_lookup(tree_cache, url);
+
+    if (entry != NULL) {
+        if (entry->etag != NULL)
+            soup_message_headers_replace(headers,
+                                         "If-None-Match",
+                                         entry->etag);
+        if (entry->last_modified != NULL)
+            soup_message_headers_replace(headers,
+                                         "If-Modified-Since",
+                                         entry->last_modified);
+    }
+
+    G_UNLOCK(tree_cache);
+}
+
+static OsinfoTree *tree_cache_lookup(const gchar *url)
+{
+    TreeCacheEntry *entry = NULL;
+    OsinfoTree *tree = NULL;
+
+    G_LOCK(tree_cache);
+
+    if (tree_cache != NULL)
+        entry = g_hash_table_lookup(tree_cache, url);
+
+    /* Callers are free to modify the tree they get, so never hand out
+     * the cached instance itself */
+    if (entry != NULL)
+        tree = tree_copy(entry->tree);
+
+    G_UNLOCK(tree_cache);
+
+    return tree;
+}
+
+static void tree_cache_store(const gchar *url,
+                             SoupMessage *message,
+                             OsinfoTree *tree)
+{
+    SoupMessageHeaders *headers = soup_message_get_response_headers(message);
+    const gchar *etag;
+    const gchar *last_modified;
+    TreeCacheEntry *entry;
+
+    etag = soup_message_headers_get_one(headers, "ETag");
+    last_modified = soup_message_headers_get_one(headers, "Last-Modified");
+
+    /* Without any validator there's no way to revalidate the entry later */
+    if (etag == NULL && last_modified == NULL)
+        return;
+
+    entry = g_slice_new0(TreeCacheEntry);
+    entry->etag = g_strdup(etag);
+    entry->last_modified = g_strdup(last_modified);
+    entry->tree = tree_copy(tree);
+
+    G_LOCK(tree_cache);
+
+    if (tree_cache == NULL)
+        tree_cache = g_hash_table_new_full(g_str_hash,
+                                           g_str_equal,
+                                           g_free,
+                                           tree_cache_entry_free);
+    g_hash_table_replace(tree_cache, g_strdup(url), entry);
+
+    G_UNLOCK(tree_cache);
+}
+
+/**
+ * osinfo_tree_clear_cache:
+ *
+ * Drops all the trees cached by calls to
+ * #osinfo_tree_create_from_location_with_flags with the
+ * %OSINFO_TREE_DETECT_USE_CACHE flag set.
+ *
+ * Since: 1.13.0
+ */
+void osinfo_tree_clear_cache(void)
+{
+    G_LOCK(tree_cache);
+
+    if (tree_cache != NULL)
+        g_hash_table_remove_all(tree_cache);
+
+    G_UNLOCK(tree_cache);
+}
+
 static void
 osinfo_tree_create_from_location_async_helper(CreateFromLocationAsyncData *data,
                                               const gchar *treeinfo);
@@ -696,6 +883,9 @@ static void on_content_read(GObject *source,
         goto cleanup;
     }
 
+    if (data->flags & OSINFO_TREE_DETECT_USE_CACHE)
+        tree_cache_store(data->url, data->message, ret);
+
     g_task_return_pointer(data->res, ret, g_object_unref);
 
  cleanup:
@@ -710,12 +900,23 @@ static void on_soup_location_read(GObject *source,
     GError *error = NULL;
     GInputStream *stream;
     goffset content_size;
+    OsinfoTree *ret;
 
     data = (CreateFromLocationAsyncData *)user_data;
 
     stream = soup_session_send_finish(SOUP_SESSION(source),
                                       res,
                                       &error);
+    if (stream != NULL &&
+        (data->flags & OSINFO_TREE_DETECT_USE_CACHE) &&
+        soup_message_get_status(data->message) == SOUP_STATUS_NOT_MODIFIED &&
+        (ret = tree_cache_lookup(data->url)) != NULL) {
+        g_object_unref(stream);
+        g_task_return_pointer(data->res, ret, g_object_unref);
+        create_from_location_async_data_free(data);
+        return;
+    }
+
     if (stream == NULL ||
         !SOUP_STATUS_IS_SUCCESSFUL(soup_message_get_status(data->message))) {
         /* It means no ".treeinfo" file has been found. Try again, this time
@@ -822,6 +1023,9 @@ osinfo_tree_create_from_location_async_helper(CreateFromLocationAsyncData *data,
     g_free(data->treeinfo);
     data->treeinfo = g_strdup(treeinfo);
 
+    g_free(data->url);
+    data->url = g_strdup(location);
+
     if (requires_soup) {
         if (data->session == NULL)
             data->session = soup_session_new_with_options(
@@ -831,6 +1035,9 @@ osinfo_tree_create_from_location_async_helper(CreateFromLocationAsyncData *data,
         g_clear_object(&data->message);
         data->message = soup_message_new("GET", location);
 
+        if (data->flags & OSINFO_TREE_DETECT_USE_CACHE)
+            tree_cache_add_conditional_headers(data->message, location);
+
         soup_session_send_async(data->session,
                                 data->message,
 #if SOUP_MAJOR_VERSION > 2
@@ -868,6 +1075,53 @@ void osinfo_tree_create_from_location_async(const gchar *location,
                                             GCancellable *cancellable,
                                             GAsyncReadyCallback callback,
                                             gpointer user_data)
+{
+    osinfo_tree_create_from_location_with_flags_async(location,
+                                                      priority,
+                                                      cancellable,
+                                                      callback,
+                                                      0,
+                                                      user_data);
+}
+
+
+/**
+ * osinfo_tree_create_from_location_finish:
+ * @res: a #GAsyncResult
+ * @error: The location where to store any error, or %NULL
+ *
+ * Finishes an asynchronous tree object creation process started with
+ * #osinfo_tree_create_from_location_async.
+ *
+ * Returns: (transfer full): a new #OsinfoTree , or NULL on error
+ *
+ * Since: 0.1.0
+ */
+OsinfoTree *osinfo_tree_create_from_location_finish(GAsyncResult *res,
+                                                    GError **error)
+{
+    return osinfo_tree_create_from_location_with_flags_finish(res, error);
+}
+
+/**
+ * osinfo_tree_create_from_location_with_flags_async:
+ * @location: the location of an installation tree
+ * @priority: the I/O priority of the request
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @callback: Function to call when result of this call is ready
+ * @flags: An #OsinfoTreeDetectFlags, or 0.
+ * @user_data: The user data to pass to @callback, or %NULL
+ *
+ * Asynchronous variant of #osinfo_tree_create_from_location_with_flags.
+ *
+ * Since: 1.13.0
+ */
+void osinfo_tree_create_from_location_with_flags_async(const gchar *location,
+                                                       gint priority,
+                                                       GCancellable *cancellable,
+                                                       GAsyncReadyCallback callback,
+                                                       guint flags,
+                                                       gpointer user_data)
 {
     CreateFromLocationAsyncData *data;
 
@@ -877,27 +1131,27 @@ void osinfo_tree_create_from_location_async(const gchar *location,
                            callback,
                            user_data);
     g_task_set_priority(data->res, priority);
+    data->flags = flags;
 
     data->location = g_strdup(location);
 
     osinfo_tree_create_from_location_async_helper(data, ".treeinfo");
 }
 
-
 /**
- * osinfo_tree_create_from_location_finish:
+ * osinfo_tree_create_from_location_with_flags_finish:
  * @res: a #GAsyncResult
  * @error: The location where to store any error, or %NULL
  *
  * Finishes an asynchronous tree object creation process started with
- * #osinfo_tree_create_from_location_async.
+ * #osinfo_tree_create_from_location_with_flags_async.
  *
  * Returns: (transfer full): a new #OsinfoTree , or NULL on error
  *
- * Since: 0.1.0
+ * Since: 1.13.0
  */
-OsinfoTree *osinfo_tree_create_from_location_finish(GAsyncResult *res,
-                                                    GError **error)
+OsinfoTree *osinfo_tree_create_from_location_with_flags_finish(GAsyncResult *res,
+                                                               GError **error)
 {
     GTask *task = G_TASK(res);
 
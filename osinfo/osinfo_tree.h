@@ -46,6 +46,19 @@ typedef enum {
     OSINFO_TREE_ERROR_NOT_SUPPORTED_PROTOCOL
 } OsinfoTreeError;
 
+/**
+ * OsinfoTreeDetectFlags:
+ * @OSINFO_TREE_DETECT_USE_CACHE: Reuse a previously parsed tree when the
+ * remote treeinfo has not changed since it was last fetched.
+ *
+ * Flags used for detecting a tree.
+ *
+ * Since: 1.13.0
+ */
+typedef enum {
+    OSINFO_TREE_DETECT_USE_CACHE = 1 << 0,
+} OsinfoTreeDetectFlags;
+
 #define OSINFO_TYPE_TREE (osinfo_tree_get_type ())
 OSINFO_DECLARE_TYPE_WITH_PRIVATE_AND_CLASS(OsinfoTree,
                                            osinfo_tree,
@@ -76,6 +89,19 @@ void osinfo_tree_create_from_location_async(const gchar *location,
                                             gpointer user_data);
 OsinfoTree *osinfo_tree_create_from_location_finish(GAsyncResult *res,
                                                     GError **error);
+OsinfoTree *osinfo_tree_create_from_location_with_flags(const gchar *location,
+                                                        GCancellable *cancellable,
+                                                        guint flags,
+                                                        GError **error);
+void osinfo_tree_create_from_location_with_flags_async(const gchar *location,
+                                                       gint priority,
+                                                       GCancellable *cancellable,
+                                                       GAsyncReadyCallback callback,
+                                                       guint flags,
+                                                       gpointer user_data);
+OsinfoTree *osinfo_tree_create_from_location_with_flags_finish(GAsyncResult *res,
+                                                               GError **error);
+void osinfo_tree_clear_cache(void);
 
 OsinfoTree *osinfo_tree_create_from_treeinfo(const gchar *treeinfo,
                                              const gchar *location,
@@ -27,4 +27,5 @@ gboolean osinfo_util_requires_soup(const gchar *location);
 #if SOUP_MAJOR_VERSION < 3
 # define soup_message_get_status(message) message->status_code
 # define soup_message_get_response_headers(message) message->response_headers
+# define soup_message_get_request_headers(message) message->request_headers
 #endif
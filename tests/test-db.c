@@ -17,6 +17,40 @@
 
 #include <osinfo/osinfo.h>
 
+/* A filter looking entities up in the database while matching them */
+typedef struct _OsinfoLookupFilter        OsinfoLookupFilter;
+typedef struct _OsinfoLookupFilterClass   OsinfoLookupFilterClass;
+
+struct _OsinfoLookupFilter
+{
+    OsinfoFilter parent_instance;
+    OsinfoDb *db;
+};
+
+struct _OsinfoLookupFilterClass
+{
+    OsinfoFilterClass parent_class;
+};
+
+GType osinfo_lookup_filter_get_type(void);
+
+G_DEFINE_TYPE(OsinfoLookupFilter, osinfo_lookup_filter, OSINFO_TYPE_FILTER);
+
+static gboolean osinfo_lookup_filter_matches(OsinfoFilter *filter, OsinfoEntity *entity)
+{
+    OsinfoLookupFilter *lookup = (OsinfoLookupFilter *)filter;
+    const gchar *short_id = osinfo_product_get_short_id(OSINFO_PRODUCT(entity));
+
+    return short_id != NULL &&
+        osinfo_db_get_os_by_short_id(lookup->db, short_id) == OSINFO_OS(entity);
+}
+
+static void osinfo_lookup_filter_class_init(OsinfoLookupFilterClass *klass)
+{
+    OSINFO_FILTER_CLASS(klass)->matches = osinfo_lookup_filter_matches;
+}
+static void osinfo_lookup_filter_init(OsinfoLookupFilter *self G_GNUC_UNUSED) {}
+
 static void
 test_basic(void)
 {
@@ -59,6 +93,131 @@ test_device(void)
 }
 
 
+static void
+test_device_ids(void)
+{
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoDevice *dev1 = osinfo_device_new("dev1");
+    OsinfoDevice *dev2 = osinfo_device_new("dev2");
+    OsinfoDevice *dev3 = osinfo_device_new("dev3");
+
+    osinfo_entity_set_param(OSINFO_ENTITY(dev1), OSINFO_DEVICE_PROP_BUS_TYPE, "pci");
+    osinfo_entity_set_param(OSINFO_ENTITY(dev1), OSINFO_DEVICE_PROP_VENDOR_ID, "0x1af4");
+    osinfo_entity_set_param(OSINFO_ENTITY(dev1), OSINFO_DEVICE_PROP_PRODUCT_ID, "0x1000");
+    osinfo_entity_set_param(OSINFO_ENTITY(dev2), OSINFO_DEVICE_PROP_BUS_TYPE, "pci");
+    osinfo_entity_set_param(OSINFO_ENTITY(dev2), OSINFO_DEVICE_PROP_VENDOR_ID, "0x1af4");
+    osinfo_entity_set_param(OSINFO_ENTITY(dev2), OSINFO_DEVICE_PROP_PRODUCT_ID, "0x1001");
+    osinfo_entity_set_param(OSINFO_ENTITY(dev2), OSINFO_DEVICE_PROP_SUBSYSTEM, "block");
+    osinfo_entity_set_param(OSINFO_ENTITY(dev3), OSINFO_DEVICE_PROP_BUS_TYPE, "usb");
+    osinfo_entity_set_param(OSINFO_ENTITY(dev3), OSINFO_DEVICE_PROP_VENDOR_ID, "0x1af4");
+
+    osinfo_db_add_device(db, dev1);
+    osinfo_db_add_device(db, dev2);
+    osinfo_db_add_device(db, dev3);
+
+    g_assert_true(osinfo_db_find_device_by_ids(db, "pci", "0x1af4", "0x1000", NULL) == dev1);
+    g_assert_true(osinfo_db_find_device_by_ids(db, "pci", "0x1af4", "0x1001", NULL) == dev2);
+    g_assert_true(osinfo_db_find_device_by_ids(db, "pci", "0x1af4", "0x1001", "block") == dev2);
+    g_assert_null(osinfo_db_find_device_by_ids(db, "pci", "0x1af4", "0x1001", "net"));
+    g_assert_null(osinfo_db_find_device_by_ids(db, "pci", "0x1af4", "0x1000", "block"));
+    g_assert_null(osinfo_db_find_device_by_ids(db, "usb", "0x1af4", "0x1000", NULL));
+
+    /* Properties changed after the index was built */
+    osinfo_entity_set_param(OSINFO_ENTITY(dev3), OSINFO_DEVICE_PROP_PRODUCT_ID, "0x1000");
+    g_assert_true(osinfo_db_find_device_by_ids(db, "usb", "0x1af4", "0x1000", NULL) == dev3);
+
+    g_object_unref(dev1);
+    g_object_unref(dev2);
+    g_object_unref(dev3);
+    g_object_unref(db);
+}
+
+
+static void
+test_device_support(void)
+{
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoOs *os1 = osinfo_os_new("os1");
+    OsinfoOs *os2 = osinfo_os_new("os2");
+    OsinfoOs *os3 = osinfo_os_new("os3");
+    OsinfoPlatform *hv1 = osinfo_platform_new("hv1");
+    OsinfoPlatform *hv2 = osinfo_platform_new("hv2");
+    OsinfoDevice *dev1 = osinfo_device_new("dev1");
+    OsinfoDevice *dev2 = osinfo_device_new("dev2");
+    OsinfoDeviceLink *link;
+    OsinfoOsList *oses;
+    OsinfoPlatformList *platforms;
+
+    osinfo_db_add_os(db, os1);
+    osinfo_db_add_os(db, os2);
+    osinfo_db_add_os(db, os3);
+    osinfo_db_add_platform(db, hv1);
+    osinfo_db_add_platform(db, hv2);
+    osinfo_db_add_device(db, dev1);
+    osinfo_db_add_device(db, dev2);
+
+    /* os2 inherits dev1 and dev2 from os1, but does not support dev2 */
+    osinfo_os_add_device(os1, dev1);
+    osinfo_os_add_device(os1, dev2);
+    osinfo_product_add_related(OSINFO_PRODUCT(os2),
+                               OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM,
+                               OSINFO_PRODUCT(os1));
+    link = osinfo_os_add_device(os2, dev2);
+    osinfo_entity_set_param_boolean(OSINFO_ENTITY(link),
+                                    OSINFO_DEVICELINK_PROP_SUPPORTED, FALSE);
+    osinfo_platform_add_device(hv1, dev1);
+
+    oses = osinfo_db_get_oses_for_device(db, dev1, TRUE);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(oses)), ==, 2);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 0) == OSINFO_ENTITY(os1));
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 1) == OSINFO_ENTITY(os2));
+    g_object_unref(oses);
+
+    oses = osinfo_db_get_oses_for_device(db, dev2, TRUE);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(oses)), ==, 1);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 0) == OSINFO_ENTITY(os1));
+    g_object_unref(oses);
+
+    oses = osinfo_db_get_oses_for_device(db, dev2, FALSE);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(oses)), ==, 1);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 0) == OSINFO_ENTITY(os2));
+    g_object_unref(oses);
+
+    oses = osinfo_db_get_oses_for_device(db, dev1, FALSE);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(oses)), ==, 0);
+    g_object_unref(oses);
+
+    platforms = osinfo_db_get_platforms_for_device(db, dev1);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(platforms)), ==, 1);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(platforms), 0) == OSINFO_ENTITY(hv1));
+    g_object_unref(platforms);
+
+    /* Links added after the index was built */
+    osinfo_os_add_device(os3, dev2);
+    osinfo_product_add_related(OSINFO_PRODUCT(hv2),
+                               OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM,
+                               OSINFO_PRODUCT(hv1));
+
+    oses = osinfo_db_get_oses_for_device(db, dev2, TRUE);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(oses)), ==, 2);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 1) == OSINFO_ENTITY(os3));
+    g_object_unref(oses);
+
+    platforms = osinfo_db_get_platforms_for_device(db, dev1);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(platforms)), ==, 2);
+    g_object_unref(platforms);
+
+    g_object_unref(dev1);
+    g_object_unref(dev2);
+    g_object_unref(hv1);
+    g_object_unref(hv2);
+    g_object_unref(os1);
+    g_object_unref(os2);
+    g_object_unref(os3);
+    g_object_unref(db);
+}
+
+
 static void
 test_platform(void)
 {
@@ -121,6 +280,363 @@ test_os(void)
 }
 
 
+static void
+test_os_short_id(void)
+{
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoOs *os1 = osinfo_os_new("os1");
+    OsinfoOs *os2 = osinfo_os_new("os2");
+    OsinfoOs *os3 = osinfo_os_new("os3");
+
+    osinfo_entity_add_param(OSINFO_ENTITY(os1), OSINFO_PRODUCT_PROP_SHORT_ID, "short1");
+    osinfo_entity_add_param(OSINFO_ENTITY(os2), OSINFO_PRODUCT_PROP_SHORT_ID, "short2");
+    osinfo_entity_add_param(OSINFO_ENTITY(os2), OSINFO_PRODUCT_PROP_SHORT_ID, "short2b");
+    osinfo_entity_add_param(OSINFO_ENTITY(os3), OSINFO_PRODUCT_PROP_SHORT_ID, "short2b");
+
+    osinfo_db_add_os(db, os1);
+    osinfo_db_add_os(db, os2);
+
+    g_assert_true(osinfo_db_get_os_by_short_id(db, "short1") == os1);
+    g_assert_true(osinfo_db_get_os_by_short_id(db, "short2") == os2);
+    g_assert_true(osinfo_db_get_os_by_short_id(db, "short2b") == os2);
+    g_assert_null(osinfo_db_get_os_by_short_id(db, "short3"));
+
+    /* Added after the index was built, as the loader does */
+    osinfo_db_add_os(db, os3);
+    osinfo_entity_add_param(OSINFO_ENTITY(os3), OSINFO_PRODUCT_PROP_SHORT_ID, "short3");
+    g_assert_true(osinfo_db_get_os_by_short_id(db, "short3") == os3);
+    g_assert_true(osinfo_db_get_os_by_short_id(db, "short2b") == os2);
+
+    /* Properties changed after the index was built */
+    osinfo_entity_set_param(OSINFO_ENTITY(os2), OSINFO_PRODUCT_PROP_SHORT_ID, "short4");
+    g_assert_true(osinfo_db_get_os_by_short_id(db, "short4") == os2);
+    g_assert_true(osinfo_db_get_os_by_short_id(db, "short2b") == os3);
+    g_assert_null(osinfo_db_get_os_by_short_id(db, "short2"));
+
+    /* An earlier entity gaining the key of a later one wins the lookup */
+    g_assert_true(osinfo_db_get_os_by_short_id(db, "short3") == os3);
+    osinfo_entity_add_param(OSINFO_ENTITY(os1), OSINFO_PRODUCT_PROP_SHORT_ID, "short3");
+    g_assert_true(osinfo_db_get_os_by_short_id(db, "short3") == os1);
+
+    g_object_unref(os1);
+    g_object_unref(os2);
+    g_object_unref(os3);
+    g_object_unref(db);
+}
+
+
+
+static void
+test_os_support_dates(void)
+{
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoOs *os1 = osinfo_os_new("os1");
+    OsinfoOs *os2 = osinfo_os_new("os2");
+    OsinfoOs *os3 = osinfo_os_new("os3");
+    OsinfoOs *os4 = osinfo_os_new("os4");
+    GDate *date = g_date_new_dmy(1, G_DATE_JANUARY, 2015);
+    GDate *start = g_date_new_dmy(1, G_DATE_JANUARY, 2010);
+    GDate *end = g_date_new_dmy(31, G_DATE_DECEMBER, 2020);
+    OsinfoOsList *oses;
+
+    osinfo_db_add_os(db, os1);
+    osinfo_db_add_os(db, os2);
+    osinfo_db_add_os(db, os3);
+    osinfo_db_add_os(db, os4);
+
+    /* os4 has neither a release nor an EOL date */
+    osinfo_entity_set_param(OSINFO_ENTITY(os1), OSINFO_PRODUCT_PROP_RELEASE_DATE, "2005-06-01");
+    osinfo_entity_set_param(OSINFO_ENTITY(os1), OSINFO_PRODUCT_PROP_EOL_DATE, "2012-06-01");
+    osinfo_entity_set_param(OSINFO_ENTITY(os2), OSINFO_PRODUCT_PROP_RELEASE_DATE, "2010-06-01");
+    osinfo_entity_set_param(OSINFO_ENTITY(os2), OSINFO_PRODUCT_PROP_EOL_DATE, "2020-06-01");
+    osinfo_entity_set_param(OSINFO_ENTITY(os3), OSINFO_PRODUCT_PROP_RELEASE_DATE, "2015-01-01");
+
+    oses = osinfo_db_get_oses_supported_on(db, date);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(oses)), ==, 3);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 0) == OSINFO_ENTITY(os2));
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 1) == OSINFO_ENTITY(os3));
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 2) == OSINFO_ENTITY(os4));
+    g_object_unref(oses);
+
+    /* Sorted by EOL date */
+    oses = osinfo_db_get_oses_eol_between(db, start, end);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(oses)), ==, 2);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 0) == OSINFO_ENTITY(os1));
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 1) == OSINFO_ENTITY(os2));
+    g_object_unref(oses);
+
+    /* Dates changed after the index was built */
+    osinfo_entity_set_param(OSINFO_ENTITY(os2), OSINFO_PRODUCT_PROP_EOL_DATE, "2014-12-31");
+    osinfo_entity_set_param(OSINFO_ENTITY(os4), OSINFO_PRODUCT_PROP_EOL_DATE, "2015-01-01");
+
+    oses = osinfo_db_get_oses_supported_on(db, date);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(oses)), ==, 2);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 0) == OSINFO_ENTITY(os3));
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 1) == OSINFO_ENTITY(os4));
+    g_object_unref(oses);
+
+    g_date_set_dmy(end, 31, G_DATE_DECEMBER, 2014);
+    oses = osinfo_db_get_oses_eol_between(db, start, end);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(oses)), ==, 2);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 0) == OSINFO_ENTITY(os1));
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 1) == OSINFO_ENTITY(os2));
+    g_object_unref(oses);
+
+    g_date_free(date);
+    g_date_free(start);
+    g_date_free(end);
+    g_object_unref(os1);
+    g_object_unref(os2);
+    g_object_unref(os3);
+    g_object_unref(os4);
+    g_object_unref(db);
+}
+
+
+
+static void
+test_deployment(void)
+{
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoOs *os1 = osinfo_os_new("os1");
+    OsinfoOs *os2 = osinfo_os_new("os2");
+    OsinfoPlatform *hv1 = osinfo_platform_new("hv1");
+    OsinfoPlatform *hv2 = osinfo_platform_new("hv2");
+    OsinfoDeployment *dep1 = osinfo_deployment_new("dep1", os1, hv1);
+    OsinfoDeployment *dep2 = osinfo_deployment_new("dep2", os1, hv2);
+    OsinfoDeployment *dep3 = osinfo_deployment_new("dep3", os2, hv1);
+    OsinfoDeployment *dep4 = osinfo_deployment_new("dep2", os2, hv2);
+
+    osinfo_db_add_deployment(db, dep1);
+    osinfo_db_add_deployment(db, dep2);
+    osinfo_db_add_deployment(db, dep3);
+
+    g_assert_true(osinfo_db_find_deployment(db, os1, hv1) == dep1);
+    g_assert_true(osinfo_db_find_deployment(db, os1, hv2) == dep2);
+    g_assert_true(osinfo_db_find_deployment(db, os2, hv1) == dep3);
+    g_assert_null(osinfo_db_find_deployment(db, os2, hv2));
+
+    /* Replacing a deployment drops it from the lookup */
+    osinfo_db_add_deployment(db, dep4);
+    g_assert_null(osinfo_db_find_deployment(db, os1, hv2));
+    g_assert_true(osinfo_db_find_deployment(db, os2, hv2) == dep4);
+    g_assert_true(osinfo_db_find_deployment(db, os1, hv1) == dep1);
+
+    g_object_unref(dep1);
+    g_object_unref(dep2);
+    g_object_unref(dep3);
+    g_object_unref(dep4);
+    g_object_unref(hv1);
+    g_object_unref(hv2);
+    g_object_unref(os1);
+    g_object_unref(os2);
+    g_object_unref(db);
+}
+
+
+static void
+test_filtered_list(void)
+{
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoOs *os1 = osinfo_os_new("os1");
+    OsinfoOs *os2 = osinfo_os_new("os2");
+    OsinfoOs *os3 = osinfo_os_new("os3");
+    OsinfoOs *os4 = osinfo_os_new("os4");
+    OsinfoFilter *filter = osinfo_filter_new();
+    OsinfoOsList *oses;
+    OsinfoList *filtered;
+
+    osinfo_entity_add_param(OSINFO_ENTITY(os1), OSINFO_OS_PROP_FAMILY, "linux");
+    osinfo_entity_add_param(OSINFO_ENTITY(os1), OSINFO_OS_PROP_DISTRO, "fedora");
+    osinfo_entity_add_param(OSINFO_ENTITY(os2), OSINFO_OS_PROP_FAMILY, "linux");
+    osinfo_entity_add_param(OSINFO_ENTITY(os2), OSINFO_OS_PROP_DISTRO, "debian");
+    osinfo_entity_add_param(OSINFO_ENTITY(os3), OSINFO_OS_PROP_FAMILY, "winnt");
+    osinfo_entity_add_param(OSINFO_ENTITY(os3), OSINFO_OS_PROP_FAMILY, "linux");
+    osinfo_entity_add_param(OSINFO_ENTITY(os3), OSINFO_OS_PROP_DISTRO, "fedora");
+
+    osinfo_db_add_os(db, os1);
+    osinfo_db_add_os(db, os2);
+    osinfo_db_add_os(db, os3);
+
+    osinfo_filter_add_constraint(filter, OSINFO_OS_PROP_FAMILY, "linux");
+    osinfo_filter_add_constraint(filter, OSINFO_OS_PROP_DISTRO, "fedora");
+
+    oses = osinfo_db_get_os_list(db);
+    filtered = osinfo_list_new_filtered(OSINFO_LIST(oses), filter);
+    g_assert_cmpint(osinfo_list_get_length(filtered), ==, 2);
+    g_assert_true(osinfo_list_get_nth(filtered, 0) == OSINFO_ENTITY(os1));
+    g_assert_true(osinfo_list_get_nth(filtered, 1) == OSINFO_ENTITY(os3));
+    g_object_unref(filtered);
+
+    /* Properties changed after the index was built */
+    osinfo_entity_set_param(OSINFO_ENTITY(os2), OSINFO_OS_PROP_DISTRO, "fedora");
+    osinfo_entity_set_param(OSINFO_ENTITY(os1), OSINFO_OS_PROP_FAMILY, "bsd");
+    filtered = osinfo_list_new_filtered(OSINFO_LIST(oses), filter);
+    g_assert_cmpint(osinfo_list_get_length(filtered), ==, 2);
+    g_assert_true(osinfo_list_get_nth(filtered, 0) == OSINFO_ENTITY(os2));
+    g_assert_true(osinfo_list_get_nth(filtered, 1) == OSINFO_ENTITY(os3));
+    g_object_unref(filtered);
+
+    /* The list does not gain entities added to the database later */
+    osinfo_entity_add_param(OSINFO_ENTITY(os4), OSINFO_OS_PROP_FAMILY, "linux");
+    osinfo_entity_add_param(OSINFO_ENTITY(os4), OSINFO_OS_PROP_DISTRO, "fedora");
+    osinfo_db_add_os(db, os4);
+    filtered = osinfo_list_new_filtered(OSINFO_LIST(oses), filter);
+    g_assert_cmpint(osinfo_list_get_length(filtered), ==, 2);
+    g_object_unref(filtered);
+    g_object_unref(oses);
+
+    osinfo_filter_add_constraint(filter, OSINFO_OS_PROP_FAMILY, "winnt");
+    oses = osinfo_db_get_os_list(db);
+    filtered = osinfo_list_new_filtered(OSINFO_LIST(oses), filter);
+    g_assert_cmpint(osinfo_list_get_length(filtered), ==, 1);
+    g_assert_true(osinfo_list_get_nth(filtered, 0) == OSINFO_ENTITY(os3));
+    g_object_unref(filtered);
+
+    osinfo_filter_clear_constraints(filter);
+    osinfo_filter_add_constraint(filter, OSINFO_OS_PROP_DISTRO, "suse");
+    filtered = osinfo_list_new_filtered(OSINFO_LIST(oses), filter);
+    g_assert_cmpint(osinfo_list_get_length(filtered), ==, 0);
+    g_object_unref(filtered);
+    g_object_unref(oses);
+
+    g_object_unref(filter);
+    g_object_unref(os1);
+    g_object_unref(os2);
+    g_object_unref(os3);
+    g_object_unref(os4);
+    g_object_unref(db);
+}
+
+
+static void
+test_expression_filtered_list(void)
+{
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoOs *os1 = osinfo_os_new("os1");
+    OsinfoOs *os2 = osinfo_os_new("os2");
+    OsinfoOs *os3 = osinfo_os_new("os3");
+    OsinfoOs *os4 = osinfo_os_new("os4");
+    OsinfoExpressionFilter *filter;
+    OsinfoOsList *oses;
+    OsinfoList *filtered;
+    GError *error = NULL;
+
+    osinfo_entity_add_param(OSINFO_ENTITY(os1), OSINFO_OS_PROP_DISTRO, "fedora");
+    osinfo_entity_add_param(OSINFO_ENTITY(os1), OSINFO_PRODUCT_PROP_VERSION, "9");
+    osinfo_entity_add_param(OSINFO_ENTITY(os2), OSINFO_OS_PROP_DISTRO, "debian");
+    osinfo_entity_add_param(OSINFO_ENTITY(os2), OSINFO_PRODUCT_PROP_VERSION, "10");
+    osinfo_entity_add_param(OSINFO_ENTITY(os3), OSINFO_OS_PROP_DISTRO, "fedora");
+    osinfo_entity_add_param(OSINFO_ENTITY(os3), OSINFO_PRODUCT_PROP_VERSION, "31");
+    osinfo_entity_add_param(OSINFO_ENTITY(os4), OSINFO_OS_PROP_DISTRO, "rhel");
+
+    osinfo_db_add_os(db, os1);
+    osinfo_db_add_os(db, os2);
+    osinfo_db_add_os(db, os3);
+    osinfo_db_add_os(db, os4);
+    oses = osinfo_db_get_os_list(db);
+
+    filter = osinfo_expressionfilter_new_from_string("distro=fedora and version>=10", &error);
+    g_assert_no_error(error);
+    filtered = osinfo_list_new_filtered(OSINFO_LIST(oses), OSINFO_FILTER(filter));
+    g_assert_cmpint(osinfo_list_get_length(filtered), ==, 1);
+    g_assert_true(osinfo_list_get_nth(filtered, 0) == OSINFO_ENTITY(os3));
+    g_object_unref(filtered);
+    g_object_unref(filter);
+
+    /* Unions keep the list order */
+    filter = osinfo_expressionfilter_new_from_string("distro^=rh or version<10", &error);
+    g_assert_no_error(error);
+    filtered = osinfo_list_new_filtered(OSINFO_LIST(oses), OSINFO_FILTER(filter));
+    g_assert_cmpint(osinfo_list_get_length(filtered), ==, 2);
+    g_assert_true(osinfo_list_get_nth(filtered, 0) == OSINFO_ENTITY(os1));
+    g_assert_true(osinfo_list_get_nth(filtered, 1) == OSINFO_ENTITY(os4));
+    g_object_unref(filtered);
+
+    /* Properties changed after the index was built */
+    osinfo_entity_set_param(OSINFO_ENTITY(os2), OSINFO_OS_PROP_DISTRO, "rhel");
+    osinfo_entity_set_param(OSINFO_ENTITY(os1), OSINFO_PRODUCT_PROP_VERSION, "29");
+    filtered = osinfo_list_new_filtered(OSINFO_LIST(oses), OSINFO_FILTER(filter));
+    g_assert_cmpint(osinfo_list_get_length(filtered), ==, 2);
+    g_assert_true(osinfo_list_get_nth(filtered, 0) == OSINFO_ENTITY(os2));
+    g_assert_true(osinfo_list_get_nth(filtered, 1) == OSINFO_ENTITY(os4));
+    g_object_unref(filtered);
+    g_object_unref(filter);
+
+    /* Negations cannot use the indexes */
+    filter = osinfo_expressionfilter_new_from_string("not distro=rhel", &error);
+    g_assert_no_error(error);
+    filtered = osinfo_list_new_filtered(OSINFO_LIST(oses), OSINFO_FILTER(filter));
+    g_assert_cmpint(osinfo_list_get_length(filtered), ==, 2);
+    g_assert_true(osinfo_list_get_nth(filtered, 0) == OSINFO_ENTITY(os1));
+    g_assert_true(osinfo_list_get_nth(filtered, 1) == OSINFO_ENTITY(os3));
+    g_object_unref(filtered);
+    g_object_unref(filter);
+
+    g_object_unref(oses);
+    g_object_unref(os1);
+    g_object_unref(os2);
+    g_object_unref(os3);
+    g_object_unref(os4);
+    g_object_unref(db);
+}
+
+
+static void
+test_filtered_list_callback(void)
+{
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoOs *os1 = osinfo_os_new("os1");
+    OsinfoOs *os2 = osinfo_os_new("os2");
+    OsinfoOs *os3 = osinfo_os_new("os3");
+    OsinfoLookupFilter *lookup;
+    OsinfoExpressionFilter *distro;
+    OsinfoExpressionFilter *filter;
+    OsinfoOsList *oses;
+    OsinfoList *filtered;
+    GError *error = NULL;
+
+    osinfo_entity_add_param(OSINFO_ENTITY(os1), OSINFO_OS_PROP_DISTRO, "fedora");
+    osinfo_entity_add_param(OSINFO_ENTITY(os1), OSINFO_PRODUCT_PROP_SHORT_ID, "fedora1");
+    osinfo_entity_add_param(OSINFO_ENTITY(os2), OSINFO_OS_PROP_DISTRO, "fedora");
+    osinfo_entity_add_param(OSINFO_ENTITY(os3), OSINFO_OS_PROP_DISTRO, "debian");
+    osinfo_entity_add_param(OSINFO_ENTITY(os3), OSINFO_PRODUCT_PROP_SHORT_ID, "debian3");
+
+    osinfo_db_add_os(db, os1);
+    osinfo_db_add_os(db, os2);
+    osinfo_db_add_os(db, os3);
+
+    /* The planned operand narrows the entities the lookup filter sees */
+    lookup = g_object_new(osinfo_lookup_filter_get_type(), NULL);
+    lookup->db = db;
+    distro = osinfo_expressionfilter_new_from_string("distro=fedora", &error);
+    g_assert_no_error(error);
+    filter = osinfo_expressionfilter_new_and(OSINFO_FILTER(distro),
+                                             OSINFO_FILTER(lookup));
+
+    oses = osinfo_db_get_os_list(db);
+    filtered = osinfo_list_new_filtered(OSINFO_LIST(oses), OSINFO_FILTER(filter));
+    g_assert_cmpint(osinfo_list_get_length(filtered), ==, 1);
+    g_assert_true(osinfo_list_get_nth(filtered, 0) == OSINFO_ENTITY(os1));
+    g_object_unref(filtered);
+
+    /* Filtering a list into itself */
+    osinfo_list_add_filtered(OSINFO_LIST(oses), OSINFO_LIST(oses), OSINFO_FILTER(distro));
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(oses)), ==, 3);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 0) == OSINFO_ENTITY(os3));
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 1) == OSINFO_ENTITY(os1));
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(oses), 2) == OSINFO_ENTITY(os2));
+    g_object_unref(oses);
+
+    g_object_unref(filter);
+    g_object_unref(distro);
+    g_object_unref(lookup);
+    g_object_unref(os1);
+    g_object_unref(os2);
+    g_object_unref(os3);
+    g_object_unref(db);
+}
+
 
 static void
 test_prop_device(void)
@@ -173,6 +689,19 @@ test_prop_device(void)
     g_assert_true(hasDisplay);
     g_assert_false(hasBad);
 
+    /* Values are sorted */
+    g_assert_cmpstr(g_list_nth_data(uniq, 0), ==, "audio");
+    g_assert_cmpstr(g_list_nth_data(uniq, 1), ==, "display");
+    g_assert_cmpstr(g_list_nth_data(uniq, 2), ==, "input");
+    g_assert_cmpstr(g_list_nth_data(uniq, 3), ==, "network");
+
+    g_list_free(uniq);
+
+    /* Cached values follow changes to the devices */
+    osinfo_entity_set_param(OSINFO_ENTITY(dev2), "class", "storage");
+    uniq = osinfo_db_unique_values_for_property_in_device(db, "class");
+    g_assert_cmpint(g_list_length(uniq), ==, 4);
+    g_assert_cmpstr(g_list_nth_data(uniq, 3), ==, "storage");
     g_list_free(uniq);
 
     g_object_unref(dev1);
@@ -303,6 +832,7 @@ test_rel_os(void)
     OsinfoOs *os4 = osinfo_os_new("os4");
     OsinfoOs *os5 = osinfo_os_new("os5");
     OsinfoOsList *sublist;
+    OsinfoProductList *related;
     gboolean hasOs1;
     gboolean hasOs2;
     gboolean hasOs3;
@@ -352,6 +882,16 @@ test_rel_os(void)
     g_assert_false(hasOs5);
     g_assert_false(hasBad);
 
+    /* Targets come in the order the database's OSes refer to them */
+    related = osinfo_product_get_related(OSINFO_PRODUCT(os1),
+                                         OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(sublist)), ==, 2);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(sublist), 0) ==
+                  osinfo_list_get_nth(OSINFO_LIST(related), 0));
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(sublist), 1) ==
+                  osinfo_list_get_nth(OSINFO_LIST(related), 1));
+    g_object_unref(related);
+
     g_object_unref(sublist);
 
     sublist = osinfo_db_unique_values_for_os_relationship(db, OSINFO_PRODUCT_RELATIONSHIP_UPGRADES);
@@ -421,6 +961,60 @@ test_rel_os(void)
 
 
 
+static void
+test_related_to(void)
+{
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoOs *os1 = osinfo_os_new("os1");
+    OsinfoOs *os2 = osinfo_os_new("os2");
+    OsinfoOs *os3 = osinfo_os_new("os3");
+    OsinfoPlatform *hv1 = osinfo_platform_new("hv1");
+    OsinfoPlatform *hv2 = osinfo_platform_new("hv2");
+    OsinfoProductList *related;
+
+    osinfo_db_add_os(db, os1);
+    osinfo_db_add_os(db, os2);
+    osinfo_db_add_os(db, os3);
+    osinfo_db_add_platform(db, hv1);
+    osinfo_db_add_platform(db, hv2);
+
+    osinfo_product_add_related(OSINFO_PRODUCT(os2), OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM, OSINFO_PRODUCT(os1));
+    osinfo_product_add_related(OSINFO_PRODUCT(os3), OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM, OSINFO_PRODUCT(os1));
+    osinfo_product_add_related(OSINFO_PRODUCT(os3), OSINFO_PRODUCT_RELATIONSHIP_UPGRADES, OSINFO_PRODUCT(os2));
+    osinfo_product_add_related(OSINFO_PRODUCT(hv2), OSINFO_PRODUCT_RELATIONSHIP_UPGRADES, OSINFO_PRODUCT(hv1));
+
+    related = osinfo_db_get_related_to(db, OSINFO_PRODUCT(os1), OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(related)), ==, 2);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(related), 0) == OSINFO_ENTITY(os2));
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(related), 1) == OSINFO_ENTITY(os3));
+    g_object_unref(related);
+
+    related = osinfo_db_get_related_to(db, OSINFO_PRODUCT(os1), OSINFO_PRODUCT_RELATIONSHIP_UPGRADES);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(related)), ==, 0);
+    g_object_unref(related);
+
+    related = osinfo_db_get_related_to(db, OSINFO_PRODUCT(hv1), OSINFO_PRODUCT_RELATIONSHIP_UPGRADES);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(related)), ==, 1);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(related), 0) == OSINFO_ENTITY(hv2));
+    g_object_unref(related);
+
+    /* Relationships added after the index was built */
+    osinfo_product_add_related(OSINFO_PRODUCT(os1), OSINFO_PRODUCT_RELATIONSHIP_UPGRADES, OSINFO_PRODUCT(os2));
+    related = osinfo_db_get_related_to(db, OSINFO_PRODUCT(os2), OSINFO_PRODUCT_RELATIONSHIP_UPGRADES);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(related)), ==, 2);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(related), 0) == OSINFO_ENTITY(os1));
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(related), 1) == OSINFO_ENTITY(os3));
+    g_object_unref(related);
+
+    g_object_unref(hv1);
+    g_object_unref(hv2);
+    g_object_unref(os1);
+    g_object_unref(os2);
+    g_object_unref(os3);
+    g_object_unref(db);
+}
+
+
 static void
 test_identify_media(void)
 {
@@ -894,12 +1488,21 @@ main(int argc, char *argv[])
 
     g_test_add_func("/db/basic", test_basic);
     g_test_add_func("/db/device", test_device);
+    g_test_add_func("/db/device_ids", test_device_ids);
+    g_test_add_func("/db/device_support", test_device_support);
     g_test_add_func("/db/platform", test_platform);
     g_test_add_func("/db/os", test_os);
+    g_test_add_func("/db/os_short_id", test_os_short_id);
+    g_test_add_func("/db/os_support_dates", test_os_support_dates);
+    g_test_add_func("/db/deployment", test_deployment);
+    g_test_add_func("/db/filtered_list", test_filtered_list);
+    g_test_add_func("/db/expression_filtered_list", test_expression_filtered_list);
+    g_test_add_func("/db/filtered_list_callback", test_filtered_list_callback);
     g_test_add_func("/db/prop_device", test_prop_device);
     g_test_add_func("/db/prop_platform", test_prop_platform);
     g_test_add_func("/db/prop_os", test_prop_os);
     g_test_add_func("/db/rel_os", test_rel_os);
+    g_test_add_func("/db/related_to", test_related_to);
     g_test_add_func("/db/identify_media", test_identify_media);
     g_test_add_func("/db/identify_all_media", test_identify_all_media);
     g_test_add_func("/db/identify_tree", test_identify_tree);
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2009-2020 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <osinfo/osinfo.h>
+
+
+static gboolean
+expression_matches(const gchar *expression, OsinfoEntity *entity)
+{
+    GError *error = NULL;
+    OsinfoExpressionFilter *filter;
+    gboolean ret;
+
+    filter = osinfo_expressionfilter_new_from_string(expression, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(filter);
+
+    ret = osinfo_filter_matches(OSINFO_FILTER(filter), entity);
+    g_object_unref(filter);
+
+    return ret;
+}
+
+
+static void
+test_compare(void)
+{
+    OsinfoOs *os = osinfo_os_new("http://fedoraproject.org/fedora/31");
+    OsinfoEntity *entity = OSINFO_ENTITY(os);
+
+    osinfo_entity_add_param(entity, OSINFO_PRODUCT_PROP_SHORT_ID, "fedora31");
+    osinfo_entity_add_param(entity, OSINFO_PRODUCT_PROP_VENDOR, "Fedora Project");
+    osinfo_entity_add_param(entity, OSINFO_PRODUCT_PROP_VERSION, "31");
+    osinfo_entity_add_param(entity, OSINFO_PRODUCT_PROP_RELEASE_DATE, "2019-10-29");
+    osinfo_entity_add_param(entity, OSINFO_OS_PROP_FAMILY, "linux");
+    osinfo_entity_add_param(entity, OSINFO_OS_PROP_DISTRO, "fedora");
+
+    g_assert_true(expression_matches("short-id=fedora31", entity));
+    g_assert_false(expression_matches("short-id=fedora3", entity));
+    g_assert_true(expression_matches("vendor=\"Fedora Project\"", entity));
+    g_assert_true(expression_matches("vendor='Fedora Project'", entity));
+    g_assert_true(expression_matches("short-id!=fedora30", entity));
+    g_assert_true(expression_matches("short-id^=fedora", entity));
+    g_assert_false(expression_matches("short-id^=rhel", entity));
+    g_assert_true(expression_matches("short-id~'^fedora[0-9]+$'", entity));
+    g_assert_true(expression_matches("id^=http://fedoraproject.org/", entity));
+
+    /* Digit runs compare numerically */
+    g_assert_true(expression_matches("version>9", entity));
+    g_assert_true(expression_matches("version>=31", entity));
+    g_assert_false(expression_matches("version<31", entity));
+    g_assert_true(expression_matches("version<=31.0", entity));
+    g_assert_true(expression_matches("release-date<2019-11-01", entity));
+    g_assert_false(expression_matches("release-date>=2020-01-01", entity));
+    g_assert_true(expression_matches("distro=fedora&&version>=30", entity));
+    g_assert_false(expression_matches("distro=fedora&&version>=32", entity));
+    g_assert_true(expression_matches("distro=rhel||release-date<2020-01-01", entity));
+
+    /* A missing property matches no condition */
+    g_assert_false(expression_matches("codename=Foo", entity));
+    g_assert_true(expression_matches("codename!=Foo", entity));
+
+    g_object_unref(os);
+}
+
+
+static void
+test_combine(void)
+{
+    OsinfoOs *os = osinfo_os_new("os1");
+    OsinfoEntity *entity = OSINFO_ENTITY(os);
+    OsinfoFilter *filter = osinfo_filter_new();
+    OsinfoExpressionFilter *version;
+    OsinfoExpressionFilter *combined;
+    OsinfoExpressionFilter *negated;
+
+    osinfo_entity_add_param(entity, OSINFO_OS_PROP_FAMILY, "linux");
+    osinfo_entity_add_param(entity, OSINFO_OS_PROP_FAMILY, "unix");
+    osinfo_entity_add_param(entity, OSINFO_PRODUCT_PROP_VERSION, "8.2");
+
+    g_assert_true(expression_matches("family=unix and version>8", entity));
+    g_assert_false(expression_matches("family=unix && version>8.2", entity));
+    g_assert_true(expression_matches("family=winnt or version=8.2", entity));
+    g_assert_true(expression_matches("not family=winnt", entity));
+    /* "!=" holds only if no value equals the operand */
+    g_assert_false(expression_matches("family!=linux", entity));
+    g_assert_true(expression_matches("family!=winnt", entity));
+    g_assert_false(expression_matches("!(family=linux || family=winnt)", entity));
+    /* AND binds tighter than OR */
+    g_assert_true(expression_matches("family=winnt and version=1 or version=8.2", entity));
+    g_assert_false(expression_matches("family=winnt and (version=1 or version=8.2)", entity));
+
+    /* Operators end unquoted values, so spaces around them are optional */
+    g_assert_true(expression_matches("family=unix&&version>=8", entity));
+    g_assert_false(expression_matches("family=unix&&version>8.2", entity));
+    g_assert_true(expression_matches("family=winnt||version=8.2", entity));
+    g_assert_true(expression_matches("family=winnt||!family=winnt", entity));
+    g_assert_false(expression_matches("!(family=linux||family=winnt)", entity));
+    g_assert_true(expression_matches("family='a&&b'||version<=8.2", entity));
+
+    /* Any filter can be an operand */
+    osinfo_filter_add_constraint(filter, OSINFO_OS_PROP_FAMILY, "linux");
+    version = osinfo_expressionfilter_new_compare(OSINFO_PRODUCT_PROP_VERSION,
+                                                  OSINFO_EXPRESSION_FILTER_OPERATOR_GREATER_EQUAL,
+                                                  "8.10", NULL);
+    combined = osinfo_expressionfilter_new_or(filter, OSINFO_FILTER(version));
+    g_assert_true(osinfo_filter_matches(OSINFO_FILTER(combined), entity));
+    g_object_unref(combined);
+
+    combined = osinfo_expressionfilter_new_and(filter, OSINFO_FILTER(version));
+    g_assert_false(osinfo_filter_matches(OSINFO_FILTER(combined), entity));
+
+    /* Constraints of the expression filter itself must match too */
+    negated = osinfo_expressionfilter_new_not(OSINFO_FILTER(combined));
+    g_assert_true(osinfo_filter_matches(OSINFO_FILTER(negated), entity));
+    osinfo_filter_add_constraint(OSINFO_FILTER(negated), OSINFO_OS_PROP_FAMILY, "winnt");
+    g_assert_false(osinfo_filter_matches(OSINFO_FILTER(negated), entity));
+
+    g_object_unref(negated);
+    g_object_unref(version);
+    g_object_unref(combined);
+    g_object_unref(filter);
+    g_object_unref(os);
+}
+
+
+static void
+test_parse_error(void)
+{
+    const gchar *invalid[] = {
+        "",
+        "family",
+        "family=",
+        "=linux",
+        "family=linux and",
+        "(family=linux",
+        "family=linux)",
+        "family='linux",
+        "family~'('",
+        "family=a=b",
+        "family=linux&",
+        "family=linux|version=1",
+    };
+    gsize i;
+
+    for (i = 0; i < G_N_ELEMENTS(invalid); i++) {
+        GError *error = NULL;
+        OsinfoExpressionFilter *filter;
+
+        filter = osinfo_expressionfilter_new_from_string(invalid[i], &error);
+        g_assert_null(filter);
+        g_assert_nonnull(error);
+        g_clear_error(&error);
+    }
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/expressionfilter/compare", test_compare);
+    g_test_add_func("/expressionfilter/combine", test_combine);
+    g_test_add_func("/expressionfilter/parse_error", test_parse_error);
+
+    /* Upfront so we don't confuse valgrind */
+    osinfo_os_get_type();
+    osinfo_filter_get_type();
+    osinfo_expressionfilter_get_type();
+
+    return g_test_run();
+}
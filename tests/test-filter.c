@@ -147,6 +147,49 @@ test_filter_combine(void)
 }
 
 
+static void
+test_filter_compile(void)
+{
+    OsinfoFilter *filter = osinfo_filter_new();
+    OsinfoDevice *dev1 = osinfo_device_new("e1000");
+    OsinfoDevice *dev2 = osinfo_device_new("ne2k");
+
+    osinfo_entity_add_param(OSINFO_ENTITY(dev1), "bus", "pci");
+    osinfo_entity_add_param(OSINFO_ENTITY(dev1), "class", "network");
+    osinfo_entity_add_param(OSINFO_ENTITY(dev2), "bus", "isa");
+
+    /* Repeated values are only required once */
+    osinfo_filter_add_constraint(filter, "class", "network");
+    osinfo_filter_add_constraint(filter, "class", "network");
+    osinfo_filter_compile(filter);
+    g_assert_true(osinfo_filter_matches(filter, OSINFO_ENTITY(dev1)));
+    g_assert_false(osinfo_filter_matches(filter, OSINFO_ENTITY(dev2)));
+
+    /* Entity values are read at match time */
+    osinfo_entity_add_param(OSINFO_ENTITY(dev2), "class", "network");
+    g_assert_true(osinfo_filter_matches(filter, OSINFO_ENTITY(dev2)));
+
+    /* Changing the constraints recompiles the filter */
+    osinfo_filter_add_constraint(filter, OSINFO_ENTITY_PROP_ID, "ne2k");
+    g_assert_false(osinfo_filter_matches(filter, OSINFO_ENTITY(dev1)));
+    g_assert_true(osinfo_filter_matches(filter, OSINFO_ENTITY(dev2)));
+
+    osinfo_filter_clear_constraint(filter, "class");
+    osinfo_filter_add_constraint(filter, "bus", "pci");
+    osinfo_filter_compile(filter);
+    g_assert_false(osinfo_filter_matches(filter, OSINFO_ENTITY(dev1)));
+    g_assert_false(osinfo_filter_matches(filter, OSINFO_ENTITY(dev2)));
+
+    osinfo_filter_clear_constraints(filter);
+    g_assert_true(osinfo_filter_matches(filter, OSINFO_ENTITY(dev1)));
+    g_assert_true(osinfo_filter_matches(filter, OSINFO_ENTITY(dev2)));
+
+    g_object_unref(dev1);
+    g_object_unref(dev2);
+    g_object_unref(filter);
+}
+
+
 int
 main(int argc, char *argv[])
 {
@@ -156,6 +199,7 @@ main(int argc, char *argv[])
     g_test_add_func("/filter/filter_single", test_filter_single);
     g_test_add_func("/filter/filter_multi", test_filter_multi);
     g_test_add_func("/filter/filter_combine", test_filter_combine);
+    g_test_add_func("/filter/filter_compile", test_filter_compile);
 
     /* Upfront so we don't confuse valgrind */
     osinfo_device_get_type();
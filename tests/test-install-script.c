@@ -17,6 +17,7 @@
 
 #include <osinfo/osinfo.h>
 #include <glib/gstdio.h>
+#include <string.h>
 
 static GError *error = NULL;
 static gchar *actualData = NULL;
@@ -226,6 +227,768 @@ test_script_data(void)
     g_main_loop_unref(loop);
 }
 
+typedef struct {
+    OsinfoInstallScript *script;
+    OsinfoMedia *media;
+    OsinfoInstallConfig *config;
+} TestGenerateThreadData;
+
+static gpointer
+test_generate_thread(gpointer opaque)
+{
+    TestGenerateThreadData *data = opaque;
+    GMainContext *context = g_main_context_new();
+    GError *thread_error = NULL;
+    gchar *output;
+    gsize i;
+
+    g_main_context_push_thread_default(context);
+
+    for (i = 0; i < 10; i++) {
+        output = osinfo_install_script_generate_for_media(data->script,
+                                                          data->media,
+                                                          data->config,
+                                                          NULL,
+                                                          &thread_error);
+        g_assert_no_error(thread_error);
+        g_assert_cmpstr(output, ==, expectData);
+        g_free(output);
+    }
+
+    g_main_context_pop_thread_default(context);
+    g_main_context_unref(context);
+
+    return NULL;
+}
+
+static void
+test_script_data_threads(void)
+{
+    TestGenerateThreadData data;
+    OsinfoLoader *loader = osinfo_loader_new();
+    OsinfoDb *db;
+    GThread *threads[4];
+    GFile *file = g_file_new_for_uri("file://" SRCDIR "/tests/install-script.xsl");
+    gchar *template;
+    gsize i;
+
+    g_file_load_contents(file, NULL, &template, NULL, NULL, &error);
+    g_assert_no_error(error);
+    g_object_unref(file);
+
+    osinfo_loader_process_path(loader, SRCDIR "/tests/dbdata", &error);
+    g_assert_no_error(error);
+    db = g_object_ref(osinfo_loader_get_db(loader));
+    g_object_unref(loader);
+
+    data.config = test_get_config();
+    data.media = create_media();
+    g_assert_true(osinfo_db_identify_media(db, data.media));
+    data.script = osinfo_install_script_new_data("http://example.com",
+                                                 "jeos",
+                                                 template);
+
+    /* All the threads share the stylesheet compiled by the first generation */
+    for (i = 0; i < G_N_ELEMENTS(threads); i++)
+        threads[i] = g_thread_new("generate", test_generate_thread, &data);
+    for (i = 0; i < G_N_ELEMENTS(threads); i++)
+        g_thread_join(threads[i]);
+
+    g_free(template);
+    g_object_unref(data.script);
+    g_object_unref(data.media);
+    g_object_unref(data.config);
+    g_object_unref(db);
+}
+
+/* The expected script for the @idx-th config of a batch */
+static gchar *test_batch_expected(gsize idx)
+{
+    const gchar *rootpw = strstr(expectData, "rootpw 123456\n");
+
+    return g_strdup_printf("%.*srootpw secret%" G_GSIZE_FORMAT "\n%s",
+                           (int)(rootpw - expectData), expectData, idx,
+                           rootpw + strlen("rootpw 123456\n"));
+}
+
+static void
+test_script_batch(void)
+{
+    OsinfoInstallScript *script;
+    OsinfoInstallConfig *configs[8];
+    OsinfoLoader *loader = osinfo_loader_new();
+    OsinfoDb *db;
+    OsinfoMedia *media;
+    GFile *dir;
+    GList *files, *tmp;
+    GFile *blocker;
+    GFileEnumerator *children;
+    GFileInfo *info;
+    gchar **outputs;
+    gchar *dirname;
+    gsize i;
+
+    osinfo_loader_process_path(loader, SRCDIR "/tests/dbdata", &error);
+    g_assert_no_error(error);
+    db = g_object_ref(osinfo_loader_get_db(loader));
+    g_object_unref(loader);
+
+    media = create_media();
+    g_assert_true(osinfo_db_identify_media(db, media));
+
+    script = osinfo_install_script_new_uri("http://example.com",
+                                           "jeos",
+                                           "file://" SRCDIR "/tests/install-script.xsl");
+    osinfo_entity_set_param(OSINFO_ENTITY(script),
+                            OSINFO_INSTALL_SCRIPT_PROP_EXPECTED_FILENAME,
+                            "fedora.ks");
+
+    for (i = 0; i < G_N_ELEMENTS(configs); i++) {
+        gchar *password = g_strdup_printf("secret%" G_GSIZE_FORMAT, i);
+
+        configs[i] = test_get_config();
+        osinfo_install_config_set_admin_password(configs[i], password);
+        g_free(password);
+    }
+
+    outputs = osinfo_install_script_generate_batch(script, NULL, media, NULL,
+                                                   configs, G_N_ELEMENTS(configs),
+                                                   NULL, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(outputs);
+    g_assert_cmpint(g_strv_length(outputs), ==, G_N_ELEMENTS(configs));
+    for (i = 0; i < G_N_ELEMENTS(configs); i++) {
+        gchar *expected = test_batch_expected(i);
+
+        g_assert_cmpstr(outputs[i], ==, expected);
+        g_free(expected);
+    }
+    g_strfreev(outputs);
+
+    dirname = g_dir_make_tmp("libosinfo-batch-XXXXXX", &error);
+    g_assert_no_error(error);
+    dir = g_file_new_for_path(dirname);
+
+    files = osinfo_install_script_generate_output_batch(script, NULL, media, NULL,
+                                                        configs, G_N_ELEMENTS(configs),
+                                                        dir, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_cmpint(g_list_length(files), ==, G_N_ELEMENTS(configs));
+    for (tmp = files, i = 0; tmp != NULL; tmp = tmp->next, i++) {
+        GFile *file = tmp->data;
+        gchar *expectName = g_strdup_printf("%" G_GSIZE_FORMAT "-fedora.ks", i);
+        gchar *name = g_file_get_basename(file);
+        gchar *expected = test_batch_expected(i);
+        gchar *data;
+
+        g_assert_cmpstr(name, ==, expectName);
+        g_file_load_contents(file, NULL, &data, NULL, NULL, &error);
+        g_assert_no_error(error);
+        g_assert_cmpstr(data, ==, expected);
+
+        g_file_delete(file, NULL, NULL);
+        g_free(data);
+        g_free(expected);
+        g_free(name);
+        g_free(expectName);
+    }
+    g_list_free_full(files, g_object_unref);
+
+    /* A script which cannot be written fails the batch, and the scripts
+     * written for the other configs are removed */
+    blocker = g_file_get_child(dir, "3-fedora.ks");
+    g_file_make_directory(blocker, NULL, &error);
+    g_assert_no_error(error);
+
+    files = osinfo_install_script_generate_output_batch(script, NULL, media, NULL,
+                                                        configs, G_N_ELEMENTS(configs),
+                                                        dir, NULL, &error);
+    g_assert_nonnull(error);
+    g_assert_null(files);
+    g_clear_error(&error);
+
+    children = g_file_enumerate_children(dir, G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                         G_FILE_QUERY_INFO_NONE, NULL, &error);
+    g_assert_no_error(error);
+    while ((info = g_file_enumerator_next_file(children, NULL, &error))) {
+        g_assert_cmpstr(g_file_info_get_name(info), ==, "3-fedora.ks");
+        g_object_unref(info);
+    }
+    g_assert_no_error(error);
+    g_object_unref(children);
+
+    g_file_delete(blocker, NULL, NULL);
+    g_object_unref(blocker);
+
+    g_rmdir(dirname);
+    g_free(dirname);
+    g_object_unref(dir);
+    for (i = 0; i < G_N_ELEMENTS(configs); i++)
+        g_object_unref(configs[i]);
+    g_object_unref(script);
+    g_object_unref(media);
+    g_object_unref(db);
+}
+
+static void
+test_script_entity_nodes(void)
+{
+    OsinfoInstallScript *script;
+    OsinfoInstallConfig *config = test_get_config();
+    OsinfoLoader *loader = osinfo_loader_new();
+    OsinfoDb *db;
+    OsinfoMedia *media;
+    OsinfoOs *os;
+    gchar *output;
+
+    osinfo_loader_process_path(loader, SRCDIR "/tests/dbdata", &error);
+    g_assert_no_error(error);
+    db = g_object_ref(osinfo_loader_get_db(loader));
+    g_object_unref(loader);
+
+    media = create_media();
+    g_assert_true(osinfo_db_identify_media(db, media));
+    os = osinfo_media_get_os(media);
+
+    script = osinfo_install_script_new_uri("http://example.com",
+                                           "jeos",
+                                           "file://" SRCDIR "/tests/install-script.xsl");
+
+    output = osinfo_install_script_generate_for_media(script, media, config, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(output, ==, expectData);
+    g_free(output);
+
+    /* Generating without the media must not reuse its node */
+    output = osinfo_install_script_generate(script, os, config, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(strstr(output, "# Unknown media\n"));
+    g_free(output);
+
+    /* Alternating between the two keeps the nodes of both apart */
+    output = osinfo_install_script_generate_for_media(script, media, config, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(output, ==, expectData);
+    g_free(output);
+
+    output = osinfo_install_script_generate(script, os, config, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(strstr(output, "# Unknown media\n"));
+    g_free(output);
+
+    /* Changes to the entities must be picked up */
+    osinfo_entity_set_param(OSINFO_ENTITY(script),
+                            OSINFO_INSTALL_SCRIPT_PROP_PROFILE,
+                            "desktop");
+    output = osinfo_install_script_generate(script, os, config, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(strstr(output, "# Profile: desktop\n"));
+    g_free(output);
+
+    output = osinfo_install_script_generate_for_media(script, media, config, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(strstr(output, "# Media id=http://fedoraproject.org/fedora/16:0\n"
+                                    "# Profile: desktop\n"));
+    g_free(output);
+
+    g_object_unref(script);
+    g_object_unref(os);
+    g_object_unref(media);
+    g_object_unref(config);
+    g_object_unref(db);
+}
+
+static const gchar *prunedTemplate =                                   \
+    "<xsl:stylesheet xmlns:xsl='http://www.w3.org/1999/XSL/Transform'"  \
+    "                version='1.0'>"                                    \
+    "  <xsl:output method='text'/>"                                     \
+    "  <xsl:template match='/install-script-config'>"                   \
+    "    <xsl:value-of select=\"concat(os/short-id, ' ', os/codename)\"/>" \
+    "    <xsl:text> </xsl:text>"                                        \
+    "    <xsl:value-of select='media/volume-id'/>"                      \
+    "    <xsl:for-each select='os/family'>"                             \
+    "      <xsl:value-of select=\"concat(' ', ., ' ', /install-script-config/config/l10n-keyboard)\"/>" \
+    "    </xsl:for-each>"                                               \
+    "  </xsl:template>"                                                 \
+    "</xsl:stylesheet>";
+
+static const gchar *wildcardTemplate =                                  \
+    "<xsl:stylesheet xmlns:xsl='http://www.w3.org/1999/XSL/Transform'"  \
+    "                version='1.0'>"                                    \
+    "  <xsl:output method='text'/>"                                     \
+    "  <xsl:template match='/install-script-config'>"                   \
+    "    <xsl:value-of select=\"os/*[local-name() = 'codename']\"/>"    \
+    "  </xsl:template>"                                                 \
+    "</xsl:stylesheet>";
+
+static const gchar *applyTemplatesTemplate =                            \
+    "<xsl:stylesheet xmlns:xsl='http://www.w3.org/1999/XSL/Transform'"  \
+    "                version='1.0'>"                                    \
+    "  <xsl:output method='text'/>"                                     \
+    "  <xsl:template match='/install-script-config'>"                   \
+    "    <xsl:apply-templates/>"                                        \
+    "  </xsl:template>"                                                 \
+    "</xsl:stylesheet>";
+
+static const gchar *builtinTemplate =                                   \
+    "<xsl:stylesheet xmlns:xsl='http://www.w3.org/1999/XSL/Transform'"  \
+    "                version='1.0'>"                                    \
+    "  <xsl:output method='text'/>"                                     \
+    "  <xsl:template match='/install-script-config/config'>"            \
+    "    <xsl:value-of select='l10n-keyboard'/>"                        \
+    "  </xsl:template>"                                                 \
+    "</xsl:stylesheet>";
+
+static void
+test_script_pruning(void)
+{
+    OsinfoInstallScript *script;
+    OsinfoInstallConfig *config = test_get_config();
+    OsinfoLoader *loader = osinfo_loader_new();
+    OsinfoDb *db;
+    OsinfoMedia *media;
+    gchar *output;
+
+    osinfo_loader_process_path(loader, SRCDIR "/tests/dbdata", &error);
+    g_assert_no_error(error);
+    db = g_object_ref(osinfo_loader_get_db(loader));
+    g_object_unref(loader);
+
+    media = create_media();
+    g_assert_true(osinfo_db_identify_media(db, media));
+
+    /* Only the parameters named by the template are emitted */
+    script = osinfo_install_script_new_data("http://example.com",
+                                            "jeos",
+                                            prunedTemplate);
+    output = osinfo_install_script_generate_for_media(script, media, config, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(output, ==, "fedora16 Verne Fedora 16 i386 DVD linux uk");
+    g_free(output);
+    g_object_unref(script);
+
+    /* Wildcards need all the parameters to be emitted */
+    script = osinfo_install_script_new_data("http://example.com",
+                                            "jeos",
+                                            wildcardTemplate);
+    output = osinfo_install_script_generate_for_media(script, media, config, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(output, ==, "Verne");
+    g_free(output);
+    g_object_unref(script);
+
+    /* Applying the templates to all the children outputs their text */
+    script = osinfo_install_script_new_data("http://example.com",
+                                            "jeos",
+                                            applyTemplatesTemplate);
+    output = osinfo_install_script_generate_for_media(script, media, config, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(strstr(output, "Verne"));
+    g_free(output);
+    g_object_unref(script);
+
+    /* So do the built-in rules for the nodes no template matches */
+    script = osinfo_install_script_new_data("http://example.com",
+                                            "jeos",
+                                            builtinTemplate);
+    output = osinfo_install_script_generate_for_media(script, media, config, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(strstr(output, "Verne"));
+    g_assert_nonnull(strstr(output, "uk"));
+    g_free(output);
+    g_object_unref(script);
+
+    g_object_unref(media);
+    g_object_unref(config);
+    g_object_unref(db);
+}
+
+static void
+test_script_stream(void)
+{
+    OsinfoInstallScript *script;
+    OsinfoInstallConfig *config = test_get_config();
+    OsinfoLoader *loader = osinfo_loader_new();
+    OsinfoDb *db;
+    OsinfoMedia *media;
+    GOutputStream *stream;
+    gchar *path;
+    gchar *data;
+    int fd;
+
+    osinfo_loader_process_path(loader, SRCDIR "/tests/dbdata", &error);
+    g_assert_no_error(error);
+    db = g_object_ref(osinfo_loader_get_db(loader));
+    g_object_unref(loader);
+
+    media = create_media();
+    g_assert_true(osinfo_db_identify_media(db, media));
+
+    script = osinfo_install_script_new_uri("http://example.com",
+                                           "jeos",
+                                           "file://" SRCDIR "/tests/install-script.xsl");
+
+    stream = g_memory_output_stream_new(NULL, 0, g_realloc, g_free);
+    g_assert_true(osinfo_install_script_generate_to_stream(script, NULL, media, NULL,
+                                                           config, stream,
+                                                           NULL, &error));
+    g_assert_no_error(error);
+    g_assert_true(g_output_stream_write_all(stream, "", 1, NULL, NULL, &error));
+    g_assert_no_error(error);
+    g_assert_cmpstr(g_memory_output_stream_get_data(G_MEMORY_OUTPUT_STREAM(stream)),
+                    ==, expectData);
+    g_object_unref(stream);
+
+    fd = g_file_open_tmp("libosinfo-script-XXXXXX", &path, &error);
+    g_assert_no_error(error);
+    g_assert_true(osinfo_install_script_generate_to_fd(script, NULL, media, NULL,
+                                                       config, fd,
+                                                       NULL, &error));
+    g_assert_no_error(error);
+    g_close(fd, &error);
+    g_assert_no_error(error);
+    g_file_get_contents(path, &data, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(data, ==, expectData);
+    g_unlink(path);
+    g_free(data);
+    g_free(path);
+
+    g_object_unref(script);
+    g_object_unref(media);
+    g_object_unref(config);
+    g_object_unref(db);
+}
+
+static const gchar *failingTemplate =                                  \
+    "<xsl:stylesheet xmlns:xsl='http://www.w3.org/1999/XSL/Transform'"  \
+    "                version='1.0'>"                                    \
+    "  <xsl:output method='text'/>"                                     \
+    "  <xsl:template match='/install-script-config'>"                   \
+    "    <xsl:value-of select='os/short-id'/>"                          \
+    "    <xsl:message terminate='yes'>Unsupported</xsl:message>"        \
+    "  </xsl:template>"                                                 \
+    "</xsl:stylesheet>";
+
+static void
+test_script_output_error(void)
+{
+    OsinfoInstallScript *script;
+    OsinfoInstallConfig *config = test_get_config();
+    OsinfoLoader *loader = osinfo_loader_new();
+    OsinfoDb *db;
+    OsinfoMedia *media;
+    GFile *dir;
+    GFile *file;
+    GFile *output;
+    gchar *dirname;
+    gchar *data;
+
+    osinfo_loader_process_path(loader, SRCDIR "/tests/dbdata", &error);
+    g_assert_no_error(error);
+    db = g_object_ref(osinfo_loader_get_db(loader));
+    g_object_unref(loader);
+
+    media = create_media();
+    g_assert_true(osinfo_db_identify_media(db, media));
+
+    script = osinfo_install_script_new_data("http://example.com",
+                                            "jeos",
+                                            failingTemplate);
+    osinfo_entity_set_param(OSINFO_ENTITY(script),
+                            OSINFO_INSTALL_SCRIPT_PROP_EXPECTED_FILENAME,
+                            "fedora.ks");
+
+    dirname = g_dir_make_tmp("libosinfo-output-XXXXXX", &error);
+    g_assert_no_error(error);
+    dir = g_file_new_for_path(dirname);
+    file = g_file_get_child(dir, "fedora.ks");
+
+    /* A new file is not left behind */
+    output = osinfo_install_script_generate_output_for_media(script, media, config,
+                                                             dir, NULL, &error);
+    g_assert_null(output);
+    g_assert_nonnull(error);
+    g_clear_error(&error);
+    g_assert_false(g_file_query_exists(file, NULL));
+
+    /* An existing file is kept as it was */
+    g_file_replace_contents(file, "previous", strlen("previous"), NULL, FALSE,
+                            G_FILE_CREATE_NONE, NULL, NULL, &error);
+    g_assert_no_error(error);
+    output = osinfo_install_script_generate_output_for_media(script, media, config,
+                                                             dir, NULL, &error);
+    g_assert_null(output);
+    g_assert_nonnull(error);
+    g_clear_error(&error);
+    g_file_load_contents(file, NULL, &data, NULL, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(data, ==, "previous");
+    g_free(data);
+
+    g_file_delete(file, NULL, NULL);
+    g_rmdir(dirname);
+    g_free(dirname);
+    g_object_unref(file);
+    g_object_unref(dir);
+    g_object_unref(script);
+    g_object_unref(media);
+    g_object_unref(config);
+    g_object_unref(db);
+}
+
+static void
+test_script_preload(void)
+{
+    OsinfoInstallScript *script;
+    OsinfoInstallConfig *config = test_get_config();
+    OsinfoLoader *loader = osinfo_loader_new();
+    OsinfoDb *db;
+    OsinfoMedia *media;
+    GFile *file = g_file_new_for_uri("file://" SRCDIR "/tests/install-script.xsl");
+    GFile *copy;
+    gchar *dirname;
+    gchar *path;
+    gchar *uri;
+    gchar *output;
+
+    osinfo_loader_process_path(loader, SRCDIR "/tests/dbdata", &error);
+    g_assert_no_error(error);
+    db = g_object_ref(osinfo_loader_get_db(loader));
+    g_object_unref(loader);
+
+    g_assert_true(osinfo_db_preload_install_scripts(db, NULL, &error));
+    g_assert_no_error(error);
+
+    media = create_media();
+    g_assert_true(osinfo_db_identify_media(db, media));
+
+    dirname = g_dir_make_tmp("libosinfo-preload-XXXXXX", &error);
+    g_assert_no_error(error);
+    path = g_build_filename(dirname, "install-script.xsl", NULL);
+    copy = g_file_new_for_path(path);
+    g_file_copy(file, copy, G_FILE_COPY_NONE, NULL, NULL, NULL, &error);
+    g_assert_no_error(error);
+
+    uri = g_file_get_uri(copy);
+    script = osinfo_install_script_new_uri("http://example.com", "jeos", uri);
+    g_assert_true(osinfo_install_script_preload(script, NULL, &error));
+    g_assert_no_error(error);
+
+    /* Once preloaded, the template is not read again */
+    g_unlink(path);
+    output = osinfo_install_script_generate_for_media(script, media, config, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(output, ==, expectData);
+    g_free(output);
+
+    /* Preloading again picks up changes to the template */
+    g_file_set_contents(path,
+                        "<xsl:stylesheet xmlns:xsl='http://www.w3.org/1999/XSL/Transform'"
+                        "                version='1.0'>"
+                        "  <xsl:output method='text'/>"
+                        "  <xsl:template match='/install-script-config'>"
+                        "    <xsl:value-of select='os/short-id'/>"
+                        "  </xsl:template>"
+                        "</xsl:stylesheet>",
+                        -1, &error);
+    g_assert_no_error(error);
+    g_file_set_attribute_uint64(copy, G_FILE_ATTRIBUTE_TIME_MODIFIED, 1,
+                                G_FILE_QUERY_INFO_NONE, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(osinfo_install_script_preload(script, NULL, &error));
+    g_assert_no_error(error);
+    output = osinfo_install_script_generate_for_media(script, media, config, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(output, ==, "fedora16");
+    g_free(output);
+
+    g_unlink(path);
+    g_rmdir(dirname);
+    g_free(uri);
+    g_free(path);
+    g_free(dirname);
+    g_object_unref(copy);
+    g_object_unref(file);
+    g_object_unref(script);
+    g_object_unref(media);
+    g_object_unref(config);
+    g_object_unref(db);
+}
+
+/* Returns the data of @name in a newc cpio @archive */
+static gchar *
+test_archive_find(const gchar *archive, gsize len, const gchar *name, gsize *size)
+{
+    gsize pos = 0;
+
+    while (pos + 110 <= len) {
+        gchar field[9] = { 0 };
+        gsize namesize;
+        const gchar *entry;
+
+        g_assert_cmpint(memcmp(archive + pos, "070701", 6), ==, 0);
+        memcpy(field, archive + pos + 54, 8);
+        *size = g_ascii_strtoull(field, NULL, 16);
+        memcpy(field, archive + pos + 94, 8);
+        namesize = g_ascii_strtoull(field, NULL, 16);
+
+        entry = archive + pos + 110;
+        pos = (pos + 110 + namesize + 3) & ~3;
+        if (g_str_equal(entry, name))
+            return g_strndup(archive + pos, *size);
+        if (g_str_equal(entry, "TRAILER!!!"))
+            break;
+        pos = (pos + *size + 3) & ~3;
+    }
+
+    return NULL;
+}
+
+static void
+test_script_initrd_archive(void)
+{
+    OsinfoInstallScript *script;
+    OsinfoInstallConfig *config = test_get_config();
+    OsinfoLoader *loader = osinfo_loader_new();
+    OsinfoDb *db;
+    OsinfoMedia *media;
+    OsinfoDeviceDriver *driver;
+    OsinfoDeviceDriver *driver64;
+    OsinfoDeviceDriver *invalid;
+    OsinfoDeviceDriverList *drivers;
+    GOutputStream *stream;
+    GList *scripts;
+    const gchar *archive;
+    gchar *template;
+    gchar *data;
+    gsize len;
+    gsize size;
+
+    osinfo_loader_process_path(loader, SRCDIR "/tests/dbdata", &error);
+    g_assert_no_error(error);
+    db = g_object_ref(osinfo_loader_get_db(loader));
+    g_object_unref(loader);
+
+    media = create_media();
+    g_assert_true(osinfo_db_identify_media(db, media));
+
+    script = osinfo_install_script_new_uri("http://example.com",
+                                           "jeos",
+                                           "file://" SRCDIR "/tests/install-script.xsl");
+    osinfo_entity_set_param(OSINFO_ENTITY(script),
+                            OSINFO_INSTALL_SCRIPT_PROP_EXPECTED_FILENAME,
+                            "fedora.ks");
+    scripts = g_list_append(NULL, script);
+
+    driver = g_object_new(OSINFO_TYPE_DEVICE_DRIVER,
+                          "id", "http://example.com/driver",
+                          NULL);
+    osinfo_entity_set_param(OSINFO_ENTITY(driver),
+                            OSINFO_DEVICE_DRIVER_PROP_LOCATION,
+                            "file://" SRCDIR "/tests/");
+    osinfo_entity_set_param(OSINFO_ENTITY(driver),
+                            OSINFO_DEVICE_DRIVER_PROP_ARCHITECTURE,
+                            "i686");
+    osinfo_entity_add_param(OSINFO_ENTITY(driver),
+                            OSINFO_DEVICE_DRIVER_PROP_FILE,
+                            "install-script.xsl");
+
+    /* The same file name, for another architecture */
+    driver64 = g_object_new(OSINFO_TYPE_DEVICE_DRIVER,
+                            "id", "http://example.com/driver64",
+                            NULL);
+    osinfo_entity_set_param(OSINFO_ENTITY(driver64),
+                            OSINFO_DEVICE_DRIVER_PROP_LOCATION,
+                            "file://" SRCDIR "/tests/");
+    osinfo_entity_set_param(OSINFO_ENTITY(driver64),
+                            OSINFO_DEVICE_DRIVER_PROP_ARCHITECTURE,
+                            "x86_64");
+    osinfo_entity_add_param(OSINFO_ENTITY(driver64),
+                            OSINFO_DEVICE_DRIVER_PROP_FILE,
+                            "install-script.xsl");
+
+    drivers = osinfo_device_driverlist_new();
+    osinfo_list_add(OSINFO_LIST(drivers), OSINFO_ENTITY(driver));
+    osinfo_list_add(OSINFO_LIST(drivers), OSINFO_ENTITY(driver64));
+
+    stream = g_memory_output_stream_new(NULL, 0, g_realloc, g_free);
+    g_assert_true(osinfo_install_script_generate_initrd_archive(scripts, NULL, media, NULL,
+                                                                config, drivers, stream,
+                                                                NULL, &error));
+    g_assert_no_error(error);
+    archive = g_memory_output_stream_get_data(G_MEMORY_OUTPUT_STREAM(stream));
+    len = g_memory_output_stream_get_data_size(G_MEMORY_OUTPUT_STREAM(stream));
+    g_assert_cmpint(len % 4, ==, 0);
+
+    data = test_archive_find(archive, len, "fedora.ks", &size);
+    g_assert_cmpstr(data, ==, expectData);
+    g_free(data);
+
+    data = test_archive_find(archive, len, "drivers", &size);
+    g_assert_nonnull(data);
+    g_assert_cmpint(size, ==, 0);
+    g_free(data);
+
+    g_file_get_contents(SRCDIR "/tests/install-script.xsl", &template, NULL, &error);
+    g_assert_no_error(error);
+    data = test_archive_find(archive, len, "drivers/i686/install-script.xsl", &size);
+    g_assert_cmpstr(data, ==, template);
+    g_free(data);
+    data = test_archive_find(archive, len, "drivers/x86_64/install-script.xsl", &size);
+    g_assert_cmpstr(data, ==, template);
+    g_free(template);
+    g_free(data);
+
+    g_assert_null(test_archive_find(archive, len, "missing", &size));
+    g_object_unref(stream);
+
+    /* File names must stay below the drivers directory */
+    invalid = g_object_new(OSINFO_TYPE_DEVICE_DRIVER,
+                           "id", "http://example.com/invalid",
+                           NULL);
+    osinfo_entity_set_param(OSINFO_ENTITY(invalid),
+                            OSINFO_DEVICE_DRIVER_PROP_LOCATION,
+                            "file://" SRCDIR "/tests/dbdata/");
+    osinfo_entity_set_param(OSINFO_ENTITY(invalid),
+                            OSINFO_DEVICE_DRIVER_PROP_ARCHITECTURE,
+                            "i686");
+    osinfo_entity_add_param(OSINFO_ENTITY(invalid),
+                            OSINFO_DEVICE_DRIVER_PROP_FILE,
+                            "../install-script.xsl");
+    osinfo_list_add(OSINFO_LIST(drivers), OSINFO_ENTITY(invalid));
+
+    stream = g_memory_output_stream_new(NULL, 0, g_realloc, g_free);
+    g_assert_false(osinfo_install_script_generate_initrd_archive(scripts, NULL, media, NULL,
+                                                                 config, drivers, stream,
+                                                                 NULL, &error));
+    g_assert_error(error, OSINFO_ERROR, 0);
+    g_clear_error(&error);
+    g_object_unref(stream);
+
+    osinfo_entity_clear_param(OSINFO_ENTITY(invalid), OSINFO_DEVICE_DRIVER_PROP_FILE);
+    osinfo_entity_add_param(OSINFO_ENTITY(invalid),
+                            OSINFO_DEVICE_DRIVER_PROP_FILE,
+                            SRCDIR "/tests/install-script.xsl");
+    stream = g_memory_output_stream_new(NULL, 0, g_realloc, g_free);
+    g_assert_false(osinfo_install_script_generate_initrd_archive(scripts, NULL, media, NULL,
+                                                                 config, drivers, stream,
+                                                                 NULL, &error));
+    g_assert_error(error, OSINFO_ERROR, 0);
+    g_clear_error(&error);
+    g_object_unref(stream);
+
+    g_object_unref(drivers);
+    g_object_unref(invalid);
+    g_object_unref(driver64);
+    g_object_unref(driver);
+    g_list_free(scripts);
+    g_object_unref(script);
+    g_object_unref(media);
+    g_object_unref(config);
+    g_object_unref(db);
+}
+
 static void
 test_script_datamap(void)
 {
@@ -297,6 +1060,39 @@ test_script_datamap(void)
     g_main_loop_unref(loop);
 }
 
+static void
+test_script_template_data(void)
+{
+    OsinfoLoader *loader = osinfo_loader_new();
+    OsinfoDb *db;
+    OsinfoInstallScript *script;
+    gchar *data = NULL;
+
+    osinfo_loader_process_path(loader, SRCDIR "/tests/dbdata", &error);
+    g_assert_no_error(error);
+    db = g_object_ref(osinfo_loader_get_db(loader));
+    g_object_unref(loader);
+
+    script = osinfo_db_get_install_script(db, "http://example.com/libosinfo/test-install-script");
+    g_assert_nonnull(script);
+
+    /* Inline templates are only serialized when asked for */
+    g_assert_true(g_str_has_prefix(osinfo_install_script_get_template_data(script),
+                                   "<xsl:stylesheet"));
+    g_assert_nonnull(strstr(osinfo_install_script_get_template_data(script),
+                            "match=\"/install-script-config\""));
+    /* ...once, and the string stays valid */
+    g_assert_true(osinfo_install_script_get_template_data(script) ==
+                  osinfo_install_script_get_template_data(script));
+
+    g_object_get(script, "template-data", &data, NULL);
+    g_assert_cmpstr(data, ==, osinfo_install_script_get_template_data(script));
+    g_assert_null(osinfo_install_script_get_template_uri(script));
+
+    g_free(data);
+    g_object_unref(db);
+}
+
 static void
 test_preferred_injection_method(void)
 {
@@ -350,7 +1146,16 @@ main(int argc, char *argv[])
 
     g_test_add_func("/install-script/script_file", test_script_file);
     g_test_add_func("/install-script/script_data", test_script_data);
+    g_test_add_func("/install-script/script_data_threads", test_script_data_threads);
+    g_test_add_func("/install-script/script_batch", test_script_batch);
+    g_test_add_func("/install-script/script_entity_nodes", test_script_entity_nodes);
+    g_test_add_func("/install-script/script_pruning", test_script_pruning);
+    g_test_add_func("/install-script/script_stream", test_script_stream);
+    g_test_add_func("/install-script/script_output_error", test_script_output_error);
+    g_test_add_func("/install-script/script_preload", test_script_preload);
+    g_test_add_func("/install-script/script_initrd_archive", test_script_initrd_archive);
     g_test_add_func("/install-script/script_datamap", test_script_datamap);
+    g_test_add_func("/install-script/script_template_data", test_script_template_data);
     g_test_add_func("/install-script/preferred_injection_method", test_preferred_injection_method);
     g_test_add_func("/install-script/installation_source", test_installation_source);
 
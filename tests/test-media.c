@@ -139,6 +139,46 @@ test_loaded_installer_script(void)
     g_object_unref(loader);
 }
 
+static void
+test_find_install_script(void)
+{
+    OsinfoOs *os = osinfo_os_new("os");
+    OsinfoMedia *media = osinfo_media_new("media", "x86_64");
+    OsinfoInstallScript *os_script = osinfo_install_script_new_data("os-jeos",
+                                                                    OSINFO_INSTALL_SCRIPT_PROFILE_JEOS,
+                                                                    "");
+    OsinfoInstallScript *media_script = osinfo_install_script_new_data("media-jeos",
+                                                                       OSINFO_INSTALL_SCRIPT_PROFILE_JEOS,
+                                                                       "");
+
+    osinfo_entity_set_param_int64(OSINFO_ENTITY(media_script),
+                                  OSINFO_INSTALL_SCRIPT_PROP_INJECTION_METHOD,
+                                  OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_INITRD);
+
+    osinfo_os_add_install_script(os, os_script);
+    osinfo_os_add_media(os, media);
+
+    /* Media without scripts use the scripts of their OS */
+    g_assert_true(osinfo_media_supports_installer_script(media));
+    g_assert_true(osinfo_media_find_install_script(media, OSINFO_INSTALL_SCRIPT_PROFILE_JEOS,
+                                                   OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_DISK) == os_script);
+
+    osinfo_media_add_install_script(media, media_script);
+    g_assert_true(osinfo_media_find_install_script(media, OSINFO_INSTALL_SCRIPT_PROFILE_JEOS,
+                                                   0) == media_script);
+    g_assert_true(osinfo_media_find_install_script(media, OSINFO_INSTALL_SCRIPT_PROFILE_JEOS,
+                                                   OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_INITRD) == media_script);
+    g_assert_null(osinfo_media_find_install_script(media, OSINFO_INSTALL_SCRIPT_PROFILE_JEOS,
+                                                   OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_DISK));
+    g_assert_null(osinfo_media_find_install_script(media, OSINFO_INSTALL_SCRIPT_PROFILE_DESKTOP,
+                                                   0));
+
+    g_object_unref(os_script);
+    g_object_unref(media_script);
+    g_object_unref(media);
+    g_object_unref(os);
+}
+
 static OsinfoMedia *
 test_create_media(const char *id,
                   const char *arch,
@@ -249,6 +289,7 @@ main(int argc, char *argv[])
     g_test_add_func("/media/loaded/attributes", test_loaded_attributes);
     g_test_add_func("/media/loaded/no-installer", test_loaded_no_installer);
     g_test_add_func("/media/loaded/installer-script", test_loaded_installer_script);
+    g_test_add_func("/media/find-install-script", test_find_install_script);
     g_test_add_func("/media/matching", test_matching);
 
     /* Upfront so we don't confuse valgrind */
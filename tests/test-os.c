@@ -59,6 +59,160 @@ test_devices(void)
 }
 
 
+static void
+check_all_device_ids(OsinfoOs *os, const gchar **expected)
+{
+    OsinfoDeviceList *devices = osinfo_os_get_all_devices(os, NULL);
+    gsize i;
+
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(devices)), ==,
+                    g_strv_length((gchar **)expected));
+    for (i = 0; expected[i] != NULL; i++) {
+        OsinfoEntity *ent = osinfo_list_get_nth(OSINFO_LIST(devices), i);
+        g_assert_cmpstr(osinfo_entity_get_id(ent), ==, expected[i]);
+    }
+
+    g_object_unref(devices);
+}
+
+static void
+test_related_traversal(void)
+{
+    OsinfoOs *os1 = osinfo_os_new("os1");
+    OsinfoOs *os2 = osinfo_os_new("os2");
+    OsinfoOs *os3 = osinfo_os_new("os3");
+    OsinfoOs *os4 = osinfo_os_new("os4");
+    OsinfoDevice *dev1 = osinfo_device_new("dev1");
+    OsinfoDevice *dev2 = osinfo_device_new("dev2");
+    OsinfoDevice *dev3 = osinfo_device_new("dev3");
+    OsinfoDevice *dev4 = osinfo_device_new("dev4");
+    const gchar *diamond[] = { "dev1", "dev3", "dev4", "dev2", NULL };
+    const gchar *chain[] = { "dev2", "dev4", NULL };
+    const gchar *cycle[] = { "dev2", "dev4", "dev1", "dev3", NULL };
+
+    osinfo_os_add_device(os1, dev1);
+    osinfo_os_add_device(os2, dev2);
+    osinfo_os_add_device(os3, dev3);
+    osinfo_os_add_device(os4, dev4);
+
+    /* os2 and os3 both derive from os4, os1 derives from both */
+    osinfo_product_add_related(OSINFO_PRODUCT(os2),
+                               OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM,
+                               OSINFO_PRODUCT(os4));
+    osinfo_product_add_related(OSINFO_PRODUCT(os3),
+                               OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM,
+                               OSINFO_PRODUCT(os4));
+    osinfo_product_add_related(OSINFO_PRODUCT(os1),
+                               OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM,
+                               OSINFO_PRODUCT(os2));
+    osinfo_product_add_related(OSINFO_PRODUCT(os1),
+                               OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM,
+                               OSINFO_PRODUCT(os3));
+
+    /* os4 is reachable twice, but only visited once */
+    check_all_device_ids(os1, diamond);
+    check_all_device_ids(os2, chain);
+
+    /* Relationships added after the traversal was cached, with a cycle */
+    osinfo_product_add_related(OSINFO_PRODUCT(os4),
+                               OSINFO_PRODUCT_RELATIONSHIP_CLONES,
+                               OSINFO_PRODUCT(os1));
+
+    check_all_device_ids(os2, cycle);
+
+    g_object_unref(dev1);
+    g_object_unref(dev2);
+    g_object_unref(dev3);
+    g_object_unref(dev4);
+    g_object_unref(os1);
+    g_object_unref(os2);
+    g_object_unref(os3);
+    g_object_unref(os4);
+}
+
+
+
+static OsinfoInstallScript *
+create_install_script(const gchar *id, const gchar *profile, guint methods)
+{
+    OsinfoInstallScript *script = osinfo_install_script_new_data(id, profile, "");
+
+    osinfo_entity_set_param_int64(OSINFO_ENTITY(script),
+                                  OSINFO_INSTALL_SCRIPT_PROP_INJECTION_METHOD,
+                                  methods);
+
+    return script;
+}
+
+static void
+test_install_script_lookup(void)
+{
+    OsinfoOs *os = osinfo_os_new("os");
+    OsinfoOs *parent = osinfo_os_new("parent");
+    OsinfoInstallScript *jeos = create_install_script("jeos", OSINFO_INSTALL_SCRIPT_PROFILE_JEOS,
+                                                      OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_CDROM |
+                                                      OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_DISK);
+    OsinfoInstallScript *parent_jeos = create_install_script("parent-jeos", OSINFO_INSTALL_SCRIPT_PROFILE_JEOS,
+                                                             OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_INITRD);
+    OsinfoInstallScript *parent_desktop = create_install_script("parent-desktop", OSINFO_INSTALL_SCRIPT_PROFILE_DESKTOP,
+                                                                OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_DISK);
+
+    osinfo_os_add_install_script(os, jeos);
+    osinfo_os_add_install_script(parent, parent_jeos);
+    osinfo_product_add_related(OSINFO_PRODUCT(os),
+                               OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM,
+                               OSINFO_PRODUCT(parent));
+
+    g_assert_true(osinfo_os_find_install_script(os, OSINFO_INSTALL_SCRIPT_PROFILE_JEOS) == jeos);
+    g_assert_null(osinfo_os_find_install_script(os, OSINFO_INSTALL_SCRIPT_PROFILE_DESKTOP));
+
+    g_assert_true(osinfo_os_find_install_script_by_injection_method
+                  (os, OSINFO_INSTALL_SCRIPT_PROFILE_JEOS, 0) == jeos);
+    g_assert_true(osinfo_os_find_install_script_by_injection_method
+                  (os, OSINFO_INSTALL_SCRIPT_PROFILE_JEOS,
+                   OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_DISK) == jeos);
+    g_assert_true(osinfo_os_find_install_script_by_injection_method
+                  (os, OSINFO_INSTALL_SCRIPT_PROFILE_JEOS,
+                   OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_INITRD) == parent_jeos);
+    g_assert_null(osinfo_os_find_install_script_by_injection_method
+                  (os, OSINFO_INSTALL_SCRIPT_PROFILE_JEOS,
+                   OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_WEB));
+    g_assert_null(osinfo_os_find_install_script_by_injection_method
+                  (os, OSINFO_INSTALL_SCRIPT_PROFILE_DESKTOP, 0));
+
+    /* Combined methods must all be supported by the same script */
+    g_assert_true(osinfo_os_find_install_script_by_injection_method
+                  (os, OSINFO_INSTALL_SCRIPT_PROFILE_JEOS,
+                   OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_CDROM |
+                   OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_DISK) == jeos);
+    g_assert_null(osinfo_os_find_install_script_by_injection_method
+                  (os, OSINFO_INSTALL_SCRIPT_PROFILE_JEOS,
+                   OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_DISK |
+                   OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_INITRD));
+    osinfo_entity_set_param_int64(OSINFO_ENTITY(parent_jeos),
+                                  OSINFO_INSTALL_SCRIPT_PROP_INJECTION_METHOD,
+                                  OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_DISK |
+                                  OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_INITRD);
+    g_assert_true(osinfo_os_find_install_script_by_injection_method
+                  (os, OSINFO_INSTALL_SCRIPT_PROFILE_JEOS,
+                   OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_DISK |
+                   OSINFO_INSTALL_SCRIPT_INJECTION_METHOD_INITRD) == parent_jeos);
+
+    /* Scripts added after the index was built */
+    osinfo_os_add_install_script(parent, parent_desktop);
+    g_assert_true(osinfo_os_find_install_script_by_injection_method
+                  (os, OSINFO_INSTALL_SCRIPT_PROFILE_DESKTOP, 0) == parent_desktop);
+    g_assert_null(osinfo_os_find_install_script(os, OSINFO_INSTALL_SCRIPT_PROFILE_DESKTOP));
+
+    g_object_unref(jeos);
+    g_object_unref(parent_jeos);
+    g_object_unref(parent_desktop);
+    g_object_unref(os);
+    g_object_unref(parent);
+}
+
+
+
 static void
 test_loader(void)
 {
@@ -184,6 +338,71 @@ test_devices_filter(void)
 }
 
 
+static void
+test_devices_inheritance_changes(void)
+{
+    OsinfoOs *os1 = osinfo_os_new("os1");
+    OsinfoOs *os2 = osinfo_os_new("os2");
+    OsinfoDevice *dev1 = osinfo_device_new("e1000");
+    OsinfoDevice *dev2 = osinfo_device_new("sb16");
+    OsinfoDevice *dev3 = osinfo_device_new("rtl8139");
+    OsinfoFilter *filter = osinfo_filter_new();
+    OsinfoDeviceLink *link;
+    OsinfoDeviceList *devices;
+    OsinfoDeviceLinkList *devlinks;
+
+    osinfo_entity_add_param(OSINFO_ENTITY(dev1), "class", "network");
+    osinfo_entity_add_param(OSINFO_ENTITY(dev2), "class", "audio");
+    osinfo_entity_add_param(OSINFO_ENTITY(dev3), "class", "network");
+
+    osinfo_product_add_related(OSINFO_PRODUCT(os2),
+                               OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM,
+                               OSINFO_PRODUCT(os1));
+    osinfo_os_add_device(os1, dev1);
+    osinfo_os_add_device(os1, dev2);
+
+    devices = osinfo_os_get_all_devices(os2, NULL);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(devices)), ==, 2);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(devices), 0) == OSINFO_ENTITY(dev1));
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(devices), 1) == OSINFO_ENTITY(dev2));
+    g_object_unref(devices);
+
+    /* Devices and links added after the lookups were cached */
+    link = osinfo_os_add_device(os2, dev2);
+    osinfo_entity_set_param_boolean(OSINFO_ENTITY(link),
+                                    OSINFO_DEVICELINK_PROP_SUPPORTED, FALSE);
+    osinfo_os_add_device(os1, dev3);
+
+    devices = osinfo_os_get_all_devices(os2, NULL);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(devices)), ==, 2);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(devices), 0) == OSINFO_ENTITY(dev1));
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(devices), 1) == OSINFO_ENTITY(dev3));
+    g_object_unref(devices);
+
+    devlinks = osinfo_os_get_all_device_links(os2, NULL);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(devlinks)), ==, 2);
+    g_object_unref(devlinks);
+
+    devices = osinfo_os_get_all_devices(os1, NULL);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(devices)), ==, 3);
+    g_object_unref(devices);
+
+    osinfo_filter_add_constraint(filter, "class", "network");
+    devices = osinfo_os_get_all_devices(os2, filter);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(devices)), ==, 2);
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(devices), 0) == OSINFO_ENTITY(dev1));
+    g_assert_true(osinfo_list_get_nth(OSINFO_LIST(devices), 1) == OSINFO_ENTITY(dev3));
+    g_object_unref(devices);
+
+    g_object_unref(filter);
+    g_object_unref(dev1);
+    g_object_unref(dev2);
+    g_object_unref(dev3);
+    g_object_unref(os1);
+    g_object_unref(os2);
+}
+
+
 static void
 test_device_driver(void)
 {
@@ -271,6 +490,62 @@ test_device_driver_prioritized_priority(void)
 }
 
 
+static const gchar *
+get_device_driver_file(OsinfoDeviceDriver *driver)
+{
+    GList *files;
+    const gchar *file;
+
+    if (driver == NULL)
+        return NULL;
+
+    files = osinfo_device_driver_get_files(driver);
+    g_assert_nonnull(files);
+    file = files->data;
+    g_list_free(files);
+
+    return file;
+}
+
+
+static void
+test_device_driver_find(void)
+{
+    OsinfoLoader *loader = osinfo_loader_new();
+    OsinfoDb *db;
+    OsinfoOs *os;
+    OsinfoDevice *one;
+    OsinfoDevice *other = osinfo_device_new("http://libosinfo.org/test/device/other");
+    OsinfoDeviceDriverList *ddlist;
+    GError *error = NULL;
+
+    osinfo_loader_process_path(loader, SRCDIR "/tests/dbdata", &error);
+    g_assert_no_error(error);
+    db = g_object_ref(osinfo_loader_get_db(loader));
+    g_object_unref(loader);
+
+    os = osinfo_db_get_os(db, "http://libosinfo.org/test/os/drivers/devices");
+    one = osinfo_db_get_device(db, "http://libosinfo.org/test/device/one");
+    g_assert_nonnull(os);
+    g_assert_nonnull(one);
+
+    /* Highest priority wins, then the driver listed first */
+    g_assert_cmpstr(get_device_driver_file(osinfo_os_find_device_driver(os, one, "i686", TRUE)),
+                    ==, "pre-100-first");
+    g_assert_cmpstr(get_device_driver_file(osinfo_os_find_device_driver(os, one, "i686", FALSE)),
+                    ==, "post-default");
+    g_assert_null(osinfo_os_find_device_driver(os, one, "x86_64", TRUE));
+    g_assert_null(osinfo_os_find_device_driver(os, other, "i686", TRUE));
+
+    ddlist = osinfo_os_get_device_drivers_prioritized(os);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(ddlist)), ==, 2);
+    g_object_unref(ddlist);
+
+    g_object_unref(other);
+    g_object_unref(db);
+}
+
+
 static void test_resources_basic(void)
 {
     OsinfoLoader *loader = osinfo_loader_new();
@@ -649,6 +924,131 @@ test_resources_inheritance(void)
 }
 
 
+static void
+test_resources_inheritance_changes(void)
+{
+    OsinfoOs *os1 = osinfo_os_new("os1");
+    OsinfoOs *os2 = osinfo_os_new("os2");
+    OsinfoResources *res1 = osinfo_resources_new("res1", "x86_64");
+    OsinfoResources *res2 = osinfo_resources_new("res2", "x86_64");
+    OsinfoResourcesList *resourceslist;
+    OsinfoResources *resources;
+
+    osinfo_product_add_related(OSINFO_PRODUCT(os2),
+                               OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM,
+                               OSINFO_PRODUCT(os1));
+    osinfo_resources_set_inherit(res2, TRUE);
+    osinfo_resources_set_n_cpus(res2, 2);
+    osinfo_os_add_minimum_resources(os2, res2);
+
+    resourceslist = osinfo_os_get_minimum_resources(os2);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(resourceslist)), ==, 1);
+    resources = OSINFO_RESOURCES(osinfo_list_get_nth(OSINFO_LIST(resourceslist), 0));
+    g_assert_cmpint(osinfo_resources_get_n_cpus(resources), ==, 2);
+    g_assert_cmpint(osinfo_resources_get_ram(resources), ==, -1);
+    g_object_unref(resourceslist);
+
+    /* Resources added to the ancestor after os2 was resolved */
+    osinfo_resources_set_n_cpus(res1, 1);
+    osinfo_resources_set_ram(res1, 1024);
+    osinfo_os_add_minimum_resources(os1, res1);
+
+    resourceslist = osinfo_os_get_minimum_resources(os2);
+    resources = OSINFO_RESOURCES(osinfo_list_get_nth(OSINFO_LIST(resourceslist), 0));
+    g_assert_cmpint(osinfo_resources_get_n_cpus(resources), ==, 2);
+    g_assert_cmpint(osinfo_resources_get_ram(resources), ==, 1024);
+    g_assert_cmpint(osinfo_resources_get_storage(resources), ==, -1);
+    g_object_unref(resourceslist);
+
+    resourceslist = osinfo_os_get_recommended_resources(os2);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(resourceslist)), ==, 0);
+    g_object_unref(resourceslist);
+
+    g_object_unref(res1);
+    g_object_unref(res2);
+    g_object_unref(os1);
+    g_object_unref(os2);
+}
+
+
+static void
+test_resources_inheritance_reuse(void)
+{
+    OsinfoDb *db = osinfo_db_new();
+    OsinfoOs *os1 = osinfo_os_new("os1");
+    OsinfoOs *os2 = osinfo_os_new("os2");
+    OsinfoOs *os3 = osinfo_os_new("os3");
+    OsinfoResources *res1 = osinfo_resources_new("res1", "x86_64");
+    OsinfoResources *res2 = osinfo_resources_new("res2", "x86_64");
+    OsinfoResources *res3 = osinfo_resources_new("res3", "x86_64");
+    OsinfoResourcesList *resourceslist;
+    OsinfoResources *resources;
+
+    osinfo_db_add_os(db, os1);
+    osinfo_db_add_os(db, os2);
+    osinfo_db_add_os(db, os3);
+
+    osinfo_resources_set_n_cpus(res1, 1);
+    osinfo_resources_set_ram(res1, 1024);
+    osinfo_os_add_minimum_resources(os1, res1);
+    osinfo_product_add_related(OSINFO_PRODUCT(os2),
+                               OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM,
+                               OSINFO_PRODUCT(os1));
+    osinfo_resources_set_inherit(res2, TRUE);
+    osinfo_resources_set_n_cpus(res2, 2);
+    osinfo_os_add_minimum_resources(os2, res2);
+    osinfo_product_add_related(OSINFO_PRODUCT(os3),
+                               OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM,
+                               OSINFO_PRODUCT(os1));
+    osinfo_resources_set_inherit(res3, TRUE);
+    osinfo_os_add_minimum_resources(os3, res3);
+
+    resourceslist = osinfo_os_get_minimum_resources(os2);
+    resources = OSINFO_RESOURCES(osinfo_list_get_nth(OSINFO_LIST(resourceslist), 0));
+    g_assert_true(resources == res2);
+    g_assert_cmpint(osinfo_resources_get_n_cpus(resources), ==, 2);
+    g_assert_cmpint(osinfo_resources_get_ram(resources), ==, 1024);
+    g_object_unref(resourceslist);
+
+    /* Resolving another OS of the database leaves os2 as it was */
+    resourceslist = osinfo_os_get_minimum_resources(os3);
+    resources = OSINFO_RESOURCES(osinfo_list_get_nth(OSINFO_LIST(resourceslist), 0));
+    g_assert_cmpint(osinfo_resources_get_n_cpus(resources), ==, 1);
+    g_assert_cmpint(osinfo_resources_get_ram(resources), ==, 1024);
+    g_object_unref(resourceslist);
+
+    resourceslist = osinfo_os_get_minimum_resources(os2);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(resourceslist)), ==, 1);
+    resources = OSINFO_RESOURCES(osinfo_list_get_nth(OSINFO_LIST(resourceslist), 0));
+    g_assert_true(resources == res2);
+    g_assert_cmpint(osinfo_resources_get_n_cpus(resources), ==, 2);
+    g_assert_cmpint(osinfo_resources_get_ram(resources), ==, 1024);
+    g_assert_cmpint(osinfo_resources_get_storage(resources), ==, -1);
+    g_object_unref(resourceslist);
+
+    /* ...while changes to the ancestor still reach both */
+    osinfo_resources_set_storage(res1, 4096);
+
+    resourceslist = osinfo_os_get_minimum_resources(os2);
+    resources = OSINFO_RESOURCES(osinfo_list_get_nth(OSINFO_LIST(resourceslist), 0));
+    g_assert_cmpint(osinfo_resources_get_storage(resources), ==, 4096);
+    g_object_unref(resourceslist);
+
+    resourceslist = osinfo_os_get_minimum_resources(os3);
+    resources = OSINFO_RESOURCES(osinfo_list_get_nth(OSINFO_LIST(resourceslist), 0));
+    g_assert_cmpint(osinfo_resources_get_storage(resources), ==, 4096);
+    g_object_unref(resourceslist);
+
+    g_object_unref(res1);
+    g_object_unref(res2);
+    g_object_unref(res3);
+    g_object_unref(os1);
+    g_object_unref(os2);
+    g_object_unref(os3);
+    g_object_unref(db);
+}
+
+
 static void
 test_find_install_script(void)
 {
@@ -747,6 +1147,8 @@ check_firmwares(OsinfoDb *db,
 {
     OsinfoOs *os;
     OsinfoFirmwareList *firmwarelist;
+    OsinfoFirmwareList *complete_firmwarelist;
+    gint i, j;
 
     g_test_message("Testing \"%s\"", os_id);
 
@@ -756,6 +1158,29 @@ check_firmwares(OsinfoDb *db,
     firmwarelist = osinfo_os_get_firmware_list(os, NULL);
     g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(firmwarelist)), ==, list_len);
 
+    /* The supported firmwares are the ones of the list */
+    complete_firmwarelist = osinfo_os_get_complete_firmware_list(os, NULL);
+    for (i = 0; i < osinfo_list_get_length(OSINFO_LIST(complete_firmwarelist)); i++) {
+        OsinfoFirmware *firmware = OSINFO_FIRMWARE(
+                osinfo_list_get_nth(OSINFO_LIST(complete_firmwarelist), i));
+        const gchar *arch = osinfo_firmware_get_architecture(firmware);
+        const gchar *type = osinfo_firmware_get_firmware_type(firmware);
+        gboolean listed = FALSE;
+
+        for (j = 0; j < osinfo_list_get_length(OSINFO_LIST(firmwarelist)); j++) {
+            OsinfoFirmware *supported = OSINFO_FIRMWARE(
+                    osinfo_list_get_nth(OSINFO_LIST(firmwarelist), j));
+
+            if (g_str_equal(arch, osinfo_firmware_get_architecture(supported)) &&
+                g_str_equal(type, osinfo_firmware_get_firmware_type(supported)))
+                listed = TRUE;
+        }
+
+        g_assert_cmpint(osinfo_os_supports_firmware(os, arch, type), ==, listed);
+    }
+    g_assert_false(osinfo_os_supports_firmware(os, "s390x", "efi"));
+
+    g_object_unref(complete_firmwarelist);
     g_object_unref(firmwarelist);
 }
 
@@ -897,6 +1322,36 @@ test_firmwares_complete_list(void)
     g_object_unref(loader);
 }
 
+static void
+test_firmwares_support_changes(void)
+{
+    OsinfoOs *os1 = osinfo_os_new("os1");
+    OsinfoOs *os2 = osinfo_os_new("os2");
+    OsinfoFirmware *efi = osinfo_firmware_new("efi1", "x86_64", "efi");
+    OsinfoFirmware *no_efi = osinfo_firmware_new("efi2", "x86_64", "efi");
+
+    osinfo_product_add_related(OSINFO_PRODUCT(os2),
+                               OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM,
+                               OSINFO_PRODUCT(os1));
+    osinfo_os_add_firmware(os1, efi);
+
+    g_assert_true(osinfo_os_supports_firmware(os2, "x86_64", "efi"));
+    g_assert_false(osinfo_os_supports_firmware(os2, "aarch64", "efi"));
+
+    /* Firmware removed after the support was resolved */
+    osinfo_entity_set_param_boolean(OSINFO_ENTITY(no_efi),
+                                    OSINFO_FIRMWARE_PROP_SUPPORTED, FALSE);
+    osinfo_os_add_firmware(os2, no_efi);
+
+    g_assert_false(osinfo_os_supports_firmware(os2, "x86_64", "efi"));
+    g_assert_true(osinfo_os_supports_firmware(os1, "x86_64", "efi"));
+
+    g_object_unref(efi);
+    g_object_unref(no_efi);
+    g_object_unref(os1);
+    g_object_unref(os2);
+}
+
 static void
 test_firmwares_complete_list_inheritance(void)
 {
@@ -1032,24 +1487,34 @@ main(int argc, char *argv[])
 
     g_test_add_func("/os/basic", test_basic);
     g_test_add_func("/os/loader", test_loader);
+    g_test_add_func("/os/related_traversal", test_related_traversal);
     g_test_add_func("/os/devices", test_devices);
     g_test_add_func("/os/devices_filter", test_devices_filter);
+    g_test_add_func("/os/devices/inheritance/changes",
+                    test_devices_inheritance_changes);
     g_test_add_func("/os/device_driver", test_device_driver);
     g_test_add_func("/os/device_driver/priority", test_device_driver_priority);
     g_test_add_func("/os/device_driver/prioritized_priority",
                     test_device_driver_prioritized_priority);
+    g_test_add_func("/os/device_driver/find", test_device_driver_find);
+    g_test_add_func("/os/install_script/lookup", test_install_script_lookup);
     g_test_add_func("/os/devices/inheritance/basic",
                     test_devices_inheritance_basic);
     g_test_add_func("/os/devices/inheritance/removal",
                     test_devices_inheritance_removal);
     g_test_add_func("/os/resources/basic", test_resources_basic);
     g_test_add_func("/os/resources/inheritance", test_resources_inheritance);
+    g_test_add_func("/os/resources/inheritance/changes",
+                    test_resources_inheritance_changes);
+    g_test_add_func("/os/resources/inheritance/reuse",
+                    test_resources_inheritance_reuse);
     g_test_add_func("/os/find_install_script", test_find_install_script);
     g_test_add_func("/os/mulitple_short_ids", test_multiple_short_ids);
     g_test_add_func("/os/kernel_url_arg", test_kernel_url_arg);
     g_test_add_func("/os/firmwares/inheritance", test_firmwares_inheritance);
     g_test_add_func("/os/firmwares/complete_list", test_firmwares_complete_list);
     g_test_add_func("/os/firmwares/complete_list/inheritance", test_firmwares_complete_list_inheritance);
+    g_test_add_func("/os/firmwares/support_changes", test_firmwares_support_changes);
     g_test_add_func("/os/cloud_image_username_arg", test_cloud_image_username_arg);
 
     /* Upfront so we don't confuse valgrind */
@@ -112,6 +112,81 @@ test_devices_filter(void)
     g_object_unref(hv);
 }
 
+static gboolean
+list_has_device(OsinfoDeviceList *devices, OsinfoDevice *dev)
+{
+    return osinfo_list_find_by_id(OSINFO_LIST(devices),
+                                  osinfo_entity_get_id(OSINFO_ENTITY(dev))) ==
+        OSINFO_ENTITY(dev);
+}
+
+
+static void
+test_all_devices(void)
+{
+    OsinfoPlatform *hv = osinfo_platform_new("awesome");
+    OsinfoPlatform *parent = osinfo_platform_new("parent");
+    OsinfoPlatform *older = osinfo_platform_new("older");
+    OsinfoDevice *dev1 = osinfo_device_new("e1000");
+    OsinfoDevice *dev2 = osinfo_device_new("sb16");
+    OsinfoDevice *dev3 = osinfo_device_new("rtl8139");
+    OsinfoDevice *dev4 = osinfo_device_new("virtio-net");
+    OsinfoFilter *filter = osinfo_filter_new();
+    OsinfoDeviceList *devices;
+
+    osinfo_entity_add_param(OSINFO_ENTITY(dev1), "class", "network");
+    osinfo_entity_add_param(OSINFO_ENTITY(dev2), "class", "audio");
+    osinfo_entity_add_param(OSINFO_ENTITY(dev3), "class", "network");
+    osinfo_entity_add_param(OSINFO_ENTITY(dev4), "class", "network");
+
+    osinfo_platform_add_device(hv, dev1);
+    osinfo_platform_add_device(parent, dev1);
+    osinfo_platform_add_device(parent, dev2);
+    osinfo_product_add_related(OSINFO_PRODUCT(hv),
+                               OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM,
+                               OSINFO_PRODUCT(parent));
+    osinfo_product_add_related(OSINFO_PRODUCT(hv),
+                               OSINFO_PRODUCT_RELATIONSHIP_UPGRADES,
+                               OSINFO_PRODUCT(older));
+
+    /* Devices of several platforms are listed once */
+    devices = osinfo_platform_get_all_devices(hv, NULL);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(devices)), ==, 2);
+    g_assert_true(list_has_device(devices, dev1));
+    g_assert_true(list_has_device(devices, dev2));
+    g_object_unref(devices);
+
+    osinfo_filter_add_constraint(filter, "class", "network");
+    devices = osinfo_platform_get_all_devices(hv, filter);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(devices)), ==, 1);
+    g_assert_true(list_has_device(devices, dev1));
+    g_object_unref(devices);
+
+    /* Devices added to inherited platforms after the first lookup */
+    osinfo_platform_add_device(older, dev3);
+    osinfo_platform_add_device(parent, dev4);
+    devices = osinfo_platform_get_all_devices(hv, filter);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(devices)), ==, 3);
+    g_assert_true(list_has_device(devices, dev1));
+    g_assert_true(list_has_device(devices, dev3));
+    g_assert_true(list_has_device(devices, dev4));
+    g_object_unref(devices);
+
+    /* The inherited devices are not devices of the platform itself */
+    devices = osinfo_platform_get_devices(hv, NULL);
+    g_assert_cmpint(osinfo_list_get_length(OSINFO_LIST(devices)), ==, 1);
+    g_object_unref(devices);
+
+    g_object_unref(filter);
+    g_object_unref(dev1);
+    g_object_unref(dev2);
+    g_object_unref(dev3);
+    g_object_unref(dev4);
+    g_object_unref(older);
+    g_object_unref(parent);
+    g_object_unref(hv);
+}
+
 
 
 int
@@ -122,6 +197,7 @@ main(int argc, char *argv[])
     g_test_add_func("/platform/basic", test_basic);
     g_test_add_func("/platform/devices", test_devices);
     g_test_add_func("/platform/devices_filter", test_devices_filter);
+    g_test_add_func("/platform/all_devices", test_all_devices);
 
     /* Upfront so we don't confuse valgrind */
     osinfo_platform_get_type();
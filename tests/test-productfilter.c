@@ -217,6 +217,41 @@ test_productfilter_combine(void)
 }
 
 
+static void
+test_productfilter_compile(void)
+{
+    OsinfoProductFilter *productfilter = osinfo_productfilter_new();
+    OsinfoProduct *product1 = osinfo_dummy_new("hot");
+    OsinfoProduct *product2 = osinfo_dummy_new("or");
+    OsinfoProduct *product3 = osinfo_dummy_new("not");
+
+    osinfo_product_add_related(product1, OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM, product2);
+    osinfo_product_add_related(product1, OSINFO_PRODUCT_RELATIONSHIP_UPGRADES, product3);
+
+    osinfo_productfilter_add_product_constraint(productfilter, OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM, product2);
+    osinfo_productfilter_add_product_constraint(productfilter, OSINFO_PRODUCT_RELATIONSHIP_DERIVES_FROM, product2);
+    osinfo_filter_compile(OSINFO_FILTER(productfilter));
+    g_assert_true(osinfo_filter_matches(OSINFO_FILTER(productfilter), OSINFO_ENTITY(product1)));
+    g_assert_false(osinfo_filter_matches(OSINFO_FILTER(productfilter), OSINFO_ENTITY(product3)));
+
+    /* Every relationship constraint must match */
+    osinfo_productfilter_add_product_constraint(productfilter, OSINFO_PRODUCT_RELATIONSHIP_CLONES, product3);
+    g_assert_false(osinfo_filter_matches(OSINFO_FILTER(productfilter), OSINFO_ENTITY(product1)));
+
+    /* Relationships added after compiling are seen */
+    osinfo_product_add_related(product1, OSINFO_PRODUCT_RELATIONSHIP_CLONES, product3);
+    g_assert_true(osinfo_filter_matches(OSINFO_FILTER(productfilter), OSINFO_ENTITY(product1)));
+
+    osinfo_productfilter_clear_product_constraints(productfilter);
+    g_assert_true(osinfo_filter_matches(OSINFO_FILTER(productfilter), OSINFO_ENTITY(product3)));
+
+    g_object_unref(product1);
+    g_object_unref(product2);
+    g_object_unref(product3);
+    g_object_unref(productfilter);
+}
+
+
 int
 main(int argc, char *argv[])
 {
@@ -226,6 +261,7 @@ main(int argc, char *argv[])
     g_test_add_func("/productfilter/productfilter_single", test_productfilter_single);
     g_test_add_func("/productfilter/productfilter_multi", test_productfilter_multi);
     g_test_add_func("/productfilter/productfilter_combine", test_productfilter_combine);
+    g_test_add_func("/productfilter/productfilter_compile", test_productfilter_compile);
 
     /* Upfront so we don't confuse valgrind */
     osinfo_entity_get_type();
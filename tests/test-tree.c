@@ -16,6 +16,7 @@
  */
 
 #include <osinfo/osinfo.h>
+#include <string.h>
 
 
 static void
@@ -185,6 +186,139 @@ test_matching(void)
     g_assert(!osinfo_tree_matches(unknown, reference4));
 }
 
+#define TREEINFO_ETAG "\"treeinfo-1\""
+
+typedef struct {
+    gint requests;
+    gint not_modified;
+} TreeinfoServer;
+
+static gboolean
+treeinfo_server_run(GThreadedSocketService *service,
+                    GSocketConnection *connection,
+                    GObject *source_object,
+                    gpointer user_data)
+{
+    TreeinfoServer *server = user_data;
+    GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(connection));
+    GOutputStream *out = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+    g_autoptr(GDataInputStream) data = g_data_input_stream_new(in);
+    g_autofree gchar *response = NULL;
+    gboolean matches = FALSE;
+    gchar *line;
+    const gchar *treeinfo = "[general]\n"
+                            "arch = x86_64\n"
+                            "family = Tree\n"
+                            "version = unknown\n"
+                            "[images-x86_64]\n"
+                            "initrd = images/pxeboot/initrd.img\n"
+                            "kernel = images/pxeboot/vmlinuz\n";
+
+    /* Request line and headers, up to the first empty line */
+    while ((line = g_data_input_stream_read_line(data, NULL, NULL, NULL)) != NULL) {
+        g_strchomp(line);
+        if (*line == '\0') {
+            g_free(line);
+            break;
+        }
+
+        if (g_ascii_strncasecmp(line, "If-None-Match:", strlen("If-None-Match:")) == 0 &&
+            strstr(line, TREEINFO_ETAG) != NULL)
+            matches = TRUE;
+        g_free(line);
+    }
+
+    g_atomic_int_inc(&server->requests);
+
+    if (matches) {
+        g_atomic_int_inc(&server->not_modified);
+        response = g_strdup("HTTP/1.1 304 Not Modified\r\n"
+                            "ETag: " TREEINFO_ETAG "\r\n"
+                            "Connection: close\r\n"
+                            "\r\n");
+    } else {
+        response = g_strdup_printf("HTTP/1.1 200 OK\r\n"
+                                   "ETag: " TREEINFO_ETAG "\r\n"
+                                   "Content-Length: %zu\r\n"
+                                   "Connection: close\r\n"
+                                   "\r\n"
+                                   "%s",
+                                   strlen(treeinfo),
+                                   treeinfo);
+    }
+
+    g_output_stream_write_all(out, response, strlen(response), NULL, NULL, NULL);
+
+    return TRUE;
+}
+
+static OsinfoTree *
+test_create_tree_from_server(const gchar *location, guint flags)
+{
+    OsinfoTree *tree;
+    GError *error = NULL;
+
+    tree = osinfo_tree_create_from_location_with_flags(location, NULL, flags, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(tree);
+
+    g_assert_cmpstr(osinfo_tree_get_url(tree), ==, location);
+    g_assert_cmpstr(osinfo_tree_get_treeinfo_family(tree), ==, "Tree");
+    g_assert_cmpstr(osinfo_tree_get_kernel_path(tree), ==, "images/pxeboot/vmlinuz");
+    g_assert_cmpstr(osinfo_tree_get_initrd_path(tree), ==, "images/pxeboot/initrd.img");
+
+    return tree;
+}
+
+static void
+test_create_from_location_cache(void)
+{
+    TreeinfoServer server = { 0, 0 };
+    GSocketService *service;
+    g_autofree gchar *location = NULL;
+    OsinfoTree *tree;
+    OsinfoTree *cached;
+    guint16 port;
+    GError *error = NULL;
+
+    service = g_threaded_socket_service_new(1);
+    port = g_socket_listener_add_any_inet_port(G_SOCKET_LISTENER(service), NULL, &error);
+    g_assert_no_error(error);
+    g_signal_connect(service, "run", G_CALLBACK(treeinfo_server_run), &server);
+    g_socket_service_start(service);
+
+    location = g_strdup_printf("http://127.0.0.1:%u/tree", port);
+
+    tree = test_create_tree_from_server(location, OSINFO_TREE_DETECT_USE_CACHE);
+    g_assert_cmpint(g_atomic_int_get(&server.requests), ==, 1);
+    g_assert_cmpint(g_atomic_int_get(&server.not_modified), ==, 0);
+
+    /* Revalidated with the ETag, answered with a 304 */
+    cached = test_create_tree_from_server(location, OSINFO_TREE_DETECT_USE_CACHE);
+    g_assert_cmpint(g_atomic_int_get(&server.requests), ==, 2);
+    g_assert_cmpint(g_atomic_int_get(&server.not_modified), ==, 1);
+    g_assert_true(cached != tree);
+    g_object_unref(cached);
+    g_object_unref(tree);
+
+    /* The cache is neither used nor revalidated unless asked for */
+    tree = test_create_tree_from_server(location, 0);
+    g_assert_cmpint(g_atomic_int_get(&server.requests), ==, 3);
+    g_assert_cmpint(g_atomic_int_get(&server.not_modified), ==, 1);
+    g_object_unref(tree);
+
+    osinfo_tree_clear_cache();
+    tree = test_create_tree_from_server(location, OSINFO_TREE_DETECT_USE_CACHE);
+    g_assert_cmpint(g_atomic_int_get(&server.requests), ==, 4);
+    g_assert_cmpint(g_atomic_int_get(&server.not_modified), ==, 1);
+    g_object_unref(tree);
+
+    osinfo_tree_clear_cache();
+    g_socket_service_stop(service);
+    g_socket_listener_close(G_SOCKET_LISTENER(service));
+    g_object_unref(service);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -194,6 +328,7 @@ main(int argc, char *argv[])
     g_test_add_func("/tree/os-variants", test_os_variants);
     g_test_add_func("/tree/create-from-treeinfo", test_create_from_treeinfo);
     g_test_add_func("/tree/matching", test_matching);
+    g_test_add_func("/tree/create-from-location-cache", test_create_from_location_cache);
 
     /* Upfront so we don't confuse valgrind */
     osinfo_tree_get_type();
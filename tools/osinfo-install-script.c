@@ -166,35 +166,14 @@ static GOptionEntry entries[] =
 static OsinfoOs *find_os(OsinfoDb *db,
                          const char *idoruri)
 {
-    OsinfoOsList *oslist;
-    OsinfoOsList *filteredList;
-    OsinfoFilter *filter;
     OsinfoOs *os;
 
     os = osinfo_db_get_os(db, idoruri);
 
-    if (os)
-        return g_object_ref(os);
-
-    oslist = osinfo_db_get_os_list(db);
-    filter = osinfo_filter_new();
-    osinfo_filter_add_constraint(filter,
-                                 OSINFO_PRODUCT_PROP_SHORT_ID,
-                                 idoruri);
-
-    filteredList = OSINFO_OSLIST(osinfo_list_new_filtered(OSINFO_LIST(oslist),
-                                                          filter));
-
-    if (osinfo_list_get_length(OSINFO_LIST(filteredList)) > 0) {
-        os = OSINFO_OS(osinfo_list_get_nth(OSINFO_LIST(filteredList), 0));
-        g_object_ref(os);
-    }
-
-    g_object_unref(oslist);
-    g_object_unref(filteredList);
-    g_object_unref(filter);
+    if (!os)
+        os = osinfo_db_get_os_by_short_id(db, idoruri);
 
-    return os;
+    return os ? g_object_ref(os) : NULL;
 }
 
 
@@ -365,6 +365,7 @@ gint main(gint argc, gchar **argv)
     gsize i;
     const gchar *sortKey = NULL;
     const gchar *fields = NULL;
+    const gchar *expression = NULL;
     struct OsinfoType types[] = {
         { "os",
           (osinfo_list_func)osinfo_db_get_os_list,
@@ -396,6 +397,8 @@ gint main(gint argc, gchar **argv)
           _("Sort column"), NULL },
         { "fields", 'f', 0, G_OPTION_ARG_STRING, &fields,
           _("Display fields"), NULL },
+        { "expression", 'e', 0, G_OPTION_ARG_STRING, &expression,
+          _("Filter expression"), NULL },
         { NULL, 0, 0, 0, NULL, NULL, NULL }
     };
 
@@ -453,6 +456,23 @@ gint main(gint argc, gchar **argv)
         goto error;
     }
 
+    if (expression) {
+        OsinfoExpressionFilter *exprfilter;
+        OsinfoFilter *combined;
+
+        exprfilter = osinfo_expressionfilter_new_from_string(expression, &error);
+        if (!exprfilter) {
+            g_printerr(_("Unable to parse expression: %s\n"), error->message);
+            goto error;
+        }
+
+        combined = OSINFO_FILTER(osinfo_expressionfilter_new_and(filter,
+                                                                 OSINFO_FILTER(exprfilter)));
+        g_object_unref(exprfilter);
+        g_object_unref(filter);
+        filter = combined;
+    }
+
     if (!toggle_fields(labels, fields, &error)) {
         g_printerr(_("Unable to set field visibility: %s\n"), error->message);
         goto error;
@@ -534,6 +554,18 @@ command line argument:
    fedora2              | 2
    ...
 
+Conditions only test for equality. More elaborate queries can be given
+as an expression with the B<--expression> command line argument, which
+is combined with the conditions:
+
+  # List Fedora releases 30 to 32
+  $ osinfo-query --expression='version>=30 and version<33' \
+        os vendor="Fedora Project"
+   Short ID             | Name          ...
+  ----------------------+--------------
+   fedora30             | Fedora 30     ...
+   fedora31             | Fedora 31     ...
+   fedora32             | Fedora 32     ...
 
 =head1 OPTIONS
 
@@ -547,6 +579,16 @@ Set the data sorting key. Defaults sorting the first column
 
 Set the visibility of properties in output
 
+=item B<-e EXPRESSION>, B<--expression EXPRESSION>
+
+Only list the entities matching B<EXPRESSION>. An expression compares
+properties to values with the C<=>, C<!=>, C<^=> (prefix), C<~>
+(regular expression), C<E<lt>>, C<E<lt>=>, C<E<gt>> and C<E<gt>=>
+operators, the latter comparing numbers, versions and dates naturally.
+Comparisons are combined with C<and>, C<or> and C<not>, and grouped
+with parentheses. Values containing spaces or parentheses must be
+quoted.
+
 =back
 
 =head1 PROPERTY NAMES